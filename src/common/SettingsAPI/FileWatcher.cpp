@@ -1,68 +1,519 @@
 #include "pch.h"
 #include "FileWatcher.h"
 
-std::optional<FILETIME> FileWatcher::MyFileTime()
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace
 {
-    HANDLE hFile = CreateFileW(m_path.c_str(), FILE_READ_ATTRIBUTES, FILE_SHARE_DELETE | FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, 0, nullptr);
-    std::optional<FILETIME> result;
-    if (hFile != INVALID_HANDLE_VALUE)
+    // Changes closer together than this are reported once
+    const DWORD c_debouncePeriod = 100;
+
+    const DWORD c_notifyFilter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE;
+    const DWORD c_notifyBufferSize = 16 * 1024;
+
+    std::optional<FILETIME> LastWriteTime(const std::wstring& path)
     {
-        FILETIME lastWrite;
-        if (GetFileTime(hFile, nullptr, nullptr, &lastWrite))
+        HANDLE hFile = CreateFileW(path.c_str(), FILE_READ_ATTRIBUTES, FILE_SHARE_DELETE | FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, 0, nullptr);
+        std::optional<FILETIME> result;
+        if (hFile != INVALID_HANDLE_VALUE)
         {
-            result = lastWrite;
+            FILETIME lastWrite;
+            if (GetFileTime(hFile, nullptr, nullptr, &lastWrite))
+            {
+                result = lastWrite;
+            }
+
+            CloseHandle(hFile);
         }
 
-        CloseHandle(hFile);
+        return result;
     }
 
-    return result;
+    std::wstring ToUpper(std::wstring text)
+    {
+        CharUpperBuffW(text.data(), static_cast<DWORD>(text.size()));
+        return text;
+    }
+}
+
+struct FileWatcherEntry
+{
+    std::wstring path;
+    std::wstring directoryPath;
+    // Uppercased, notifications are matched without regard to case like the file system does
+    std::wstring fileName;
+    std::function<void()> callback;
+    DWORD refreshPeriod;
+    // Guarded by the mutex of the thread, since AcknowledgeWrite updates it from other threads
+    std::optional<FILETIME> lastWrite;
+    // Tick count at which the file is checked next, 0 if no check is due. Only used by the watcher thread.
+    ULONGLONG checkAt = 0;
+};
+
+class FileWatcherThread
+{
+public:
+    FileWatcherThread();
+    ~FileWatcherThread();
+
+    static std::shared_ptr<FileWatcherThread> Acquire();
+
+    void Add(FileWatcherEntry* entry);
+    // Returns once the callback of entry can't be called anymore. Called from a callback, entry is removed
+    // right away since the thread can't apply the command while it waits.
+    void Remove(FileWatcherEntry* entry);
+    void Acknowledge(FileWatcherEntry* entry);
+
+private:
+    struct Directory
+    {
+        std::wstring path;
+        HANDLE handle = INVALID_HANDLE_VALUE;
+        OVERLAPPED overlapped{};
+        std::vector<DWORD> buffer;
+        std::vector<FileWatcherEntry*> entries;
+    };
+
+    void Run();
+    bool ApplyCommands();
+    void RemoveEntry(FileWatcherEntry* entry);
+    void StopWatchingAll();
+    bool StartWatching(Directory& directory);
+    void StopWatching(Directory& directory);
+    bool ReadChanges(Directory& directory);
+    void OnDirectoryChanged(Directory& directory);
+    // Returns false if a callback destroyed this object, which must not be touched anymore then
+    bool CheckDueEntries(const bool& destroyed);
+    bool HasChanged(FileWatcherEntry& entry);
+
+    std::mutex m_mutex;
+    std::condition_variable m_commandsApplied;
+    std::vector<FileWatcherEntry*> m_added;
+    std::vector<FileWatcherEntry*> m_removed;
+    unsigned long long m_requestedCommands = 0;
+    unsigned long long m_appliedCommands = 0;
+    bool m_stop = false;
+    HANDLE m_wakeEvent;
+    // Keyed by the uppercased path, only used by the watcher thread
+    std::map<std::wstring, Directory> m_directories;
+    // Entries whose callbacks are being called, an entry removed by one of them is replaced by nullptr
+    std::vector<FileWatcherEntry*> m_changed;
+    // Local to Run, set if the last watcher is destroyed by a callback
+    bool* m_destroyed = nullptr;
+    std::thread m_thread;
+};
+
+FileWatcherThread::FileWatcherThread()
+{
+    m_wakeEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    if (m_wakeEvent)
+    {
+        m_thread = std::thread([this]() { Run(); });
+    }
 }
 
-void FileWatcher::Run()
+FileWatcherThread::~FileWatcherThread()
 {
-    while (1)
+    if (m_wakeEvent)
     {
-        auto lastWrite = MyFileTime();
-        if (!m_lastWrite.has_value())
+        if (std::this_thread::get_id() == m_thread.get_id())
         {
-            m_lastWrite = lastWrite;
+            // The last watcher was destroyed by a callback. The thread can't join itself, it returns as soon as
+            // the callback does.
+            *m_destroyed = true;
+            StopWatchingAll();
+            m_thread.detach();
         }
-        else if (lastWrite.has_value())
+        else
         {
-            if (m_lastWrite->dwHighDateTime != lastWrite->dwHighDateTime ||
-                m_lastWrite->dwLowDateTime != lastWrite->dwLowDateTime)
             {
-                m_lastWrite = lastWrite;
-                m_callback();
+                std::lock_guard lock(m_mutex);
+                m_stop = true;
             }
+            SetEvent(m_wakeEvent);
+            m_thread.join();
         }
+        CloseHandle(m_wakeEvent);
+    }
+}
+
+std::shared_ptr<FileWatcherThread> FileWatcherThread::Acquire()
+{
+    // The thread lives as long as a watcher uses it, and is joined by the destructor of the last one like the
+    // thread each watcher used to have
+    static std::mutex mutex;
+    static std::weak_ptr<FileWatcherThread> current;
+
+    std::lock_guard lock(mutex);
+    auto thread = current.lock();
+    if (!thread)
+    {
+        thread = std::make_shared<FileWatcherThread>();
+        current = thread;
+    }
+    return thread;
+}
 
-        if (WaitForSingleObject(m_abortEvent, m_refreshPeriod) == WAIT_OBJECT_0)
+void FileWatcherThread::Add(FileWatcherEntry* entry)
+{
+    if (m_wakeEvent)
+    {
+        std::lock_guard lock(m_mutex);
+        m_added.push_back(entry);
+        m_requestedCommands++;
+        SetEvent(m_wakeEvent);
+    }
+}
+
+void FileWatcherThread::Remove(FileWatcherEntry* entry)
+{
+    if (m_wakeEvent)
+    {
+        if (std::this_thread::get_id() == m_thread.get_id())
         {
+            {
+                std::lock_guard lock(m_mutex);
+                m_added.erase(std::remove(m_added.begin(), m_added.end(), entry), m_added.end());
+            }
+            std::replace(m_changed.begin(), m_changed.end(), entry, static_cast<FileWatcherEntry*>(nullptr));
+            RemoveEntry(entry);
             return;
         }
+
+        std::unique_lock lock(m_mutex);
+        m_removed.push_back(entry);
+        const auto command = ++m_requestedCommands;
+        SetEvent(m_wakeEvent);
+        // The thread is already gone if the process is exiting
+        while (!m_commandsApplied.wait_for(lock, std::chrono::milliseconds(100), [&] { return m_appliedCommands >= command; }))
+        {
+            if (WaitForSingleObject(m_thread.native_handle(), 0) == WAIT_OBJECT_0)
+            {
+                break;
+            }
+        }
     }
 }
 
-FileWatcher::FileWatcher(const std::wstring& path, std::function<void()> callback, DWORD refreshPeriod) :
-    m_refreshPeriod(refreshPeriod),
-    m_path(path),
-    m_callback(callback)
+void FileWatcherThread::Acknowledge(FileWatcherEntry* entry)
 {
-    m_abortEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
-    if (m_abortEvent)
+    auto lastWrite = LastWriteTime(entry->path);
+    std::lock_guard lock(m_mutex);
+    entry->lastWrite = lastWrite;
+}
+
+void FileWatcherThread::Run()
+{
+    bool destroyed = false;
+    m_destroyed = &destroyed;
+
+    std::vector<HANDLE> handles;
+    std::vector<Directory*> watchedDirectories;
+    while (ApplyCommands())
     {
-        m_thread = std::thread([this]() { Run(); });
+        handles.assign(1, m_wakeEvent);
+        watchedDirectories.clear();
+        ULONGLONG nextCheck = ULLONG_MAX;
+        for (auto& [key, directory] : m_directories)
+        {
+            if (directory.handle != INVALID_HANDLE_VALUE)
+            {
+                handles.push_back(directory.overlapped.hEvent);
+                watchedDirectories.push_back(&directory);
+            }
+
+            for (const auto* entry : directory.entries)
+            {
+                if (entry->checkAt)
+                {
+                    nextCheck = std::min(nextCheck, entry->checkAt);
+                }
+            }
+        }
+
+        // Without pending checks there is nothing to do until a notification or a command comes in
+        const ULONGLONG now = GetTickCount64();
+        const DWORD timeout = nextCheck == ULLONG_MAX ? INFINITE : static_cast<DWORD>(nextCheck > now ? nextCheck - now : 0);
+        const DWORD result = WaitForMultipleObjects(static_cast<DWORD>(handles.size()), handles.data(), FALSE, timeout);
+        if (result > WAIT_OBJECT_0 && result < WAIT_OBJECT_0 + handles.size())
+        {
+            OnDirectoryChanged(*watchedDirectories[result - WAIT_OBJECT_0 - 1]);
+        }
+
+        if (!CheckDueEntries(destroyed))
+        {
+            return;
+        }
     }
+
+    StopWatchingAll();
 }
 
-FileWatcher::~FileWatcher()
+bool FileWatcherThread::ApplyCommands()
+{
+    std::vector<FileWatcherEntry*> added;
+    std::vector<FileWatcherEntry*> removed;
+    unsigned long long commands;
+    bool stop;
+    {
+        std::lock_guard lock(m_mutex);
+        added.swap(m_added);
+        removed.swap(m_removed);
+        commands = m_requestedCommands;
+        stop = m_stop;
+    }
+
+    for (auto* entry : added)
+    {
+        auto [it, inserted] = m_directories.try_emplace(ToUpper(entry->directoryPath));
+        Directory& directory = it->second;
+        if (inserted)
+        {
+            directory.path = entry->directoryPath;
+            directory.overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+            StartWatching(directory);
+        }
+
+        directory.entries.push_back(entry);
+        if (directory.handle == INVALID_HANDLE_VALUE)
+        {
+            entry->checkAt = GetTickCount64() + entry->refreshPeriod;
+        }
+    }
+
+    for (auto* entry : removed)
+    {
+        RemoveEntry(entry);
+    }
+
+    {
+        std::lock_guard lock(m_mutex);
+        m_appliedCommands = commands;
+    }
+    m_commandsApplied.notify_all();
+
+    return !stop;
+}
+
+void FileWatcherThread::RemoveEntry(FileWatcherEntry* entry)
 {
-    if (m_abortEvent)
+    auto it = m_directories.find(ToUpper(entry->directoryPath));
+    if (it == m_directories.end())
     {
-        SetEvent(m_abortEvent);
-        m_thread.join();
-        CloseHandle(m_abortEvent);
+        return;
     }
+
+    auto& entries = it->second.entries;
+    entries.erase(std::remove(entries.begin(), entries.end(), entry), entries.end());
+    if (entries.empty())
+    {
+        StopWatching(it->second);
+        CloseHandle(it->second.overlapped.hEvent);
+        m_directories.erase(it);
+    }
+}
+
+void FileWatcherThread::StopWatchingAll()
+{
+    for (auto& [key, directory] : m_directories)
+    {
+        StopWatching(directory);
+        CloseHandle(directory.overlapped.hEvent);
+    }
+    m_directories.clear();
+}
+
+bool FileWatcherThread::StartWatching(Directory& directory)
+{
+    // One wait handle is the wake event, directories beyond the limit are polled
+    size_t watchedCount = 0;
+    for (const auto& [key, other] : m_directories)
+    {
+        watchedCount += other.handle != INVALID_HANDLE_VALUE;
+    }
+    if (!directory.overlapped.hEvent || watchedCount >= MAXIMUM_WAIT_OBJECTS - 1)
+    {
+        return false;
+    }
+
+    directory.handle = CreateFileW(directory.path.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_DELETE | FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+    if (directory.handle == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    directory.buffer.resize(c_notifyBufferSize / sizeof(DWORD));
+    if (!ReadChanges(directory))
+    {
+        CloseHandle(directory.handle);
+        directory.handle = INVALID_HANDLE_VALUE;
+        return false;
+    }
+    return true;
+}
+
+void FileWatcherThread::StopWatching(Directory& directory)
+{
+    if (directory.handle != INVALID_HANDLE_VALUE)
+    {
+        DWORD bytes;
+        CancelIoEx(directory.handle, &directory.overlapped);
+        GetOverlappedResult(directory.handle, &directory.overlapped, &bytes, TRUE);
+        CloseHandle(directory.handle);
+        directory.handle = INVALID_HANDLE_VALUE;
+    }
+}
+
+bool FileWatcherThread::ReadChanges(Directory& directory)
+{
+    ResetEvent(directory.overlapped.hEvent);
+    return ReadDirectoryChangesW(directory.handle, directory.buffer.data(), static_cast<DWORD>(directory.buffer.size() * sizeof(DWORD)), FALSE, c_notifyFilter, nullptr, &directory.overlapped, nullptr);
+}
+
+void FileWatcherThread::OnDirectoryChanged(Directory& directory)
+{
+    const ULONGLONG checkAt = GetTickCount64() + c_debouncePeriod;
+    DWORD bytes = 0;
+    if (!GetOverlappedResult(directory.handle, &directory.overlapped, &bytes, FALSE))
+    {
+        // The directory went away, its files are polled until it can be watched again
+        StopWatching(directory);
+        for (auto* entry : directory.entries)
+        {
+            entry->checkAt = checkAt;
+        }
+        return;
+    }
+
+    if (bytes == 0)
+    {
+        // Too many changes for the buffer, any of the files may have changed
+        for (auto* entry : directory.entries)
+        {
+            entry->checkAt = checkAt;
+        }
+    }
+    else
+    {
+        const auto* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(directory.buffer.data());
+        while (true)
+        {
+            const std::wstring fileName = ToUpper(std::wstring(info->FileName, info->FileNameLength / sizeof(WCHAR)));
+            for (auto* entry : directory.entries)
+            {
+                if (entry->fileName == fileName)
+                {
+                    entry->checkAt = checkAt;
+                }
+            }
+
+            if (!info->NextEntryOffset)
+            {
+                break;
+            }
+            info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(reinterpret_cast<const BYTE*>(info) + info->NextEntryOffset);
+        }
+    }
+
+    if (!ReadChanges(directory))
+    {
+        StopWatching(directory);
+    }
+}
+
+bool FileWatcherThread::CheckDueEntries(const bool& destroyed)
+{
+    const ULONGLONG now = GetTickCount64();
+    for (auto& [key, directory] : m_directories)
+    {
+        for (auto* entry : directory.entries)
+        {
+            if (!entry->checkAt || entry->checkAt > now)
+            {
+                continue;
+            }
+
+            entry->checkAt = 0;
+            if (directory.handle == INVALID_HANDLE_VALUE && !StartWatching(directory))
+            {
+                entry->checkAt = now + entry->refreshPeriod;
+            }
+
+            if (HasChanged(*entry))
+            {
+                m_changed.push_back(entry);
+            }
+        }
+    }
+
+    // The callbacks are called once the directories aren't iterated anymore, since a callback may destroy any
+    // watcher and so remove its entry and directory
+    for (size_t i = 0; i < m_changed.size(); i++)
+    {
+        if (!m_changed[i])
+        {
+            continue;
+        }
+
+        // Copied, the callback may destroy its own watcher and with it the entry
+        const auto callback = m_changed[i]->callback;
+        callback();
+        if (destroyed)
+        {
+            return false;
+        }
+    }
+    m_changed.clear();
+    return true;
+}
+
+bool FileWatcherThread::HasChanged(FileWatcherEntry& entry)
+{
+    auto lastWrite = LastWriteTime(entry.path);
+
+    std::lock_guard lock(m_mutex);
+    if (!entry.lastWrite.has_value())
+    {
+        entry.lastWrite = lastWrite;
+    }
+    else if (lastWrite.has_value())
+    {
+        if (entry.lastWrite->dwHighDateTime != lastWrite->dwHighDateTime ||
+            entry.lastWrite->dwLowDateTime != lastWrite->dwLowDateTime)
+        {
+            entry.lastWrite = lastWrite;
+            return true;
+        }
+    }
+    return false;
+}
+
+FileWatcher::FileWatcher(const std::wstring& path, std::function<void()> callback, DWORD refreshPeriod) :
+    m_entry(std::make_unique<FileWatcherEntry>()),
+    m_thread(FileWatcherThread::Acquire())
+{
+    const std::filesystem::path filePath{ path };
+    m_entry->path = path;
+    m_entry->directoryPath = filePath.has_parent_path() ? filePath.parent_path().wstring() : L".";
+    m_entry->fileName = ToUpper(filePath.filename().wstring());
+    m_entry->callback = callback;
+    m_entry->refreshPeriod = refreshPeriod;
+    m_entry->lastWrite = LastWriteTime(path);
+    m_thread->Add(m_entry.get());
+}
+
+FileWatcher::~FileWatcher()
+{
+    m_thread->Remove(m_entry.get());
+}
+
+void FileWatcher::AcknowledgeWrite()
+{
+    m_thread->Acknowledge(m_entry.get());
 }
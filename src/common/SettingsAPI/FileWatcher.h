@@ -5,22 +5,29 @@
 #include <Windows.h>
 
 #include <thread>
+#include <memory>
 #include <optional>
 #include <string>
 #include <functional>
 
+class FileWatcherThread;
+struct FileWatcherEntry;
+
+// Calls callback when the last write time of the file at path changes.
+// All the watchers of a process share one thread, which sleeps until ReadDirectoryChangesW reports a change in
+// one of the watched directories. A burst of writes is reported once, when the file has been quiet for a moment.
+// Files whose directory can't be watched, e.g. because it doesn't exist yet, are polled every refreshPeriod
+// milliseconds instead. The callbacks of all the watchers run on the shared thread one at a time, so a slow callback
+// delays the others. A callback may destroy any watcher, including its own.
 class FileWatcher
 {
-    DWORD m_refreshPeriod;
-    std::wstring m_path;
-    std::optional<FILETIME> m_lastWrite;
-    std::function<void()> m_callback;
-    HANDLE m_abortEvent;
-    std::thread m_thread;
-    
-    std::optional<FILETIME> MyFileTime();
-    void Run();
+    std::unique_ptr<FileWatcherEntry> m_entry;
+    std::shared_ptr<FileWatcherThread> m_thread;
+
 public:
     FileWatcher(const std::wstring& path, std::function<void()> callback, DWORD refreshPeriod = 1000);
     ~FileWatcher();
+
+    // Call after writing the file from this process, so the write isn't reported back to the callback.
+    void AcknowledgeWrite();
 };
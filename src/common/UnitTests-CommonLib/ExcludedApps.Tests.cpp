@@ -0,0 +1,69 @@
+#include "pch.h"
+#include <common/utils/excluded_apps.h>
+
+#include <random>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTestsCommonLib
+{
+    TEST_CLASS(ExcludedApps)
+    {
+        // Check made for every app before the matcher was used
+        static bool FindAppNameInPath(const std::wstring& where, const std::vector<std::wstring>& what)
+        {
+            for (const auto& row : what)
+            {
+                const auto pos = where.rfind(row);
+                const auto last_slash = where.rfind('\\');
+                if (pos != std::wstring::npos && pos <= last_slash + 1 && pos + row.length() > last_slash)
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+    public:
+        TEST_METHOD(MatchesFileName)
+        {
+            ExcludedAppsMatcher matcher({ L"NOTEPAD", L"CODE.EXE" });
+            Assert::IsTrue(matcher.Matches(L"C:\\WINDOWS\\SYSTEM32\\NOTEPAD.EXE"));
+            Assert::IsTrue(matcher.Matches(L"C:\\PROGRAMS\\VS CODE\\CODE.EXE"));
+            Assert::IsFalse(matcher.Matches(L"C:\\NOTEPAD\\EDITOR.EXE"));
+            Assert::IsFalse(matcher.Matches(L"C:\\PROGRAMS\\MYNOTEPAD.EXE"));
+            Assert::IsFalse(matcher.Matches(L"NOTEPAD.EXE"));
+            Assert::IsFalse(ExcludedAppsMatcher().Matches(L"C:\\NOTEPAD.EXE"));
+        }
+
+        TEST_METHOD(MatchesLikeSearchingEveryApp)
+        {
+            std::mt19937 random(42);
+            const auto randomString = [&](size_t maxLength, size_t alphabetSize) {
+                const wchar_t alphabet[] = L"AB\\";
+                std::wstring result(random() % (maxLength + 1), L'\0');
+                for (auto& c : result)
+                {
+                    c = alphabet[random() % alphabetSize];
+                }
+                return result;
+            };
+
+            for (int i = 0; i < 20000; i++)
+            {
+                std::vector<std::wstring> apps;
+                for (size_t count = random() % 4; count > 0; count--)
+                {
+                    apps.push_back(randomString(4, random() % 4 == 0 ? 3 : 2));
+                }
+
+                ExcludedAppsMatcher matcher(apps);
+                for (int j = 0; j < 5; j++)
+                {
+                    const auto path = randomString(12, 3);
+                    Assert::AreEqual(FindAppNameInPath(path, apps), matcher.Matches(path), path.c_str());
+                }
+            }
+        }
+    };
+}
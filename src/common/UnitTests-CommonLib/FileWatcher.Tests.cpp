@@ -0,0 +1,199 @@
+#include "pch.h"
+#include <common/SettingsAPI/FileWatcher.h>
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTestsCommonLib
+{
+    class CallbackCounter
+    {
+        HANDLE m_event = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+
+    public:
+        std::atomic<int> count = 0;
+
+        ~CallbackCounter()
+        {
+            CloseHandle(m_event);
+        }
+
+        std::function<void()> Callback()
+        {
+            return [this] {
+                count++;
+                SetEvent(m_event);
+            };
+        }
+
+        bool Wait(DWORD timeout)
+        {
+            return WaitForSingleObject(m_event, timeout) == WAIT_OBJECT_0;
+        }
+    };
+
+    TEST_CLASS(FileWatcherTests)
+    {
+        // Long enough that a callback coming in time can't be caused by polling
+        const DWORD c_noPolling = 60 * 1000;
+
+        std::filesystem::path m_directory = std::filesystem::temp_directory_path() / L"PowerToysFileWatcherTest";
+
+        std::wstring File(const wchar_t* name)
+        {
+            return (m_directory / name).wstring();
+        }
+
+        static void Write(const std::wstring& path, const std::string& contents)
+        {
+            std::ofstream{ path, std::ios::binary } << contents;
+        }
+
+    public:
+        TEST_METHOD_INITIALIZE(Initialize)
+        {
+            std::filesystem::create_directories(m_directory);
+        }
+
+        TEST_METHOD_CLEANUP(CleanUp)
+        {
+            std::error_code err;
+            std::filesystem::remove_all(m_directory, err);
+        }
+
+        TEST_METHOD(ReportsWrite)
+        {
+            const std::wstring file = File(L"settings.json");
+            Write(file, "{}");
+
+            CallbackCounter counter;
+            {
+                FileWatcher watcher(file, counter.Callback(), c_noPolling);
+
+                const auto start = std::chrono::steady_clock::now();
+                Write(file, "{\"a\":1}");
+                Assert::IsTrue(counter.Wait(5000));
+                const auto latency = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+                Logger::WriteMessage((L"Notified after " + std::to_wstring(latency.count()) + L" ms").c_str());
+            }
+
+            // Nothing is reported once the watcher is gone
+            Write(file, "{\"a\":2}");
+            Assert::IsFalse(counter.Wait(500));
+            Assert::AreEqual(1, counter.count.load());
+        }
+
+        TEST_METHOD(CoalescesBurstOfWrites)
+        {
+            const std::wstring file = File(L"settings.json");
+            Write(file, "{}");
+
+            CallbackCounter counter;
+            FileWatcher watcher(file, counter.Callback(), c_noPolling);
+            for (int i = 0; i < 20; i++)
+            {
+                Write(file, "{\"a\":" + std::to_string(i) + "}");
+                Sleep(5);
+            }
+
+            Assert::IsTrue(counter.Wait(5000));
+            Assert::IsFalse(counter.Wait(500));
+            Assert::AreEqual(1, counter.count.load());
+        }
+
+        TEST_METHOD(SharesDirectoryBetweenFiles)
+        {
+            const std::wstring first = File(L"first.json");
+            const std::wstring second = File(L"second.json");
+            Write(first, "{}");
+            Write(second, "{}");
+
+            CallbackCounter firstCounter;
+            CallbackCounter secondCounter;
+            FileWatcher firstWatcher(first, firstCounter.Callback(), c_noPolling);
+            FileWatcher secondWatcher(second, secondCounter.Callback(), c_noPolling);
+            FileWatcher otherWatcher(File(L"missing.json"), [] {}, c_noPolling);
+
+            Write(second, "{\"a\":1}");
+            Assert::IsTrue(secondCounter.Wait(5000));
+            Assert::IsFalse(firstCounter.Wait(500));
+
+            Write(first, "{\"a\":1}");
+            Assert::IsTrue(firstCounter.Wait(5000));
+            Assert::AreEqual(1, secondCounter.count.load());
+        }
+
+        TEST_METHOD(IgnoresAcknowledgedWrite)
+        {
+            const std::wstring file = File(L"settings.json");
+            Write(file, "{}");
+
+            CallbackCounter counter;
+            FileWatcher watcher(file, counter.Callback(), c_noPolling);
+
+            Write(file, "{\"a\":1}");
+            watcher.AcknowledgeWrite();
+            Assert::IsFalse(counter.Wait(500));
+
+            Write(file, "{\"a\":2}");
+            Assert::IsTrue(counter.Wait(5000));
+        }
+
+        TEST_METHOD(DestroysWatchersFromCallback)
+        {
+            const std::wstring file = File(L"settings.json");
+            const std::wstring other = File(L"other.json");
+            Write(file, "{}");
+            Write(other, "{}");
+
+            // The callback destroys both its own watcher and the other one, which also stops the shared thread
+            CallbackCounter counter;
+            auto notify = counter.Callback();
+            auto otherWatcher = std::make_unique<FileWatcher>(other, [] {}, c_noPolling);
+            std::unique_ptr<FileWatcher> watcher;
+            watcher = std::make_unique<FileWatcher>(
+                file, [&] {
+                    watcher.reset();
+                    otherWatcher.reset();
+                    notify();
+                },
+                c_noPolling);
+
+            Write(file, "{\"a\":1}");
+            Assert::IsTrue(counter.Wait(5000));
+            Assert::IsTrue(watcher == nullptr);
+            Assert::IsTrue(otherWatcher == nullptr);
+
+            Write(file, "{\"a\":2}");
+            Assert::IsFalse(counter.Wait(500));
+            Assert::AreEqual(1, counter.count.load());
+
+            // The next watcher gets a new thread
+            CallbackCounter nextCounter;
+            FileWatcher nextWatcher(file, nextCounter.Callback(), c_noPolling);
+            Write(file, "{\"a\":3}");
+            Assert::IsTrue(nextCounter.Wait(5000));
+        }
+
+        TEST_METHOD(PollsUntilDirectoryExists)
+        {
+            CleanUp();
+            const std::wstring file = File(L"settings.json");
+
+            CallbackCounter counter;
+            FileWatcher watcher(file, counter.Callback(), 50);
+
+            // The first time the file is seen only records its last write time
+            std::filesystem::create_directories(m_directory);
+            Write(file, "{}");
+            Sleep(500);
+
+            Write(file, "{\"a\":1}");
+            Assert::IsTrue(counter.Wait(5000));
+        }
+    };
+}
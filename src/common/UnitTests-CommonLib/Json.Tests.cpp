@@ -0,0 +1,74 @@
+#include "pch.h"
+#include <common/utils/json.h>
+
+#include <filesystem>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTestsCommonLib
+{
+    TEST_CLASS(JsonFile)
+    {
+        std::wstring m_file = (std::filesystem::temp_directory_path() / L"PowerToysJsonTest.json").wstring();
+
+    public:
+        TEST_METHOD_CLEANUP(CleanUp)
+        {
+            std::filesystem::remove(m_file);
+            std::filesystem::remove(m_file + L".tmp");
+        }
+
+        TEST_METHOD(RoundTrip)
+        {
+            json::JsonObject obj;
+            obj.SetNamedValue(L"name", json::value(L"\u00E9t\u00E9 \u4E2D\u6587"));
+            obj.SetNamedValue(L"count", json::value(42));
+            json::to_file(m_file, obj);
+
+            auto result = json::from_file(m_file);
+            Assert::IsTrue(result.has_value());
+            Assert::AreEqual(std::wstring(L"\u00E9t\u00E9 \u4E2D\u6587"), std::wstring(result->GetNamedString(L"name")));
+            Assert::AreEqual(42.0, result->GetNamedNumber(L"count"));
+            Assert::AreEqual(json::serialize(obj), json::read_file(m_file).value());
+        }
+
+        TEST_METHOD(ReadsByteOrderMark)
+        {
+            Assert::IsTrue(json::write_file_atomic(m_file, "\xEF\xBB\xBF{\"a\":true}"));
+
+            auto result = json::from_file(m_file);
+            Assert::IsTrue(result.has_value());
+            Assert::IsTrue(result->GetNamedBoolean(L"a"));
+        }
+
+        TEST_METHOD(InvalidOrMissingFile)
+        {
+            Assert::IsFalse(json::from_file(m_file).has_value());
+            Assert::IsFalse(json::read_file(m_file).has_value());
+
+            Assert::IsTrue(json::write_file_atomic(m_file, "{\"a\":"));
+            Assert::IsFalse(json::from_file(m_file).has_value());
+        }
+
+        TEST_METHOD(AtomicWriteReplacesFile)
+        {
+            json::JsonObject first;
+            first.SetNamedValue(L"value", json::value(std::wstring(4096, L'x')));
+            Assert::IsTrue(json::to_file_atomic(m_file, first));
+
+            json::JsonObject second;
+            second.SetNamedValue(L"value", json::value(L"y"));
+            Assert::IsTrue(json::to_file_atomic(m_file, second));
+
+            Assert::IsFalse(std::filesystem::exists(m_file + L".tmp"));
+            Assert::AreEqual(std::string("{\"value\":\"y\"}"), json::read_file(m_file).value());
+        }
+
+        TEST_METHOD(AtomicWriteToMissingFolderFails)
+        {
+            const std::wstring file = (std::filesystem::temp_directory_path() / L"PowerToysJsonTestMissing" / L"test.json").wstring();
+            Assert::IsFalse(json::write_file_atomic(file, "{}"));
+            Assert::IsFalse(std::filesystem::exists(file));
+        }
+    };
+}
@@ -0,0 +1,38 @@
+#include "pch.h"
+#include <common/utils/process_path.h>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTestsCommonLib
+{
+    TEST_CLASS(ProcessPath)
+    {
+    public:
+        TEST_METHOD(CachedPathMatchesQuery)
+        {
+            const DWORD pid = GetCurrentProcessId();
+            const auto path = ProcessPathCache::instance().get(pid);
+            Assert::AreEqual(get_process_path(pid), path);
+            Assert::AreEqual(get_module_filename(), path);
+            Assert::AreEqual(path, ProcessPathCache::instance().get(pid));
+        }
+
+        TEST_METHOD(ExitedProcessIsNotReturned)
+        {
+            wchar_t commandLine[] = L"cmd.exe /c exit";
+            STARTUPINFOW startupInfo{ .cb = sizeof(startupInfo) };
+            PROCESS_INFORMATION processInfo{};
+            Assert::IsTrue(CreateProcessW(nullptr, commandLine, nullptr, nullptr, FALSE, CREATE_SUSPENDED | CREATE_NO_WINDOW, nullptr, nullptr, &startupInfo, &processInfo));
+            CloseHandle(processInfo.hThread);
+
+            const auto path = ProcessPathCache::instance().get(processInfo.dwProcessId);
+            Assert::IsTrue(path.ends_with(L"cmd.exe"));
+
+            TerminateProcess(processInfo.hProcess, 0);
+            WaitForSingleObject(processInfo.hProcess, INFINITE);
+            CloseHandle(processInfo.hProcess);
+
+            Assert::AreEqual(std::wstring{}, ProcessPathCache::instance().get(processInfo.dwProcessId));
+        }
+    };
+}
@@ -24,7 +24,7 @@ public:
     void queue_message(std::wstring message)
     {
         this->queue_mutex.lock();
-        this->message_queue.push(message);
+        this->message_queue.push(std::move(message));
         this->queue_mutex.unlock();
         this->message_ready.notify_one();
     }
@@ -40,7 +40,7 @@ public:
             //Just returns a empty string if the queue was interrupted.
             return std::wstring(L"");
         }
-        std::wstring message = this->message_queue.front();
+        std::wstring message = std::move(this->message_queue.front());
         this->message_queue.pop();
         return message;
     }
@@ -3,6 +3,7 @@
 // See the LICENSE file in the project root for more information.
 
 using System;
+using System.Collections.Generic;
 using System.Threading;
 using interop;
 using Microsoft.VisualStudio.TestTools.UnitTesting;
@@ -57,6 +58,42 @@ namespace Microsoft.Interop.Tests
             }
         }
 
+        [TestMethod]
+        public void TestSendSeveralMessages()
+        {
+            // Sent over the same connection, including messages larger than the pipe buffer
+            var testStrings = new List<string> { "First message", new string('x', 100000), "Third message" };
+            var receivedStrings = new List<string>();
+            using (var reset = new AutoResetEvent(false))
+            {
+                using (var serverPipe = new TwoWayPipeMessageIPCManaged(
+                    ServerSidePipe,
+                    ClientSidePipe,
+                    (string msg) =>
+                    {
+                        receivedStrings.Add(msg);
+                        if (receivedStrings.Count == testStrings.Count)
+                        {
+                            reset.Set();
+                        }
+                    }))
+                {
+                    serverPipe.Start();
+                    ClientPipe.Start();
+
+                    foreach (var testString in testStrings)
+                    {
+                        ClientPipe.Send(testString);
+                    }
+
+                    reset.WaitOne();
+                    CollectionAssert.AreEqual(testStrings, receivedStrings);
+
+                    serverPipe.End();
+                }
+            }
+        }
+
         protected virtual void Dispose(bool disposing)
         {
             if (!disposedValue)
@@ -1,6 +1,7 @@
 #include "pch.h"
 #include "two_way_pipe_message_ipc_impl.h"
 
+#include <algorithm>
 #include <iterator>
 
 constexpr DWORD BUFSIZE = 1024;
@@ -65,6 +66,7 @@ void TwoWayPipeMessageIPC::TwoWayPipeMessageIPCImpl::end()
     input_queue_thread.join();
     output_queue.interrupt();
     output_queue_thread.join();
+    close_output_pipe();
     pipe_connect_handle_mutex.lock();
     if (current_connect_pipe_handle != NULL)
     {
@@ -73,15 +75,21 @@ void TwoWayPipeMessageIPC::TwoWayPipeMessageIPCImpl::end()
     }
     pipe_connect_handle_mutex.unlock();
     input_pipe_thread.join();
+
+    // Stop reading the connections that are still open and wait for their threads to let go of them.
+    std::unique_lock lock(pipe_connect_handle_mutex);
+    for (HANDLE connection_pipe_handle : connection_pipe_handles)
+    {
+        CancelIoEx(connection_pipe_handle, NULL);
+        DisconnectNamedPipe(connection_pipe_handle);
+    }
+    connections_closed.wait(lock, [this] { return connection_pipe_handles.empty(); });
 }
 
-void TwoWayPipeMessageIPC::TwoWayPipeMessageIPCImpl::send_pipe_message(std::wstring message)
+bool TwoWayPipeMessageIPC::TwoWayPipeMessageIPCImpl::connect_output_pipe()
 {
     // Adapted from https://docs.microsoft.com/en-us/windows/win32/ipc/named-pipe-client
-    HANDLE output_pipe_handle;
-    const wchar_t* message_send = message.c_str();
-    BOOL fSuccess = FALSE;
-    DWORD cbToWrite, cbWritten, dwMode;
+    DWORD dwMode;
     const wchar_t* lpszPipename = output_pipe_name.c_str();
 
     // Try to open a named pipe; wait for it, if necessary.
@@ -107,43 +115,70 @@ void TwoWayPipeMessageIPC::TwoWayPipeMessageIPCImpl::send_pipe_message(std::wstr
         DWORD curr_error = 0;
         if ((curr_error = GetLastError()) != ERROR_PIPE_BUSY)
         {
-            return;
+            return false;
         }
 
         // All pipe instances are busy, so wait for 20 seconds.
 
         if (!WaitNamedPipe(lpszPipename, 20000))
         {
-            return;
+            return false;
         }
     }
     dwMode = PIPE_READMODE_MESSAGE;
-    fSuccess = SetNamedPipeHandleState(
-        output_pipe_handle, // pipe handle
-        &dwMode, // new pipe mode
-        NULL, // don't set maximum bytes
-        NULL); // don't set maximum time
-    if (!fSuccess)
+    if (!SetNamedPipeHandleState(
+            output_pipe_handle, // pipe handle
+            &dwMode, // new pipe mode
+            NULL, // don't set maximum bytes
+            NULL)) // don't set maximum time
     {
-        return;
+        close_output_pipe();
+        return false;
     }
+    return true;
+}
 
-    // Send a message to the pipe server.
+void TwoWayPipeMessageIPC::TwoWayPipeMessageIPCImpl::close_output_pipe()
+{
+    if (output_pipe_handle != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(output_pipe_handle);
+        output_pipe_handle = INVALID_HANDLE_VALUE;
+    }
+}
 
-    cbToWrite = (lstrlen(message_send)) * sizeof(WCHAR); // no need to send final '\0'. Pipe is in message mode.
+bool TwoWayPipeMessageIPC::TwoWayPipeMessageIPCImpl::write_output_pipe(const std::wstring& message)
+{
+    if (output_pipe_handle == INVALID_HANDLE_VALUE && !connect_output_pipe())
+    {
+        return false;
+    }
 
-    fSuccess = WriteFile(
-        output_pipe_handle, // pipe handle
-        message_send, // message
-        cbToWrite, // message length
-        &cbWritten, // bytes written
-        NULL); // not overlapped
-    if (!fSuccess)
+    // Each message is written as a single pipe message, so the server reads it back whole.
+    const DWORD cbToWrite = static_cast<DWORD>(message.size() * sizeof(WCHAR)); // no need to send final '\0'. Pipe is in message mode.
+    DWORD cbWritten = 0;
+    if (!WriteFile(
+            output_pipe_handle, // pipe handle
+            message.c_str(), // message
+            cbToWrite, // message length
+            &cbWritten, // bytes written
+            NULL)) // not overlapped
     {
-        return;
+        close_output_pipe();
+        return false;
+    }
+    return true;
+}
+
+void TwoWayPipeMessageIPC::TwoWayPipeMessageIPCImpl::send_pipe_message(std::wstring message)
+{
+    // The connection is kept open between messages. If the other side went away since the last message,
+    // connect again once to reach its new pipe server.
+    const bool was_connected = output_pipe_handle != INVALID_HANDLE_VALUE;
+    if (!write_output_pipe(message) && was_connected)
+    {
+        write_output_pipe(message);
     }
-    CloseHandle(output_pipe_handle);
-    return;
 }
 
 void TwoWayPipeMessageIPC::TwoWayPipeMessageIPCImpl::consume_output_queue_thread()
@@ -347,52 +382,65 @@ HANDLE TwoWayPipeMessageIPC::TwoWayPipeMessageIPCImpl::create_medium_integrity_t
     return restricted_token_handle;
 }
 
-void TwoWayPipeMessageIPC::TwoWayPipeMessageIPCImpl::handle_pipe_connection(HANDLE input_pipe_handle)
+bool TwoWayPipeMessageIPC::TwoWayPipeMessageIPCImpl::read_pipe_message(HANDLE input_pipe_handle, std::vector<wchar_t>& buffer, std::wstring& message)
 {
-    if (!input_pipe_handle)
-    {
-        return;
-    }
-    constexpr DWORD readBlockBytes = BUFSIZE;
-    std::wstring message;
-    size_t iBlock = 0;
-    message.reserve(BUFSIZE);
-    bool ok;
-    do
+    // Read the whole pipe message into the buffer, growing it for messages larger than any read so far.
+    size_t charsRead = 0;
+    while (true)
     {
-        constexpr size_t charsPerBlock = readBlockBytes / sizeof(message[0]);
-        message.resize(message.size() + charsPerBlock);
+        if (charsRead == buffer.size())
+        {
+            buffer.resize(buffer.size() * 2);
+        }
+
         DWORD bytesRead = 0;
-        ok = ReadFile(
+        const bool ok = ReadFile(
             input_pipe_handle,
-            // read the message directly into the string block by block simultaneously resizing it
-            message.data() + iBlock * charsPerBlock,
-            readBlockBytes,
+            buffer.data() + charsRead,
+            static_cast<DWORD>((buffer.size() - charsRead) * sizeof(wchar_t)),
             &bytesRead,
             nullptr);
+        charsRead += bytesRead / sizeof(wchar_t);
 
-        if (!ok && GetLastError() != ERROR_MORE_DATA)
+        if (ok)
         {
             break;
         }
-        iBlock++;
-    } while (!ok);
-    // trim the message's buffer
-    const auto nullCharPos = message.find_last_not_of(L'\0');
-    if (nullCharPos != std::wstring::npos)
-    {
-        message.resize(nullCharPos + 1);
+        if (GetLastError() != ERROR_MORE_DATA)
+        {
+            return false;
+        }
     }
 
-    input_queue.queue_message(std::move(message));
+    message.assign(buffer.data(), charsRead);
+    return true;
+}
 
-    // Flush the pipe to allow the client to read the pipe's contents
-    // before disconnecting. Then disconnect the pipe, and close the
-    // handle to this pipe instance.
+void TwoWayPipeMessageIPC::TwoWayPipeMessageIPCImpl::handle_pipe_connection(HANDLE input_pipe_handle)
+{
+    if (!input_pipe_handle)
+    {
+        return;
+    }
 
-    FlushFileBuffers(input_pipe_handle);
+    // The client keeps the connection open and sends any number of messages, until it closes its side.
+    std::vector<wchar_t> buffer(BUFSIZE / sizeof(wchar_t));
+    std::wstring message;
+    while (!closed && read_pipe_message(input_pipe_handle, buffer, message))
+    {
+        // An empty message would stop the input queue thread.
+        if (!message.empty())
+        {
+            input_queue.queue_message(std::move(message));
+        }
+    }
+
+    // Close the handle under the lock, so end() never cancels a handle that was already closed.
+    std::unique_lock lock(pipe_connect_handle_mutex);
+    connection_pipe_handles.erase(std::remove(connection_pipe_handles.begin(), connection_pipe_handles.end(), input_pipe_handle), connection_pipe_handles.end());
     DisconnectNamedPipe(input_pipe_handle);
     CloseHandle(input_pipe_handle);
+    connections_closed.notify_all();
 }
 
 void TwoWayPipeMessageIPC::TwoWayPipeMessageIPCImpl::start_named_pipe_server(HANDLE token)
@@ -436,6 +484,8 @@ void TwoWayPipeMessageIPC::TwoWayPipeMessageIPCImpl::start_named_pipe_server(HAN
         }
         if (connected)
         {
+            std::unique_lock lock(pipe_connect_handle_mutex);
+            connection_pipe_handles.push_back(connect_pipe_handle);
             std::thread(&TwoWayPipeMessageIPCImpl::handle_pipe_connection, this, connect_pipe_handle).detach();
         }
         else
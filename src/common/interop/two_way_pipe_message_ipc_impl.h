@@ -5,6 +5,7 @@
 #include <accctrl.h>
 #include <aclapi.h>
 #include <list>
+#include <vector>
 #include "two_way_pipe_message_ipc.h"
 
 class TwoWayPipeMessageIPC::TwoWayPipeMessageIPCImpl
@@ -27,15 +28,22 @@ private:
     std::wstring outgoing_message; // Store the updated json settings.
 
     HANDLE current_connect_pipe_handle = NULL;
+    std::vector<HANDLE> connection_pipe_handles; // Connections currently being read, guarded by pipe_connect_handle_mutex
+    std::condition_variable connections_closed;
+    HANDLE output_pipe_handle = INVALID_HANDLE_VALUE; // Kept open between messages, only used by the output queue thread
     bool closed = false;
     TwoWayPipeMessageIPC::callback_function dispatch_inc_message_function;
 
+    bool connect_output_pipe();
+    void close_output_pipe();
+    bool write_output_pipe(const std::wstring& message);
     void send_pipe_message(std::wstring message);
     void consume_output_queue_thread();
     BOOL GetLogonSID(HANDLE hToken, PSID* ppsid);
     VOID FreeLogonSID(PSID* ppsid);
     int change_pipe_security_allow_restricted_token(HANDLE handle, HANDLE token);
     HANDLE create_medium_integrity_token();
+    bool read_pipe_message(HANDLE input_pipe_handle, std::vector<wchar_t>& buffer, std::wstring& message);
     void handle_pipe_connection(HANDLE input_pipe_handle);
     void start_named_pipe_server(HANDLE token);
     void consume_input_queue_thread();
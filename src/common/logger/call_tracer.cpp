@@ -1,55 +1,49 @@
 #include "pch.h"
 #include "call_tracer.h"
 
-#include <map>
-#include <thread>
+#include <string>
+#include <string_view>
 
 namespace
 {
+    constexpr int maxIndentLevel = 64;
+
     // Non-localizable
-    const std::string entering = " Enter";
-    const std::string exiting = " Exit";
+    const std::string spaces(2 * maxIndentLevel - 1, ' ');
+    const std::string_view indentMark = " - ";
 
-    std::mutex indentLevelMutex;
-    std::map<std::thread::id, int> indentLevel;
+    thread_local int indentLevel = 0;
 
-    std::string GetIndentation()
+    void Trace(const char* functionName, const char* action)
     {
-        std::unique_lock lock(indentLevelMutex);
-        int level = indentLevel[std::this_thread::get_id()];
-
-        if (level <= 0)
+        if (indentLevel <= 0)
         {
-            return {};
+            Logger::trace("{} {}", functionName, action);
         }
         else
         {
-            return std::string(2 * min(level, 64) - 1, ' ') + " - ";
+            const std::string_view indentation(spaces.data(), 2 * min(indentLevel, maxIndentLevel) - 1);
+            Logger::trace("{}{}{} {}", indentation, indentMark, functionName, action);
         }
     }
-
-    void Indent()
-    {
-        std::unique_lock lock(indentLevelMutex);
-        indentLevel[std::this_thread::get_id()]++;
-    }
-
-    void Unindent()
-    {
-        std::unique_lock lock(indentLevelMutex);
-        indentLevel[std::this_thread::get_id()]--;
-    }
 }
 
 CallTracer::CallTracer(const char* functionName) :
-    functionName(functionName)
+    functionName(functionName),
+    enabled(Logger::should_log(spdlog::level::trace))
 {
-    Logger::trace((GetIndentation() + functionName + entering).c_str());
-    Indent();
+    if (enabled)
+    {
+        Trace(functionName, "Enter");
+        indentLevel++;
+    }
 }
 
 CallTracer::~CallTracer()
 {
-    Unindent();
-    Logger::trace((GetIndentation() + functionName + exiting).c_str());
+    if (enabled)
+    {
+        indentLevel--;
+        Trace(functionName, "Exit");
+    }
 }
@@ -1,14 +1,15 @@
 #pragma once
 
-#include <string>
-
 #include "logger.h"
 
 #define _TRACER_ CallTracer callTracer(__FUNCTION__)
 
+// Logs entering and exiting the scope at trace level, indented by the depth of the traced calls on the thread.
+// Nothing is done when trace messages are filtered out.
 class CallTracer
 {
-    std::string functionName;
+    const char* functionName;
+    bool enabled;
 public:
     CallTracer(const char* functionName);
     ~CallTracer();
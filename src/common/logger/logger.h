@@ -57,6 +57,11 @@ public:
         logger->critical(fmt, args...);
     }
 
+    static bool should_log(spdlog::level::level_enum level)
+    {
+        return logger->should_log(level);
+    }
+
     static void flush()
     {
         logger->flush();
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <algorithm>
+#include <queue>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Checks process paths against the list of apps excluded by the user. An app is excluded if its last occurrence
+// in the path starts at the file name or spans the last backslash.
+// The list is compiled once into an Aho-Corasick automaton, so a path is checked in a single pass over its end
+// instead of searching the whole path for every app. The apps and the paths must both be uppercase.
+class ExcludedAppsMatcher
+{
+public:
+    ExcludedAppsMatcher() = default;
+
+    explicit ExcludedAppsMatcher(const std::vector<std::wstring>& apps)
+    {
+        nodes.emplace_back();
+        for (const auto& app : apps)
+        {
+            Insert(app);
+        }
+        BuildFailureLinks();
+    }
+
+    bool Matches(std::wstring_view path) const
+    {
+        const auto lastSlash = path.rfind(L'\\');
+        if (lastSlash == std::wstring_view::npos || nodes.empty())
+        {
+            return false;
+        }
+
+        const size_t fileNameStart = lastSlash + 1;
+        if (hasEmptyApp && fileNameStart == path.size())
+        {
+            return true;
+        }
+
+        // An app can only be excluded if one of its occurrences ends after the last backslash,
+        // and such an occurrence can't start earlier than the longest app before it
+        const size_t scanStart = fileNameStart > maxLength ? fileNameStart - maxLength : 0;
+
+        // Apps occurring at the file name, and apps occurring again later in the file name.
+        // Only the last occurrence counts, so an app matches if it's in the first list but not in the second one.
+        std::vector<int> occurringApps;
+        std::vector<int> occurringLaterApps;
+
+        int node = 0;
+        for (size_t i = scanStart; i < path.size(); i++)
+        {
+            node = Next(node, path[i]);
+            for (int app = nodes[node].length > 0 ? node : nodes[node].output; app > 0; app = nodes[app].output)
+            {
+                const size_t end = i + 1;
+                const size_t start = end - nodes[app].length;
+                if (start > fileNameStart)
+                {
+                    occurringLaterApps.push_back(app);
+                }
+                else if (end > lastSlash)
+                {
+                    occurringApps.push_back(app);
+                }
+            }
+        }
+
+        return std::any_of(occurringApps.begin(), occurringApps.end(), [&](int app) {
+            return std::find(occurringLaterApps.begin(), occurringLaterApps.end(), app) == occurringLaterApps.end();
+        });
+    }
+
+private:
+    struct Node
+    {
+        // Transitions sorted by character
+        std::vector<std::pair<wchar_t, int>> next;
+        int fail = 0;
+        // Closest node reached through the failure links which ends an app, 0 if there is none
+        int output = 0;
+        // Length of the app ending at this node, 0 if no app ends here
+        size_t length = 0;
+    };
+
+    std::vector<Node> nodes;
+    size_t maxLength = 0;
+    bool hasEmptyApp = false;
+
+    int Child(int node, wchar_t c) const
+    {
+        const auto& next = nodes[node].next;
+        auto it = std::lower_bound(next.begin(), next.end(), c, [](const auto& transition, wchar_t c) { return transition.first < c; });
+        return it != next.end() && it->first == c ? it->second : -1;
+    }
+
+    int Next(int node, wchar_t c) const
+    {
+        while (true)
+        {
+            const int child = Child(node, c);
+            if (child >= 0)
+            {
+                return child;
+            }
+            if (node == 0)
+            {
+                return 0;
+            }
+            node = nodes[node].fail;
+        }
+    }
+
+    void Insert(const std::wstring& app)
+    {
+        if (app.empty())
+        {
+            hasEmptyApp = true;
+            return;
+        }
+
+        int node = 0;
+        for (wchar_t c : app)
+        {
+            int child = Child(node, c);
+            if (child < 0)
+            {
+                child = static_cast<int>(nodes.size());
+                auto& next = nodes[node].next;
+                auto it = std::lower_bound(next.begin(), next.end(), c, [](const auto& transition, wchar_t c) { return transition.first < c; });
+                next.insert(it, { c, child });
+                nodes.emplace_back();
+            }
+            node = child;
+        }
+
+        nodes[node].length = app.size();
+        maxLength = (std::max)(maxLength, app.size());
+    }
+
+    void BuildFailureLinks()
+    {
+        std::queue<int> queue;
+        for (const auto& [c, child] : nodes[0].next)
+        {
+            queue.push(child);
+        }
+
+        while (!queue.empty())
+        {
+            const int node = queue.front();
+            queue.pop();
+
+            for (const auto& [c, child] : nodes[node].next)
+            {
+                const int fail = Next(nodes[node].fail, c);
+                nodes[child].fail = fail;
+                nodes[child].output = nodes[fail].length > 0 ? fail : nodes[fail].output;
+                queue.push(child);
+            }
+        }
+    }
+};
@@ -1,28 +1,63 @@
 #pragma once
 
+#include <Windows.h>
+
 #include <winrt/Windows.Foundation.h>
 #include <winrt/Windows.Foundation.Collections.h>
 #include <winrt/Windows.Data.Json.h>
 
-#include <optional>
 #include <fstream>
+#include <optional>
+#include <string>
+#include <string_view>
 
 namespace json
 {
     using namespace winrt::Windows::Data::Json;
 
+    // Reads the whole file in one go, without any conversion.
+    inline std::optional<std::string> read_file(std::wstring_view file_name)
+    {
+        std::ifstream file(file_name.data(), std::ios::binary | std::ios::ate);
+        if (!file.is_open())
+        {
+            return std::nullopt;
+        }
+
+        const std::streamoff size = file.tellg();
+        if (size < 0)
+        {
+            return std::nullopt;
+        }
+
+        std::string contents(static_cast<size_t>(size), '\0');
+        file.seekg(0);
+        if (!file.read(contents.data(), size))
+        {
+            return std::nullopt;
+        }
+
+        return contents;
+    }
+
     inline std::optional<JsonObject> from_file(std::wstring_view file_name)
     {
         try
         {
-            std::ifstream file(file_name.data(), std::ios::binary);
-            if (file.is_open())
+            auto contents = read_file(file_name);
+            if (!contents)
             {
-                using isbi = std::istreambuf_iterator<char>;
-                std::string obj_str{ isbi{ file }, isbi{} };
-                return JsonValue::Parse(winrt::to_hstring(obj_str)).GetObjectW();
+                return std::nullopt;
             }
-            return std::nullopt;
+
+            std::string_view utf8{ *contents };
+            if (utf8.starts_with("\xEF\xBB\xBF"))
+            {
+                utf8.remove_prefix(3);
+            }
+
+            // Windows.Data.Json only parses UTF-16, so the text is converted once here
+            return JsonObject::Parse(winrt::to_hstring(utf8));
         }
         catch (...)
         {
@@ -30,10 +65,53 @@ namespace json
         }
     }
 
+    // UTF-8 text of the object, as written by to_file. Converted from the UTF-16 text Stringify returns.
+    inline std::string serialize(const JsonObject& obj)
+    {
+        return winrt::to_string(obj.Stringify());
+    }
+
     inline void to_file(std::wstring_view file_name, const JsonObject& obj)
     {
-        std::wstring obj_str{ obj.Stringify().c_str() };
-        std::ofstream{ file_name.data(), std::ios::binary } << winrt::to_string(obj_str);
+        std::ofstream{ file_name.data(), std::ios::binary } << serialize(obj);
+    }
+
+    // Writes a temporary file next to the target and moves it over the target, so readers see either
+    // the old or the new contents. Both the data and the move are flushed to disk before returning,
+    // so a power loss can't leave a truncated file behind either.
+    inline bool write_file_atomic(std::wstring_view file_name, std::string_view contents)
+    {
+        const std::wstring target{ file_name };
+        const std::wstring temp = target + L".tmp";
+        if (contents.size() > MAXDWORD)
+        {
+            return false;
+        }
+
+        HANDLE file = CreateFileW(temp.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            return false;
+        }
+
+        DWORD written = 0;
+        const bool flushed = WriteFile(file, contents.data(), static_cast<DWORD>(contents.size()), &written, nullptr) &&
+                             written == contents.size() &&
+                             FlushFileBuffers(file);
+        CloseHandle(file);
+
+        if (!flushed || !MoveFileExW(temp.c_str(), target.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+        {
+            DeleteFileW(temp.c_str());
+            return false;
+        }
+
+        return true;
+    }
+
+    inline bool to_file_atomic(std::wstring_view file_name, const JsonObject& obj)
+    {
+        return write_file_atomic(file_name, serialize(obj));
     }
 
     inline bool has(
@@ -3,6 +3,8 @@
 #include <windows.h>
 #include <shlwapi.h>
 
+#include <list>
+#include <mutex>
 #include <string>
 #include <thread>
 
@@ -25,6 +27,109 @@ inline std::wstring get_process_path(DWORD pid) noexcept
     return name;
 }
 
+// Cache of the executable paths of recently queried processes, for callers looking up the process of a window on every event.
+// Each entry keeps a handle to its process, so the pid can't be reused while it is cached, and entries are dropped once the process exits.
+class ProcessPathCache
+{
+public:
+    static constexpr size_t MaxEntries = 32;
+
+    static ProcessPathCache& instance()
+    {
+        static ProcessPathCache cache;
+        return cache;
+    }
+
+    ~ProcessPathCache()
+    {
+        for (auto& entry : entries)
+        {
+            CloseHandle(entry.process);
+        }
+    }
+
+    std::wstring get(DWORD pid) noexcept
+    {
+        {
+            std::unique_lock lock(mutex);
+            for (auto it = entries.begin(); it != entries.end(); ++it)
+            {
+                if (it->pid != pid)
+                {
+                    continue;
+                }
+
+                if (WaitForSingleObject(it->process, 0) == WAIT_TIMEOUT)
+                {
+                    // Keep the most recently used entries at the front
+                    entries.splice(entries.begin(), entries, it);
+                    return it->path;
+                }
+
+                // The process exited, another one may get the same pid
+                CloseHandle(it->process);
+                entries.erase(it);
+                break;
+            }
+        }
+
+        // The handle used for the query also keeps the pid from being reused while the path is cached
+        HANDLE process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION | SYNCHRONIZE, FALSE, pid);
+        if (!process)
+        {
+            return get_process_path(pid);
+        }
+
+        std::wstring path(MAX_PATH, L'\0');
+        DWORD path_length = static_cast<DWORD>(path.length());
+        if (QueryFullProcessImageNameW(process, 0, path.data(), &path_length) == 0)
+        {
+            path_length = 0;
+        }
+        path.resize(path_length);
+
+        if (path.empty())
+        {
+            CloseHandle(process);
+            return path;
+        }
+
+        std::unique_lock lock(mutex);
+        for (const auto& entry : entries)
+        {
+            if (entry.pid == pid && WaitForSingleObject(entry.process, 0) == WAIT_TIMEOUT)
+            {
+                // Another thread cached the same process meanwhile
+                CloseHandle(process);
+                return path;
+            }
+        }
+
+        entries.push_front(Entry{ pid, process, path });
+        if (entries.size() > MaxEntries)
+        {
+            CloseHandle(entries.back().process);
+            entries.pop_back();
+        }
+        return path;
+    }
+
+private:
+    struct Entry
+    {
+        DWORD pid;
+        HANDLE process;
+        std::wstring path;
+    };
+
+    ProcessPathCache() = default;
+    ProcessPathCache(const ProcessPathCache&) = delete;
+    ProcessPathCache& operator=(const ProcessPathCache&) = delete;
+
+    std::mutex mutex;
+    std::list<Entry> entries;
+};
+
 // Get the executable path or module name for modern apps
 inline std::wstring get_process_path(HWND window) noexcept
 {
@@ -32,7 +137,7 @@ inline std::wstring get_process_path(HWND window) noexcept
 
     DWORD pid{};
     GetWindowThreadProcessId(window, &pid);
-    auto name = get_process_path(pid);
+    auto name = ProcessPathCache::instance().get(pid);
 
     if (name.length() >= app_frame_host.length() &&
         name.compare(name.length() - app_frame_host.length(), app_frame_host.length(), app_frame_host) == 0)
@@ -61,7 +166,7 @@ inline std::wstring get_process_path(HWND window) noexcept
         // If we have a new pid, get the new name.
         if (new_pid != pid)
         {
-            return get_process_path(new_pid);
+            return ProcessPathCache::instance().get(new_pid);
         }
     }
 
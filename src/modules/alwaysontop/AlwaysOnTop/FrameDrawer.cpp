@@ -1,6 +1,104 @@
 #include "pch.h"
 #include "FrameDrawer.h"
 
+#include <algorithm>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+
+#include <dwmapi.h>
+
+class FrameDrawer::RenderThread
+{
+public:
+    static RenderThread& instance()
+    {
+        static RenderThread self;
+        return self;
+    }
+
+    void Invalidate(FrameDrawer* drawer)
+    {
+        {
+            std::unique_lock lock(m_mutex);
+            if (std::find(m_invalidated.begin(), m_invalidated.end(), drawer) != m_invalidated.end())
+            {
+                return;
+            }
+
+            m_invalidated.push_back(drawer);
+        }
+        m_cv.notify_all();
+    }
+
+    // Waits until the border isn't being drawn anymore
+    void Remove(FrameDrawer* drawer)
+    {
+        std::unique_lock lock(m_mutex);
+        m_invalidated.erase(std::remove(m_invalidated.begin(), m_invalidated.end(), drawer), m_invalidated.end());
+        m_cv.wait(lock, [this, drawer]() { return m_rendering != drawer; });
+    }
+
+private:
+    RenderThread() :
+        m_thread([this]() { Run(); })
+    {
+    }
+
+    ~RenderThread()
+    {
+        {
+            std::unique_lock lock(m_mutex);
+            m_abortThread = true;
+        }
+        m_cv.notify_all();
+        m_thread.join();
+    }
+
+    void Run()
+    {
+        std::unique_lock lock(m_mutex);
+        while (true)
+        {
+            m_cv.wait(lock, [this]() { return m_abortThread || !m_invalidated.empty(); });
+            if (m_abortThread)
+            {
+                return;
+            }
+
+            while (!m_invalidated.empty())
+            {
+                FrameDrawer* drawer = m_invalidated.front();
+                m_invalidated.erase(m_invalidated.begin());
+                m_rendering = drawer;
+                lock.unlock();
+
+                if (drawer->Render() == RenderResult::Failed)
+                {
+                    Logger::error("Render failed");
+                    drawer->Hide();
+                }
+
+                lock.lock();
+                m_rendering = nullptr;
+                m_cv.notify_all();
+            }
+
+            // Wait for the next composition frame, so borders changing in a burst are drawn at most once per frame
+            lock.unlock();
+            DwmFlush();
+            lock.lock();
+        }
+    }
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::vector<FrameDrawer*> m_invalidated;
+    FrameDrawer* m_rendering = nullptr;
+    bool m_abortThread = false;
+    std::thread m_thread;
+};
+
 std::unique_ptr<FrameDrawer> FrameDrawer::Create(HWND window)
 {
     auto self = std::make_unique<FrameDrawer>(window);
@@ -12,14 +110,6 @@ std::unique_ptr<FrameDrawer> FrameDrawer::Create(HWND window)
     return nullptr;
 }
 
-FrameDrawer::FrameDrawer(FrameDrawer&& other) :
-    m_window(other.m_window),
-    m_renderTarget(std::move(other.m_renderTarget)), 
-    m_sceneRect(std::move(other.m_sceneRect)),
-    m_renderThread(std::move(m_renderThread))
-{
-}
-
 FrameDrawer::FrameDrawer(HWND window) :
     m_window(window), m_renderTarget(nullptr)
 {
@@ -27,8 +117,12 @@ FrameDrawer::FrameDrawer(HWND window) :
 
 FrameDrawer::~FrameDrawer()
 {
-    m_abortThread = true;
-    m_renderThread.join();
+    RenderThread::instance().Remove(this);
+
+    if (m_borderBrush)
+    {
+        m_borderBrush->Release();
+    }
 
     if (m_renderTarget)
     {
@@ -57,7 +151,8 @@ bool FrameDrawer::Init()
         96.f);
 
     auto renderTargetSize = D2D1::SizeU(clientRect.right - clientRect.left, clientRect.bottom - clientRect.top);
-    auto hwndRenderTargetProperties = D2D1::HwndRenderTargetProperties(m_window, renderTargetSize);
+    // Borders are drawn one after another by a single thread, which doesn't wait for vertical sync after each of them
+    auto hwndRenderTargetProperties = D2D1::HwndRenderTargetProperties(m_window, renderTargetSize, D2D1_PRESENT_OPTIONS_IMMEDIATELY);
 
     hr = GetD2DFactory()->CreateHwndRenderTarget(renderTargetProperties, hwndRenderTargetProperties, &m_renderTarget);
 
@@ -66,8 +161,6 @@ bool FrameDrawer::Init()
         return false;
     }
 
-    m_renderThread = std::thread([this]() { RenderLoop(); });
-
     return true;
 }
 
@@ -79,19 +172,38 @@ void FrameDrawer::Hide()
 void FrameDrawer::Show()
 {
     ShowWindow(m_window, SW_SHOWNA);
+    Redraw();
 }
 
 void FrameDrawer::SetBorderRect(RECT windowRect, COLORREF color, float thickness)
 {
-    std::unique_lock lock(m_mutex);
-
     auto borderColor = ConvertColor(color);
 
-    m_sceneRect = DrawableRect{
+    const DrawableRect sceneRect{
         .rect = ConvertRect(windowRect),
         .borderColor = borderColor,
         .thickness = thickness
     };
+
+    {
+        std::unique_lock lock(m_mutex);
+        if (m_sceneRect.has_value() &&
+            memcmp(&m_sceneRect->rect, &sceneRect.rect, sizeof(sceneRect.rect)) == 0 &&
+            memcmp(&m_sceneRect->borderColor, &sceneRect.borderColor, sizeof(sceneRect.borderColor)) == 0 &&
+            m_sceneRect->thickness == sceneRect.thickness)
+        {
+            return;
+        }
+
+        m_sceneRect = sceneRect;
+    }
+
+    Redraw();
+}
+
+void FrameDrawer::Redraw()
+{
+    RenderThread::instance().Invalidate(this);
 }
 
 ID2D1Factory* FrameDrawer::GetD2DFactory()
@@ -136,37 +248,35 @@ FrameDrawer::RenderResult FrameDrawer::Render()
         return RenderResult::Failed;
     }
 
+    if (!m_sceneRect.has_value())
+    {
+        return RenderResult::Ok;
+    }
+
+    const DrawableRect sceneRect = m_sceneRect.value();
+
+    // The render target is only released after the border was removed from the render thread
+    lock.unlock();
+
     m_renderTarget->BeginDraw();
 
     // Draw backdrop
     m_renderTarget->Clear(D2D1::ColorF(0.f, 0.f, 0.f, 0.f));
 
-    ID2D1SolidColorBrush* borderBrush = nullptr;
-    m_renderTarget->CreateSolidColorBrush(m_sceneRect.borderColor, &borderBrush);
-
-    if (borderBrush)
+    if (m_borderBrush)
     {
-        m_renderTarget->DrawRectangle(m_sceneRect.rect, borderBrush, m_sceneRect.thickness);
-        borderBrush->Release();
+        m_borderBrush->SetColor(sceneRect.borderColor);
+    }
+    else
+    {
+        m_renderTarget->CreateSolidColorBrush(sceneRect.borderColor, &m_borderBrush);
     }
 
-    // The lock must be released here, as EndDraw() will wait for vertical sync
-    lock.unlock();
+    if (m_borderBrush)
+    {
+        m_renderTarget->DrawRectangle(sceneRect.rect, m_borderBrush, sceneRect.thickness);
+    }
 
     m_renderTarget->EndDraw();
     return RenderResult::Ok;
 }
-
-void FrameDrawer::RenderLoop()
-{
-    while (!m_abortThread)
-    {
-        auto result = Render();
-        if (result == RenderResult::Failed)
-        {
-            Logger::error("Render failed");
-            Hide();
-            m_abortThread = true;
-        }
-    }
-}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <mutex>
+#include <optional>
 #include <d2d1.h>
 #include <dwrite.h>
 
@@ -10,7 +11,7 @@ public:
     static std::unique_ptr<FrameDrawer> Create(HWND window);
 
     FrameDrawer(HWND window);
-    FrameDrawer(FrameDrawer&& other);
+    FrameDrawer(FrameDrawer&& other) = delete;
     ~FrameDrawer();
 
     bool Init();
@@ -19,7 +20,13 @@ public:
     void Hide();
     void SetBorderRect(RECT windowRect, COLORREF color, float thickness);
 
+    // Draw the border again, e.g. after the window was resized
+    void Redraw();
+
 private:
+    // Thread drawing the borders of all pinned windows, only when they have to be drawn again
+    class RenderThread;
+
     struct DrawableRect
     {
         D2D1_RECT_F rect;
@@ -38,14 +45,12 @@ private:
     static D2D1_COLOR_F ConvertColor(COLORREF color);
     static D2D1_RECT_F ConvertRect(RECT rect);
     RenderResult Render();
-    void RenderLoop();
 
     HWND m_window = nullptr;
     ID2D1HwndRenderTarget* m_renderTarget = nullptr;
+    // Only used by the render thread
+    ID2D1SolidColorBrush* m_borderBrush = nullptr;
 
     std::mutex m_mutex;
-    DrawableRect m_sceneRect;
-
-    std::atomic<bool> m_abortThread = false;
-    std::thread m_renderThread;
+    std::optional<DrawableRect> m_sceneRect;
 };
\ No newline at end of file
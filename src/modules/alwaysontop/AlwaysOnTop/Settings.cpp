@@ -172,6 +172,7 @@ void AlwaysOnTopSettings::LoadSettings()
 
             if (m_settings.excludedApps != excludedApps)
             {
+                m_settings.excludedAppsMatcher = ExcludedAppsMatcher(excludedApps);
                 m_settings.excludedApps = excludedApps;
                 NotifyObservers(SettingId::ExcludeApps);
             }
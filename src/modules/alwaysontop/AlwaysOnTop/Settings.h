@@ -4,6 +4,7 @@
 
 #include <common/SettingsAPI/FileWatcher.h>
 #include <common/SettingsAPI/settings_objects.h>
+#include <common/utils/excluded_apps.h>
 
 #include <SettingsConstants.h>
 
@@ -22,6 +23,7 @@ struct Settings
     float frameThickness = 15.0f;
     COLORREF frameColor = RGB(0, 173, 239);
     std::vector<std::wstring> excludedApps{};
+    ExcludedAppsMatcher excludedAppsMatcher;
 };
 
 class AlwaysOnTopSettings
@@ -202,6 +202,16 @@ LRESULT WindowBorder::WndProc(UINT message, WPARAM wparam, LPARAM lparam) noexce
     case WM_ERASEBKGND:
         return TRUE;
 
+    case WM_SIZE:
+    {
+        // The border is only drawn when it changes, so draw it again for the new size
+        if (m_frameDrawer)
+        {
+            m_frameDrawer->Redraw();
+        }
+        return DefWindowProc(m_window, message, wparam, lparam);
+    }
+
     default:
     {
         return DefWindowProc(m_window, message, wparam, lparam);
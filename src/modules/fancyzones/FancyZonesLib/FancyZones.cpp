@@ -293,6 +293,9 @@ FancyZones::Destroy() noexcept
     }
 
     m_virtualDesktop.UnInit();
+
+    // Don't lose zone history changes that are still waiting to be written
+    AppZoneHistory::instance().FlushPendingChanges();
 }
 
 // IFancyZonesCallback
@@ -425,7 +428,7 @@ void FancyZones::WindowCreated(HWND window) noexcept
         return;
     }
 
-    const bool isCandidateForLastKnownZone = FancyZonesUtils::IsCandidateForZoning(window, m_settings->GetSettings()->excludedAppsArray);
+    const bool isCandidateForLastKnownZone = FancyZonesUtils::IsCandidateForZoning(window, m_settings->GetSettings()->excludedAppsMatcher);
     if (!isCandidateForLastKnownZone)
     {
         return;
@@ -955,7 +958,10 @@ void FancyZones::UpdateWorkAreas() noexcept
 
 void FancyZones::UpdateWindowsPositions(bool suppressMove) noexcept
 {
-    for (const auto [window, desktopId] : m_virtualDesktop.GetWindowsRelatedToDesktops())
+    // The zone rects of all windows are computed first, then the windows are moved when this goes out of scope, sharing the wait for minimizing windows
+    FancyZonesUtils::DeferredWindowSizing deferredSizing;
+
+    for (const auto [window, desktopId] : m_virtualDesktop.GetZonedWindowsRelatedToDesktops())
     {
         auto zoneIndexSet = GetZoneIndexSet(window);
         auto workArea = m_workAreaHandler.GetWorkArea(window, desktopId);
@@ -1294,7 +1300,7 @@ void FancyZones::UpdateZoneSets() noexcept
 bool FancyZones::ShouldProcessSnapHotkey(DWORD vkCode) noexcept
 {
     auto window = GetForegroundWindow();
-    if (m_settings->GetSettings()->overrideSnapHotkeys && FancyZonesUtils::IsCandidateForZoning(window, m_settings->GetSettings()->excludedAppsArray))
+    if (m_settings->GetSettings()->overrideSnapHotkeys && FancyZonesUtils::IsCandidateForZoning(window, m_settings->GetSettings()->excludedAppsMatcher))
     {
         HMONITOR monitor = WorkAreaKeyFromWindow(window);
 
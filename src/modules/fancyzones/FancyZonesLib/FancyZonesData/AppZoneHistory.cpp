@@ -10,7 +10,14 @@
 #include <FancyZonesLib/JsonHelpers.h>
 #include <FancyZonesLib/util.h>
 
-AppZoneHistory::AppZoneHistory()
+namespace
+{
+    // How long the history has to stay unchanged before it is written
+    const std::chrono::milliseconds SaveDelay{ 1000 };
+}
+
+AppZoneHistory::AppZoneHistory() :
+    m_deferredSave(SaveDelay, [this] { Save(); })
 {
 }
 
@@ -22,11 +29,15 @@ AppZoneHistory& AppZoneHistory::instance()
 
 void AppZoneHistory::SetVirtualDesktopCheckCallback(std::function<bool(GUID)> callback)
 {
+    std::unique_lock lock(m_historyLock);
     m_virtualDesktopCheckCallback = callback;
 }
 
 void AppZoneHistory::LoadData()
 {
+    // Whatever was waiting to be saved is replaced by the file contents
+    m_deferredSave.Cancel();
+
     auto file = AppZoneHistoryFileName();
     auto data = json::from_file(file);
 
@@ -34,10 +45,13 @@ void AppZoneHistory::LoadData()
     {
         if (data)
         {
-            m_history = JSONHelpers::ParseAppZoneHistory(data.value());
+            auto history = JSONHelpers::ParseAppZoneHistory(data.value());
+            std::unique_lock lock(m_historyLock);
+            m_history = std::move(history);
         }
         else
         {
+            std::unique_lock lock(m_historyLock);
             m_history.clear();
             Logger::error(L"app-zone-history.json file is missing or malformed");
         }
@@ -49,37 +63,55 @@ void AppZoneHistory::LoadData()
 }
 
 void AppZoneHistory::SaveData()
+{
+    m_deferredSave.SaveNow();
+}
+
+void AppZoneHistory::FlushPendingChanges()
+{
+    m_deferredSave.Flush();
+}
+
+void AppZoneHistory::ScheduleSave()
+{
+    m_deferredSave.Schedule();
+}
+
+void AppZoneHistory::Save()
 {
     _TRACER_;
 
-    bool dirtyFlag = false;
-    std::unordered_map<std::wstring, std::vector<FancyZonesDataTypes::AppZoneHistoryData>> updatedHistory;
-    if (m_virtualDesktopCheckCallback)
+    TAppZoneHistoryMap history;
+    std::function<bool(GUID)> virtualDesktopCheckCallback;
+    {
+        std::shared_lock lock(m_historyLock);
+        history = m_history;
+        virtualDesktopCheckCallback = m_virtualDesktopCheckCallback;
+    }
+
+    if (virtualDesktopCheckCallback)
     {
-        for (const auto& [path, dataVector] : m_history)
+        // The check reads the registry, so ask once per desktop rather than once per entry
+        std::unordered_map<GUID, bool> savedDesktops;
+        for (auto& [path, dataVector] : history)
         {
-            auto updatedVector = dataVector;
-            for (auto& data : updatedVector)
+            for (auto& data : dataVector)
             {
-                if (!m_virtualDesktopCheckCallback(data.deviceId.virtualDesktopId))
+                auto saved = savedDesktops.find(data.deviceId.virtualDesktopId);
+                if (saved == savedDesktops.end())
+                {
+                    saved = savedDesktops.emplace(data.deviceId.virtualDesktopId, virtualDesktopCheckCallback(data.deviceId.virtualDesktopId)).first;
+                }
+
+                if (!saved->second)
                 {
                     data.deviceId.virtualDesktopId = GUID_NULL;
-                    dirtyFlag = true;
                 }
             }
-
-            updatedHistory.insert(std::make_pair(path, updatedVector));
         }
     }
 
-    if (dirtyFlag)
-    {
-        JSONHelpers::SaveAppZoneHistory(AppZoneHistoryFileName(), updatedHistory);
-    }
-    else
-    {
-        JSONHelpers::SaveAppZoneHistory(AppZoneHistoryFileName(), m_history);
-    }
+    JSONHelpers::SaveAppZoneHistory(AppZoneHistoryFileName(), history);
 }
 
 bool AppZoneHistory::SetAppLastZones(HWND window, const FancyZonesDataTypes::DeviceIdData& deviceId, const std::wstring& zoneSetId, const ZoneIndexSet& zoneIndexSet)
@@ -109,10 +141,13 @@ bool AppZoneHistory::SetAppLastZones(HWND window, const FancyZonesDataTypes::Dev
             if (data.deviceId == deviceId)
             {
                 // application already has history on this work area, update it with new window position
-                data.processIdToHandleMap[processId] = window;
-                data.zoneSetUuid = zoneSetId;
-                data.zoneIndexSet = zoneIndexSet;
-                SaveData();
+                {
+                    std::unique_lock lock(m_historyLock);
+                    data.processIdToHandleMap[processId] = window;
+                    data.zoneSetUuid = zoneSetId;
+                    data.zoneIndexSet = zoneIndexSet;
+                }
+                ScheduleSave();
                 return true;
             }
         }
@@ -125,18 +160,21 @@ bool AppZoneHistory::SetAppLastZones(HWND window, const FancyZonesDataTypes::Dev
                                                   .deviceId = deviceId,
                                                   .zoneIndexSet = zoneIndexSet };
 
-    if (m_history.contains(processPath))
     {
-        // application already has history but on other desktop, add with new desktop info
-        m_history[processPath].push_back(data);
-    }
-    else
-    {
-        // new application, create entry in app zone history map
-        m_history[processPath] = std::vector<FancyZonesDataTypes::AppZoneHistoryData>{ data };
+        std::unique_lock lock(m_historyLock);
+        if (m_history.contains(processPath))
+        {
+            // application already has history but on other desktop, add with new desktop info
+            m_history[processPath].push_back(data);
+        }
+        else
+        {
+            // new application, create entry in app zone history map
+            m_history[processPath] = std::vector<FancyZonesDataTypes::AppZoneHistoryData>{ data };
+        }
     }
 
-    SaveData();
+    ScheduleSave();
     return true;
 }
 
@@ -160,6 +198,7 @@ bool AppZoneHistory::RemoveAppLastZone(HWND window, const FancyZonesDataTypes::D
                         DWORD processId = 0;
                         GetWindowThreadProcessId(window, &processId);
 
+                        std::unique_lock lock(m_historyLock);
                         data->processIdToHandleMap.erase(processId);
                     }
 
@@ -174,12 +213,15 @@ bool AppZoneHistory::RemoveAppLastZone(HWND window, const FancyZonesDataTypes::D
                         }
                     }
 
-                    data = perDesktopData.erase(data);
-                    if (perDesktopData.empty())
                     {
-                        m_history.erase(processPath);
+                        std::unique_lock lock(m_historyLock);
+                        data = perDesktopData.erase(data);
+                        if (perDesktopData.empty())
+                        {
+                            m_history.erase(processPath);
+                        }
                     }
-                    SaveData();
+                    ScheduleSave();
                     return true;
                 }
                 else
@@ -195,6 +237,7 @@ bool AppZoneHistory::RemoveAppLastZone(HWND window, const FancyZonesDataTypes::D
 
 void AppZoneHistory::RemoveApp(const std::wstring& appPath)
 {
+    std::unique_lock lock(m_historyLock);
     m_history.erase(appPath);
 }
 
@@ -270,6 +313,7 @@ void AppZoneHistory::UpdateProcessIdToHandleMap(HWND window, const FancyZonesDat
                 {
                     DWORD processId = 0;
                     GetWindowThreadProcessId(window, &processId);
+                    std::unique_lock lock(m_historyLock);
                     data.processIdToHandleMap[processId] = window;
                     break;
                 }
@@ -310,6 +354,7 @@ void AppZoneHistory::SyncVirtualDesktops(GUID currentVirtualDesktopId)
     
     bool dirtyFlag = false;
 
+    std::unique_lock lock(m_historyLock);
     for (auto& [path, perDesktopData] : m_history)
     {
         for (auto& data : perDesktopData)
@@ -330,6 +375,8 @@ void AppZoneHistory::SyncVirtualDesktops(GUID currentVirtualDesktopId)
         }
     }
 
+    lock.unlock();
+
     if (dirtyFlag)
     {
         wil::unique_cotaskmem_string virtualDesktopIdStr;
@@ -338,7 +385,7 @@ void AppZoneHistory::SyncVirtualDesktops(GUID currentVirtualDesktopId)
             Logger::info(L"Update Virtual Desktop id to {}", virtualDesktopIdStr.get());
         }
 
-        SaveData();
+        ScheduleSave();
     }
 }
 
@@ -347,6 +394,7 @@ void AppZoneHistory::RemoveDeletedVirtualDesktops(const std::vector<GUID>& activ
     std::unordered_set<GUID> active(std::begin(activeDesktops), std::end(activeDesktops));
     bool dirtyFlag = false;
 
+    std::unique_lock lock(m_historyLock);
     for (auto it = std::begin(m_history); it != std::end(m_history);)
     {
         auto& perDesktopData = it->second;
@@ -378,9 +426,10 @@ void AppZoneHistory::RemoveDeletedVirtualDesktops(const std::vector<GUID>& activ
             ++it;
         }
     }
+    lock.unlock();
 
     if (dirtyFlag)
     {
-        SaveData();
+        ScheduleSave();
     }
 }
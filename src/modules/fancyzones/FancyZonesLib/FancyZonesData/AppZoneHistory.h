@@ -1,6 +1,7 @@
 #pragma once
 
 #include <FancyZonesLib/FancyZonesDataTypes.h>
+#include <FancyZonesLib/FancyZonesData/DeferredSave.h>
 #include <FancyZonesLib/ModuleConstants.h>
 
 #include <common/SettingsAPI/settings_helpers.h>
@@ -22,7 +23,10 @@ public:
     }
 
     void LoadData();
+    // Writes the history now, replacing any scheduled save.
     void SaveData();
+    // Writes changes that are still waiting for the scheduled save. Called on shutdown.
+    void FlushPendingChanges();
 
     bool SetAppLastZones(HWND window, const FancyZonesDataTypes::DeviceIdData& deviceId, const std::wstring& zoneSetId, const ZoneIndexSet& zoneIndexSet);
     bool RemoveAppLastZone(HWND window, const FancyZonesDataTypes::DeviceIdData& deviceId, const std::wstring_view& zoneSetId);
@@ -44,6 +48,14 @@ private:
     AppZoneHistory();
     ~AppZoneHistory() = default;
 
+    // Changes are coalesced and written once windows stop moving, rather than on every snap.
+    void ScheduleSave();
+    void Save();
+
+    // Modified on the FancyZones thread only. The deferred save reads it from a thread pool thread,
+    // so modifications take the lock exclusively and reads on the FancyZones thread don't lock.
     TAppZoneHistoryMap m_history;
     std::function<bool(GUID)> m_virtualDesktopCheckCallback;
+    mutable std::shared_mutex m_historyLock;
+    DeferredSave m_deferredSave;
 };
@@ -200,6 +200,9 @@ void AppliedLayouts::SaveData()
     else
     {
         json::to_file(AppliedLayoutsFileName(), JsonUtils::SerializeJson(m_layouts));
+
+        // Reloading the file would only read back what is already in memory
+        m_fileWatcher->AcknowledgeWrite();
     }
 }
 
@@ -0,0 +1,87 @@
+#include "../pch.h"
+#include "DeferredSave.h"
+
+#include <common/logger/logger.h>
+
+DeferredSave::DeferredSave(std::chrono::milliseconds delay, std::function<void()> save) :
+    m_delay(delay),
+    m_save(std::move(save)),
+    m_timer(CreateThreadpoolTimer(TimerCallback, this, nullptr))
+{
+    if (!m_timer)
+    {
+        Logger::error(L"Failed to create the deferred save timer, changes will be saved immediately");
+    }
+}
+
+void DeferredSave::Schedule() noexcept
+{
+    m_pending = true;
+    if (!m_timer)
+    {
+        try
+        {
+            RunIfPending();
+        }
+        catch (...)
+        {
+            Logger::error(L"Save failed");
+        }
+        return;
+    }
+
+    // Negative due time is relative, in 100ns units. Setting the timer again pushes the save back.
+    ULARGE_INTEGER dueTime{};
+    dueTime.QuadPart = static_cast<ULONGLONG>(-static_cast<LONGLONG>(m_delay.count()) * 10'000);
+    FILETIME fileDueTime{ dueTime.LowPart, dueTime.HighPart };
+    SetThreadpoolTimer(m_timer.get(), &fileDueTime, 0, 0);
+}
+
+void DeferredSave::Flush()
+{
+    if (m_timer)
+    {
+        SetThreadpoolTimer(m_timer.get(), nullptr, 0, 0);
+    }
+
+    RunIfPending();
+}
+
+void DeferredSave::SaveNow()
+{
+    m_pending = true;
+    Flush();
+}
+
+void DeferredSave::Cancel() noexcept
+{
+    if (m_timer)
+    {
+        SetThreadpoolTimer(m_timer.get(), nullptr, 0, 0);
+        WaitForThreadpoolTimerCallbacks(m_timer.get(), TRUE);
+    }
+
+    m_pending = false;
+}
+
+void CALLBACK DeferredSave::TimerCallback(PTP_CALLBACK_INSTANCE /*instance*/, PVOID context, PTP_TIMER /*timer*/)
+{
+    try
+    {
+        static_cast<DeferredSave*>(context)->RunIfPending();
+    }
+    catch (...)
+    {
+        Logger::error(L"Deferred save failed");
+    }
+}
+
+void DeferredSave::RunIfPending()
+{
+    std::lock_guard lock(m_saveMutex);
+    // Changes made while the save runs schedule another one
+    if (m_pending.exchange(false))
+    {
+        m_save();
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+
+// Coalesces save requests: the save runs on a thread pool thread once no new request has come in for
+// the given delay, so a burst of changes costs one write instead of one per change.
+// The save callback must be safe to run concurrently with the thread requesting saves.
+// Pending saves are dropped on destruction; call Flush() on shutdown to keep them.
+class DeferredSave
+{
+public:
+    DeferredSave(std::chrono::milliseconds delay, std::function<void()> save);
+    ~DeferredSave() = default;
+
+    DeferredSave(const DeferredSave&) = delete;
+    DeferredSave& operator=(const DeferredSave&) = delete;
+
+    // Requests a save, restarting the quiet period.
+    void Schedule() noexcept;
+
+    // Runs the pending save, if any, on the calling thread.
+    void Flush();
+
+    // Runs the save on the calling thread whether or not one is pending.
+    void SaveNow();
+
+    // Drops the pending save.
+    void Cancel() noexcept;
+
+    bool IsPending() const noexcept { return m_pending; }
+
+private:
+    static void CALLBACK TimerCallback(PTP_CALLBACK_INSTANCE instance, PVOID context, PTP_TIMER timer);
+    void RunIfPending();
+
+    const std::chrono::milliseconds m_delay;
+    const std::function<void()> m_save;
+    std::atomic<bool> m_pending = false;
+    // Keeps the timer callback and explicit saves from writing at the same time
+    std::mutex m_saveMutex;
+    wil::unique_threadpool_timer m_timer;
+};
@@ -587,10 +587,18 @@ namespace JSONHelpers
 
         root.SetNamedValue(NonLocalizable::AppZoneHistoryStr, JSONHelpers::SerializeAppZoneHistory(appZoneHistoryMap));
 
-        auto before = json::from_file(appZoneHistoryFileName);
-        if (!before.has_value() || before.value().Stringify() != root.Stringify())
+        std::string serialized = json::serialize(root);
+
+        // Comparing raw bytes is cheaper than parsing the previous file
+        if (json::read_file(appZoneHistoryFileName) == serialized)
+        {
+            return;
+        }
+
+        // The history is replaced in one step, so it's never left half written
+        if (!json::write_file_atomic(appZoneHistoryFileName, serialized))
         {
-            json::to_file(appZoneHistoryFileName, root);
+            Logger::error(L"Failed to write {}", appZoneHistoryFileName);
         }
     }
 
@@ -229,6 +229,7 @@ void FancyZonesSettings::LoadSettings(PCWSTR config, bool fromFile) noexcept
                     view.remove_prefix(1);
                 }
             }
+            m_settings.excludedAppsMatcher = ExcludedAppsMatcher(m_settings.excludedAppsArray);
         }
 
         if (auto val = values.get_int_value(NonLocalizable::ZoneHighlightOpacityID))
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <common/SettingsAPI/settings_objects.h>
+#include <common/utils/excluded_apps.h>
 
 enum struct OverlappingZonesAlgorithm : int
 {
@@ -46,6 +47,7 @@ struct Settings
     PowerToysSettings::HotkeyObject prevTabHotkey = PowerToysSettings::HotkeyObject::from_settings(true, false, false, false, VK_PRIOR);
     std::wstring excludedApps = L"";
     std::vector<std::wstring> excludedAppsArray;
+    ExcludedAppsMatcher excludedAppsMatcher;
 };
 
 interface __declspec(uuid("{BA4E77C4-6F44-4C5D-93D3-CBDE880495C2}")) IFancyZonesSettings : public IUnknown
@@ -1,6 +1,8 @@
 #include "pch.h"
 #include "VirtualDesktop.h"
 
+#include <FancyZonesLib/FancyZonesWindowProperties.h>
+
 #include <common/logger/logger.h>
 
 // Non-Localizable strings
@@ -202,14 +204,18 @@ std::optional<GUID> VirtualDesktop::GetDesktopId(HWND window) const
     return std::nullopt;
 }
 
-std::vector<std::pair<HWND, GUID>> VirtualDesktop::GetWindowsRelatedToDesktops() const
+std::vector<std::pair<HWND, GUID>> VirtualDesktop::GetZonedWindowsRelatedToDesktops() const
 {
     using result_t = std::vector<HWND>;
     result_t windows;
 
+    // Checking the zones property is much cheaper than asking the virtual desktop manager, so most windows are skipped before that
     auto callback = [](HWND window, LPARAM data) -> BOOL {
-        result_t& result = *reinterpret_cast<result_t*>(data);
-        result.push_back(window);
+        if (::GetPropW(window, ZonedWindowProperties::PropertyMultipleZoneID))
+        {
+            result_t& result = *reinterpret_cast<result_t*>(data);
+            result.push_back(window);
+        }
         return TRUE;
     };
     EnumWindows(callback, reinterpret_cast<LPARAM>(&windows));
@@ -38,7 +38,7 @@ public:
     std::optional<GUID> GetDesktopId(HWND window) const;
     std::optional<GUID> GetDesktopIdByTopLevelWindows() const;
 
-    std::vector<std::pair<HWND, GUID>> GetWindowsRelatedToDesktops() const;
+    std::vector<std::pair<HWND, GUID>> GetZonedWindowsRelatedToDesktops() const;
 
 private:
     std::function<void()> m_vdInitCallback;
@@ -0,0 +1,163 @@
+#include "pch.h"
+#include "ZoneHitTestIndex.h"
+
+#include <cmath>
+
+namespace
+{
+    constexpr size_t MAX_GRID_SIZE = 64;
+}
+
+ZoneHitTestIndex::ZoneHitTestIndex(const IZoneSet::ZonesMap& zones, int sensitivityRadius) :
+    m_sensitivityRadius(sensitivityRadius)
+{
+    m_ids.reserve(zones.size());
+    m_rects.reserve(zones.size());
+    for (const auto& [zoneId, zone] : zones)
+    {
+        m_ids.push_back(zoneId);
+        m_rects.push_back(zone->GetZoneRect());
+    }
+
+    const size_t count = m_ids.size();
+    if (count == 0)
+    {
+        return;
+    }
+
+    m_overlaps.resize(count * count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        for (size_t j = i + 1; j < count; ++j)
+        {
+            const RECT& rectI = m_rects[i];
+            const RECT& rectJ = m_rects[j];
+            if (std::max<LONG>(rectI.top, rectJ.top) + m_sensitivityRadius < std::min<LONG>(rectI.bottom, rectJ.bottom) &&
+                std::max<LONG>(rectI.left, rectJ.left) + m_sensitivityRadius < std::min<LONG>(rectI.right, rectJ.right))
+            {
+                m_overlaps[i * count + j] = true;
+                m_overlaps[j * count + i] = true;
+            }
+        }
+    }
+
+    // Inclusive bounds of the points each zone can capture, either within the sensitivity radius or strictly
+    std::vector<RECT> reach(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        const RECT& rect = m_rects[i];
+        reach[i] = RECT{ std::min<LONG>(rect.left - m_sensitivityRadius, rect.left),
+                         std::min<LONG>(rect.top - m_sensitivityRadius, rect.top),
+                         std::max<LONG>(rect.right + m_sensitivityRadius, rect.right - 1),
+                         std::max<LONG>(rect.bottom + m_sensitivityRadius, rect.bottom - 1) };
+    }
+
+    LONG right = reach[0].right;
+    LONG bottom = reach[0].bottom;
+    m_left = reach[0].left;
+    m_top = reach[0].top;
+    for (const RECT& rect : reach)
+    {
+        m_left = std::min<LONG>(m_left, rect.left);
+        m_top = std::min<LONG>(m_top, rect.top);
+        right = std::max<LONG>(right, rect.right);
+        bottom = std::max<LONG>(bottom, rect.bottom);
+    }
+
+    // Roughly one zone per cell along each axis for grid-like layouts
+    const size_t gridSize = std::clamp<size_t>(static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(count)))) * 2, 1, MAX_GRID_SIZE);
+    const LONG width = right - m_left + 1;
+    const LONG height = bottom - m_top + 1;
+    m_cellWidth = std::max<LONG>(1, (width + static_cast<LONG>(gridSize) - 1) / static_cast<LONG>(gridSize));
+    m_cellHeight = std::max<LONG>(1, (height + static_cast<LONG>(gridSize) - 1) / static_cast<LONG>(gridSize));
+    m_columns = static_cast<size_t>((width + m_cellWidth - 1) / m_cellWidth);
+    m_rows = static_cast<size_t>((height + m_cellHeight - 1) / m_cellHeight);
+
+    // Two passes to lay the per-cell zone lists out in one array
+    auto forEachCell = [&](const RECT& rect, auto&& func) {
+        if (rect.right < rect.left || rect.bottom < rect.top)
+        {
+            return;
+        }
+
+        const size_t firstColumn = static_cast<size_t>((rect.left - m_left) / m_cellWidth);
+        const size_t lastColumn = static_cast<size_t>((rect.right - m_left) / m_cellWidth);
+        const size_t firstRow = static_cast<size_t>((rect.top - m_top) / m_cellHeight);
+        const size_t lastRow = static_cast<size_t>((rect.bottom - m_top) / m_cellHeight);
+        for (size_t row = firstRow; row <= lastRow; ++row)
+        {
+            for (size_t column = firstColumn; column <= lastColumn; ++column)
+            {
+                func(row * m_columns + column);
+            }
+        }
+    };
+
+    m_cellStart.assign(m_columns * m_rows + 1, 0);
+    for (const RECT& rect : reach)
+    {
+        forEachCell(rect, [&](size_t cell) { ++m_cellStart[cell + 1]; });
+    }
+
+    for (size_t cell = 1; cell < m_cellStart.size(); ++cell)
+    {
+        m_cellStart[cell] += m_cellStart[cell - 1];
+    }
+
+    m_cellZones.resize(m_cellStart.back());
+    std::vector<size_t> next(m_cellStart.begin(), m_cellStart.end() - 1);
+    for (size_t i = 0; i < count; ++i)
+    {
+        forEachCell(reach[i], [&](size_t cell) { m_cellZones[next[cell]++] = i; });
+    }
+}
+
+ZoneHitTestIndex::HitTestResult ZoneHitTestIndex::HitTest(POINT pt) const
+{
+    HitTestResult result;
+    if (m_ids.empty() || pt.x < m_left || pt.y < m_top)
+    {
+        return result;
+    }
+
+    const size_t column = static_cast<size_t>((pt.x - m_left) / m_cellWidth);
+    const size_t row = static_cast<size_t>((pt.y - m_top) / m_cellHeight);
+    if (column >= m_columns || row >= m_rows)
+    {
+        return result;
+    }
+
+    const size_t cell = row * m_columns + column;
+    std::vector<size_t> captured;
+    for (size_t i = m_cellStart[cell]; i < m_cellStart[cell + 1]; ++i)
+    {
+        const size_t zone = m_cellZones[i];
+        if (Captures(zone, pt))
+        {
+            for (size_t other : captured)
+            {
+                result.overlapping = result.overlapping || m_overlaps[other * m_ids.size() + zone];
+            }
+            captured.push_back(zone);
+            result.capturedZones.push_back(m_ids[zone]);
+        }
+
+        result.strictlyCaptured = result.strictlyCaptured || StrictlyCaptures(zone, pt);
+    }
+
+    return result;
+}
+
+bool ZoneHitTestIndex::Captures(size_t zone, POINT pt) const noexcept
+{
+    const RECT& rect = m_rects[zone];
+    return rect.left - m_sensitivityRadius <= pt.x && pt.x <= rect.right + m_sensitivityRadius &&
+           rect.top - m_sensitivityRadius <= pt.y && pt.y <= rect.bottom + m_sensitivityRadius;
+}
+
+bool ZoneHitTestIndex::StrictlyCaptures(size_t zone, POINT pt) const noexcept
+{
+    const RECT& rect = m_rects[zone];
+    return rect.left <= pt.x && pt.x < rect.right &&
+           rect.top <= pt.y && pt.y < rect.bottom;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "ZoneSet.h"
+
+/**
+ * Lookup structure for ZoneSet::ZonesFromPoint, built once per layout.
+ * Zones are bucketed into a uniform grid over the layout, so a point is only tested against the zones
+ * sharing its cell, and whether two zones overlap is computed once instead of on every mouse move.
+ */
+class ZoneHitTestIndex
+{
+public:
+    struct HitTestResult
+    {
+        // Zones within the sensitivity radius of the point, in zone id order
+        ZoneIndexSet capturedZones;
+        // Whether the point is inside any zone itself
+        bool strictlyCaptured = false;
+        // Whether any two of the captured zones overlap
+        bool overlapping = false;
+    };
+
+    ZoneHitTestIndex(const IZoneSet::ZonesMap& zones, int sensitivityRadius);
+
+    HitTestResult HitTest(POINT pt) const;
+
+private:
+    bool Captures(size_t zone, POINT pt) const noexcept;
+    bool StrictlyCaptures(size_t zone, POINT pt) const noexcept;
+
+    int m_sensitivityRadius;
+    std::vector<ZoneIndex> m_ids;
+    std::vector<RECT> m_rects;
+    // m_overlaps[i * m_ids.size() + j] is set if zones i and j overlap
+    std::vector<bool> m_overlaps;
+
+    // Grid covering every point a zone can capture
+    LONG m_left = 0;
+    LONG m_top = 0;
+    LONG m_cellWidth = 1;
+    LONG m_cellHeight = 1;
+    size_t m_columns = 0;
+    size_t m_rows = 0;
+    // Zones of cell c are m_cellZones[m_cellStart[c]] to m_cellZones[m_cellStart[c + 1]], in zone id order
+    std::vector<size_t> m_cellStart;
+    std::vector<size_t> m_cellZones;
+};
@@ -7,6 +7,7 @@
 #include "FancyZonesWindowProperties.h"
 #include "Settings.h"
 #include "Zone.h"
+#include "ZoneHitTestIndex.h"
 #include "util.h"
 
 #include <common/logger/logger.h>
@@ -14,6 +15,8 @@
 
 #include <limits>
 #include <map>
+#include <mutex>
+#include <unordered_map>
 #include <utility>
 
 using namespace FancyZonesUtils;
@@ -103,6 +106,128 @@ namespace
             .columnsPercents = { 2500, 2500, 2500, 2500 },
             .cellChildMap = { { 0, 1, 2, 3 }, { 4, 1, 5, 6 }, { 7, 8, 9, 10 } } }),
     };
+
+    // Everything the zones of a layout are calculated from. Custom layouts are identified by their content,
+    // so editing a layout doesn't return the zones calculated before.
+    struct CalculatedZonesKey
+    {
+        FancyZonesDataTypes::ZoneSetLayoutType type;
+        long width;
+        long height;
+        int zoneCount;
+        int spacing;
+        // Only canvas layouts depend on the monitor DPI, 0 for the other layouts
+        UINT dpi;
+        std::vector<int> customLayout;
+
+        bool operator==(const CalculatedZonesKey& other) const = default;
+    };
+
+    struct CalculatedZonesKeyHash
+    {
+        size_t operator()(const CalculatedZonesKey& key) const noexcept
+        {
+            size_t hash = static_cast<size_t>(key.type);
+            const auto combine = [&hash](size_t value) { hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2); };
+            combine(key.width);
+            combine(key.height);
+            combine(key.zoneCount);
+            combine(key.spacing);
+            combine(key.dpi);
+            for (int value : key.customLayout)
+            {
+                combine(value);
+            }
+            return hash;
+        }
+    };
+
+    struct CalculatedZones
+    {
+        bool success;
+        IZoneSet::ZonesMap zones;
+    };
+
+    // Zones are immutable, so the zones calculated for a layout are shared by all the zone sets using the same layout
+    // on work areas of the same size, instead of being calculated and allocated again on each monitor or desktop change.
+    class CalculatedZonesCache
+    {
+    public:
+        static constexpr size_t MaxEntries = 64;
+
+        std::optional<CalculatedZones> Get(const CalculatedZonesKey& key)
+        {
+            std::scoped_lock lock(m_mutex);
+            auto iter = m_entries.find(key);
+            if (iter == m_entries.end())
+            {
+                return std::nullopt;
+            }
+            return iter->second;
+        }
+
+        void Set(CalculatedZonesKey key, CalculatedZones zones)
+        {
+            std::scoped_lock lock(m_mutex);
+            if (m_entries.size() >= MaxEntries)
+            {
+                m_entries.clear();
+            }
+            m_entries.insert_or_assign(std::move(key), std::move(zones));
+        }
+
+        void Clear() noexcept
+        {
+            std::scoped_lock lock(m_mutex);
+            m_entries.clear();
+        }
+
+    private:
+        std::mutex m_mutex;
+        std::unordered_map<CalculatedZonesKey, CalculatedZones, CalculatedZonesKeyHash> m_entries;
+    };
+
+    CalculatedZonesCache calculatedZonesCache;
+
+    UINT GetCanvasDpi(HMONITOR monitor)
+    {
+        // Same DPI as the one used by DPIAware::Convert
+        if (monitor == NULL)
+        {
+            monitor = MonitorFromPoint(POINT{ 0, 0 }, MONITOR_DEFAULTTOPRIMARY);
+        }
+
+        UINT dpiX, dpiY;
+        if (::GetDpiForMonitor(monitor, MDT_EFFECTIVE_DPI, &dpiX, &dpiY) == S_OK)
+        {
+            return dpiX;
+        }
+        return DPIAware::DEFAULT_DPI;
+    }
+
+    std::vector<int> FlattenCustomLayout(const FancyZonesDataTypes::CustomLayoutData& layout)
+    {
+        std::vector<int> result{ static_cast<int>(layout.type) };
+        if (const auto* canvas = std::get_if<FancyZonesDataTypes::CanvasLayoutInfo>(&layout.info))
+        {
+            for (const auto& zone : canvas->zones)
+            {
+                result.insert(result.end(), { zone.x, zone.y, zone.width, zone.height });
+            }
+        }
+        else if (const auto* grid = std::get_if<FancyZonesDataTypes::GridLayoutInfo>(&layout.info))
+        {
+            result.insert(result.end(), { grid->rows(), grid->columns() });
+            result.insert(result.end(), grid->rowsPercents().begin(), grid->rowsPercents().end());
+            result.insert(result.end(), grid->columnsPercents().begin(), grid->columnsPercents().end());
+            for (const auto& row : grid->cellChildMap())
+            {
+                result.push_back(static_cast<int>(row.size()));
+                result.insert(result.end(), row.begin(), row.end());
+            }
+        }
+        return result;
+    }
 }
 
 struct ZoneSet : winrt::implements<ZoneSet, IZoneSet>
@@ -153,7 +278,7 @@ private:
     bool CalculateColumnsAndRowsLayout(Rect workArea, FancyZonesDataTypes::ZoneSetLayoutType type, int zoneCount, int spacing) noexcept;
     bool CalculateGridLayout(Rect workArea, FancyZonesDataTypes::ZoneSetLayoutType type, int zoneCount, int spacing) noexcept;
     bool CalculateUniquePriorityGridLayout(Rect workArea, int zoneCount, int spacing) noexcept;
-    bool CalculateCustomLayout(Rect workArea, int spacing) noexcept;
+    bool CalculateCustomLayout(const std::optional<FancyZonesDataTypes::CustomLayoutData>& customLayout, Rect workArea, int spacing) noexcept;
     bool CalculateGridZones(Rect workArea, FancyZonesDataTypes::GridLayoutInfo gridLayoutInfo, int spacing);
     HWND GetNextTab(ZoneIndexSet indexSet, HWND current, bool reverse) noexcept;
     void InsertTabIntoZone(HWND window, std::optional<size_t> tabSortKeyWithinZone, const ZoneIndexSet& indexSet);
@@ -164,7 +289,12 @@ private:
     template<class CompareF>
     ZoneIndexSet ZoneSelectPriority(const ZoneIndexSet& capturedZones, CompareF compare) const;
 
+    // Adds the zone without rebuilding the hit-test index, for the layout calculations which build it once at the end.
+    bool InsertZone(winrt::com_ptr<IZone> zone);
+
     ZonesMap m_zones;
+    // Rebuilt whenever the zones change
+    std::optional<ZoneHitTestIndex> m_hitTestIndex;
     std::map<HWND, ZoneIndexSet> m_windowIndexSet;
     std::map<ZoneIndexSet, std::vector<HWND>> m_windowsByIndexSets;
 
@@ -177,77 +307,47 @@ private:
 };
 
 IFACEMETHODIMP ZoneSet::AddZone(winrt::com_ptr<IZone> zone) noexcept
+{
+    if (!InsertZone(zone))
+    {
+        return S_FALSE;
+    }
+    m_hitTestIndex.emplace(m_zones, m_config.SensitivityRadius);
+
+    return S_OK;
+}
+
+bool ZoneSet::InsertZone(winrt::com_ptr<IZone> zone)
 {
     auto zoneId = zone->Id();
     if (m_zones.contains(zoneId))
     {
-        return S_FALSE;
+        return false;
     }
     m_zones[zoneId] = zone;
 
-    return S_OK;
+    return true;
 }
 
 IFACEMETHODIMP_(ZoneIndexSet)
 ZoneSet::ZonesFromPoint(POINT pt) const noexcept
 {
-    ZoneIndexSet capturedZones;
-    ZoneIndexSet strictlyCapturedZones;
-    for (const auto& [zoneId, zone] : m_zones)
+    if (!m_hitTestIndex)
     {
-        const RECT& zoneRect = zone->GetZoneRect();
-        if (zoneRect.left - m_config.SensitivityRadius <= pt.x && pt.x <= zoneRect.right + m_config.SensitivityRadius &&
-            zoneRect.top - m_config.SensitivityRadius <= pt.y && pt.y <= zoneRect.bottom + m_config.SensitivityRadius)
-        {
-            capturedZones.emplace_back(zoneId);
-        }
-            
-        if (zoneRect.left <= pt.x && pt.x < zoneRect.right &&
-            zoneRect.top <= pt.y && pt.y < zoneRect.bottom)
-        {
-            strictlyCapturedZones.emplace_back(zoneId);
-        }
+        return {};
     }
 
+    auto [capturedZones, strictlyCaptured, overlap] = m_hitTestIndex->HitTest(pt);
+
     // If only one zone is captured, but it's not strictly captured
     // don't consider it as captured
-    if (capturedZones.size() == 1 && strictlyCapturedZones.size() == 0)
+    if (capturedZones.size() == 1 && !strictlyCaptured)
     {
         return {};
     }
 
     // If captured zones do not overlap, return all of them
     // Otherwise, return one of them based on the chosen selection algorithm.
-    bool overlap = false;
-    for (size_t i = 0; i < capturedZones.size(); ++i)
-    {
-        for (size_t j = i + 1; j < capturedZones.size(); ++j)
-        {
-            RECT rectI;
-            RECT rectJ;
-            try
-            {
-                rectI = m_zones.at(capturedZones[i])->GetZoneRect();
-                rectJ = m_zones.at(capturedZones[j])->GetZoneRect();
-            }
-            catch (std::out_of_range)
-            {
-                return {};
-            }
-
-            if (max(rectI.top, rectJ.top) + m_config.SensitivityRadius < min(rectI.bottom, rectJ.bottom) &&
-                max(rectI.left, rectJ.left) + m_config.SensitivityRadius < min(rectI.right, rectJ.right))
-            {
-                overlap = true;
-                break;
-            }
-        }
-        if (overlap)
-        {
-            break;
-        }
-    }
-
     if (overlap)
     {
         try
@@ -680,6 +780,35 @@ ZoneSet::CalculateZones(RECT workAreaRect, int zoneCount, int spacing) noexcept
         return false;
     }
 
+    std::optional<FancyZonesDataTypes::CustomLayoutData> customLayout;
+    if (m_config.LayoutType == FancyZonesDataTypes::ZoneSetLayoutType::Custom)
+    {
+        customLayout = CustomLayouts::instance().GetLayout(m_config.Id);
+    }
+
+    // Zone ids continue from the existing zones, so only an empty zone set can take the cached zones
+    std::optional<CalculatedZonesKey> cacheKey;
+    if (m_zones.empty())
+    {
+        const bool isCanvas = customLayout && customLayout->type == FancyZonesDataTypes::CustomLayoutType::Canvas;
+        cacheKey = CalculatedZonesKey{
+            .type = m_config.LayoutType,
+            .width = workArea.width(),
+            .height = workArea.height(),
+            .zoneCount = zoneCount,
+            .spacing = spacing,
+            .dpi = isCanvas ? GetCanvasDpi(m_config.Monitor) : 0,
+            .customLayout = customLayout ? FlattenCustomLayout(*customLayout) : std::vector<int>{}
+        };
+
+        if (auto cached = calculatedZonesCache.Get(*cacheKey))
+        {
+            m_zones = std::move(cached->zones);
+            m_hitTestIndex.emplace(m_zones, m_config.SensitivityRadius);
+            return cached->success;
+        }
+    }
+
     bool success = true;
     switch (m_config.LayoutType)
     {
@@ -695,10 +824,18 @@ ZoneSet::CalculateZones(RECT workAreaRect, int zoneCount, int spacing) noexcept
         success = CalculateGridLayout(workArea, m_config.LayoutType, zoneCount, spacing);
         break;
     case FancyZonesDataTypes::ZoneSetLayoutType::Custom:
-        success = CalculateCustomLayout(workArea, spacing);
+        success = CalculateCustomLayout(customLayout, workArea, spacing);
         break;
     }
 
+    if (cacheKey)
+    {
+        calculatedZonesCache.Set(std::move(*cacheKey), CalculatedZones{ success, m_zones });
+    }
+
+    // Hit-testing runs on every mouse move while dragging, build the index up front
+    m_hitTestIndex.emplace(m_zones, m_config.SensitivityRadius);
+
     return success;
 }
 
@@ -732,7 +869,7 @@ bool ZoneSet::CalculateFocusLayout(Rect workArea, int zoneCount) noexcept
         auto zone = MakeZone(focusZoneRect, m_zones.size());
         if (zone)
         {
-            AddZone(zone);
+            InsertZone(zone);
         }
         else
         {
@@ -789,7 +926,7 @@ bool ZoneSet::CalculateColumnsAndRowsLayout(Rect workArea, FancyZonesDataTypes::
         auto zone = MakeZone(RECT{ left, top, right, bottom }, m_zones.size());
         if (zone)
         {
-            AddZone(zone);
+            InsertZone(zone);
         }
         else
         {
@@ -878,15 +1015,14 @@ bool ZoneSet::CalculateUniquePriorityGridLayout(Rect workArea, int zoneCount, in
     return CalculateGridZones(workArea, predefinedPriorityGridLayouts[zoneCount - 1], spacing);
 }
 
-bool ZoneSet::CalculateCustomLayout(Rect workArea, int spacing) noexcept
+bool ZoneSet::CalculateCustomLayout(const std::optional<FancyZonesDataTypes::CustomLayoutData>& customLayout, Rect workArea, int spacing) noexcept
 {
-    const auto zoneSetSearchResult = CustomLayouts::instance().GetLayout(m_config.Id);
-    if (!zoneSetSearchResult.has_value())
+    if (!customLayout.has_value())
     {
         return false;
     }
 
-    const auto& zoneSet = *zoneSetSearchResult;
+    const auto& zoneSet = *customLayout;
     if (zoneSet.type == FancyZonesDataTypes::CustomLayoutType::Canvas && std::holds_alternative<FancyZonesDataTypes::CanvasLayoutInfo>(zoneSet.info))
     {
         const auto& zoneSetInfo = std::get<FancyZonesDataTypes::CanvasLayoutInfo>(zoneSet.info);
@@ -903,7 +1039,7 @@ bool ZoneSet::CalculateCustomLayout(Rect workArea, int spacing) noexcept
             auto zone = MakeZone(RECT{ x, y, x + width, y + height }, m_zones.size());
             if (zone)
             {
-                AddZone(zone);
+                InsertZone(zone);
             }
             else
             {
@@ -990,7 +1126,7 @@ bool ZoneSet::CalculateGridZones(Rect workArea, FancyZonesDataTypes::GridLayoutI
                 auto zone = MakeZone(RECT{ left, top, right, bottom }, i);
                 if (zone)
                 {
-                    AddZone(zone);
+                    InsertZone(zone);
                 }
                 else
                 {
@@ -1136,6 +1272,11 @@ ZoneIndexSet ZoneSet::ZoneSelectPriority(const ZoneIndexSet& capturedZones, Comp
     return { capturedZones[chosen] };
 }
 
+void ClearCalculatedZonesCache() noexcept
+{
+    calculatedZonesCache.Clear();
+}
+
 winrt::com_ptr<IZoneSet> MakeZoneSet(ZoneSetConfig const& config) noexcept
 {
     return winrt::make_self<ZoneSet>(config);
@@ -188,3 +188,7 @@ struct ZoneSetConfig
 };
 
 winrt::com_ptr<IZoneSet> MakeZoneSet(ZoneSetConfig const& config) noexcept;
+
+// Zone sets with the same layout on work areas of the same size share the zones calculated for the first of them.
+// Drops the shared zones, so the next CalculateZones calculates them again.
+void ClearCalculatedZonesCache() noexcept;
@@ -40,6 +40,46 @@ float ZonesOverlay::GetAnimationAlpha()
     return std::clamp(millis / FadeInDurationMillis, 0.001f, 1.f);
 }
 
+bool ZonesOverlay::ShouldRenderFrame()
+{
+    // Lock is held by the caller
+
+    // A frame is only drawn if the scene changed, or if the fade animation moved since the last frame
+    return m_abortThread || (m_shouldRender && (m_sceneChanged || GetAnimationAlpha() != m_renderedAlpha));
+}
+
+ID2D1SolidColorBrush* ZonesOverlay::GetBrush(const D2D1_COLOR_F& color)
+{
+    // Only a few colors are used, so a linear search is enough
+    for (const auto& [brushColor, brush] : m_brushes)
+    {
+        if (memcmp(&brushColor, &color, sizeof(color)) == 0)
+        {
+            return brush;
+        }
+    }
+
+    ID2D1SolidColorBrush* brush = nullptr;
+    m_renderTarget->CreateSolidColorBrush(color, &brush);
+    if (brush)
+    {
+        m_brushes.emplace_back(color, brush);
+    }
+    return brush;
+}
+
+bool ZonesOverlay::IsSameScene(const std::vector<DrawableRect>& first, const std::vector<DrawableRect>& second)
+{
+    return std::equal(first.begin(), first.end(), second.begin(), second.end(), [](const DrawableRect& a, const DrawableRect& b) {
+        return memcmp(&a.rect, &b.rect, sizeof(a.rect)) == 0 &&
+               memcmp(&a.borderColor, &b.borderColor, sizeof(a.borderColor)) == 0 &&
+               memcmp(&a.fillColor, &b.fillColor, sizeof(a.fillColor)) == 0 &&
+               memcmp(&a.textColor, &b.textColor, sizeof(a.textColor)) == 0 &&
+               a.id == b.id &&
+               a.showText == b.showText;
+    });
+}
+
 ID2D1Factory* ZonesOverlay::GetD2DFactory()
 {
     static auto pD2DFactory = [] {
@@ -106,6 +146,18 @@ ZonesOverlay::ZonesOverlay(HWND window)
         return;
     }
 
+    auto writeFactory = GetWriteFactory();
+    if (writeFactory)
+    {
+        writeFactory->CreateTextFormat(NonLocalizable::SegoeUiFont, nullptr, DWRITE_FONT_WEIGHT_NORMAL, DWRITE_FONT_STYLE_NORMAL, DWRITE_FONT_STRETCH_NORMAL, 80.f, L"en-US", &m_textFormat);
+    }
+
+    if (m_textFormat)
+    {
+        m_textFormat->SetTextAlignment(DWRITE_TEXT_ALIGNMENT_CENTER);
+        m_textFormat->SetParagraphAlignment(DWRITE_PARAGRAPH_ALIGNMENT_CENTER);
+    }
+
     m_renderThread = std::thread([this]() { RenderLoop(); });
 }
 
@@ -125,70 +177,42 @@ ZonesOverlay::RenderResult ZonesOverlay::Render()
         return RenderResult::AnimationEnded;
     }
 
+    m_sceneChanged = false;
+    m_renderedAlpha = animationAlpha;
+
     m_renderTarget->BeginDraw();
 
     // Draw backdrop
     m_renderTarget->Clear(D2D1::ColorF(0.f, 0.f, 0.f, 0.f));
 
-    IDWriteTextFormat* textFormat = nullptr;
-
-    auto writeFactory = GetWriteFactory();
-
-    if (writeFactory)
-    {
-        writeFactory->CreateTextFormat(NonLocalizable::SegoeUiFont, nullptr, DWRITE_FONT_WEIGHT_NORMAL, DWRITE_FONT_STYLE_NORMAL, DWRITE_FONT_STRETCH_NORMAL, 80.f, L"en-US", &textFormat);
-    }
-
-    for (auto drawableRect : m_sceneRects)
+    for (const auto& drawableRect : m_sceneRects)
     {
-        ID2D1SolidColorBrush* textBrush = nullptr;
-        ID2D1SolidColorBrush* borderBrush = nullptr;
-        ID2D1SolidColorBrush* fillBrush = nullptr;
-
-        // Need to copy the rect from m_sceneRects
-        drawableRect.borderColor.a *= animationAlpha;
-        drawableRect.fillColor.a *= animationAlpha;
-
-        m_renderTarget->CreateSolidColorBrush(drawableRect.borderColor, &borderBrush);
-        m_renderTarget->CreateSolidColorBrush(drawableRect.fillColor, &fillBrush);
-
+        // The brushes are shared between zones, the animation is applied through their opacity
+        auto fillBrush = GetBrush(drawableRect.fillColor);
         if (fillBrush)
         {
+            fillBrush->SetOpacity(animationAlpha);
             m_renderTarget->FillRectangle(drawableRect.rect, fillBrush);
-            fillBrush->Release();
         }
 
+        auto borderBrush = GetBrush(drawableRect.borderColor);
         if (borderBrush)
         {
+            borderBrush->SetOpacity(animationAlpha);
             m_renderTarget->DrawRectangle(drawableRect.rect, borderBrush);
-            borderBrush->Release();
         }
 
-        std::wstring idStr = std::to_wstring(drawableRect.id + 1);
-
         if (drawableRect.showText)
         {
-            m_renderTarget->CreateSolidColorBrush(drawableRect.textColor, &textBrush);
-
-            if (textFormat && textBrush)
+            auto textBrush = GetBrush(drawableRect.textColor);
+            if (m_textFormat && textBrush)
             {
-                textFormat->SetTextAlignment(DWRITE_TEXT_ALIGNMENT_CENTER);
-                textFormat->SetParagraphAlignment(DWRITE_PARAGRAPH_ALIGNMENT_CENTER);
-                m_renderTarget->DrawTextW(idStr.c_str(), (UINT32)idStr.size(), textFormat, drawableRect.rect, textBrush);
-            }
-
-            if (textBrush)
-            {
-                textBrush->Release();
+                textBrush->SetOpacity(1.f);
+                m_renderTarget->DrawTextW(drawableRect.text.c_str(), (UINT32)drawableRect.text.size(), m_textFormat, drawableRect.rect, textBrush);
             }
         }
     }
 
-    if (textFormat)
-    {
-        textFormat->Release();
-    }
-
     // The lock must be released here, as EndDraw() will wait for vertical sync
     lock.unlock();
 
@@ -201,9 +225,18 @@ void ZonesOverlay::RenderLoop()
     while (!m_abortThread)
     {
         {
-            // Wait here while rendering is disabled
+            // Wait here while rendering is disabled or there is nothing new to draw
             std::unique_lock lock(m_mutex);
-            m_cv.wait(lock, [this]() { return (bool)m_shouldRender; });
+            if (m_shouldRender && m_animation && m_animation->autoHide)
+            {
+                // Wake up when flashing ends, to hide the zones
+                const auto flashEnd = m_animation->tStart + std::chrono::milliseconds(FlashZonesDurationMillis);
+                m_cv.wait_until(lock, flashEnd, [this]() { return ShouldRenderFrame(); });
+            }
+            else
+            {
+                m_cv.wait(lock, [this]() { return ShouldRenderFrame(); });
+            }
         }
 
         auto result = Render();
@@ -241,6 +274,8 @@ void ZonesOverlay::Show()
         shouldShowWindow = !m_shouldRender;
         m_shouldRender = true;
 
+        m_sceneChanged |= shouldShowWindow;
+
         if (!m_animation)
         {
             m_animation.emplace(AnimationInfo{ .tStart = std::chrono::steady_clock().now(), .autoHide = false });
@@ -269,6 +304,8 @@ void ZonesOverlay::Flash()
         shouldShowWindow = !m_shouldRender;
         m_shouldRender = true;
 
+        m_sceneChanged |= shouldShowWindow;
+
         m_animation.emplace(AnimationInfo{ .tStart = std::chrono::steady_clock().now(), .autoHide = true });
     }
 
@@ -286,9 +323,7 @@ void ZonesOverlay::DrawActiveZoneSet(const IZoneSet::ZonesMap& zones,
                                      const bool showZoneText)
 {
     _TRACER_;
-    std::unique_lock lock(m_mutex);
-
-    m_sceneRects = {};
+    std::vector<DrawableRect> sceneRects;
 
     auto borderColor = ConvertColor(colors.borderColor);
     auto inactiveColor = ConvertColor(colors.primaryColor);
@@ -320,10 +355,11 @@ void ZonesOverlay::DrawActiveZoneSet(const IZoneSet::ZonesMap& zones,
                 .fillColor = inactiveColor,
                 .textColor = numberColor,
                 .id = zone->Id(),
-                .showText = showZoneText
+                .showText = showZoneText,
+                .text = showZoneText ? std::to_wstring(zone->Id() + 1) : std::wstring{}
             };
 
-            m_sceneRects.push_back(drawableRect);
+            sceneRects.push_back(std::move(drawableRect));
         }
     }
 
@@ -343,12 +379,26 @@ void ZonesOverlay::DrawActiveZoneSet(const IZoneSet::ZonesMap& zones,
                 .fillColor = highlightColor,
                 .textColor = numberColor,
                 .id = zone->Id(),
-                .showText = showZoneText
+                .showText = showZoneText,
+                .text = showZoneText ? std::to_wstring(zone->Id() + 1) : std::wstring{}
             };
 
-            m_sceneRects.push_back(drawableRect);
+            sceneRects.push_back(std::move(drawableRect));
         }
     }
+
+    {
+        std::unique_lock lock(m_mutex);
+        if (IsSameScene(m_sceneRects, sceneRects))
+        {
+            return;
+        }
+
+        m_sceneRects = std::move(sceneRects);
+        m_sceneChanged = true;
+    }
+
+    m_cv.notify_all();
 }
 
 ZonesOverlay::~ZonesOverlay()
@@ -361,6 +411,16 @@ ZonesOverlay::~ZonesOverlay()
     m_cv.notify_all();
     m_renderThread.join();
 
+    for (const auto& [color, brush] : m_brushes)
+    {
+        brush->Release();
+    }
+
+    if (m_textFormat)
+    {
+        m_textFormat->Release();
+    }
+
     if (m_renderTarget)
     {
         m_renderTarget->Release();
@@ -23,6 +23,7 @@ class ZonesOverlay
         D2D1_COLOR_F textColor;
         ZoneIndex id;
         bool showText;
+        std::wstring text;
     };
 
     struct AnimationInfo
@@ -45,8 +46,19 @@ class ZonesOverlay
 
     std::mutex m_mutex;
     std::vector<DrawableRect> m_sceneRects;
+    // Set when the scene changes, and cleared once a frame is drawn
+    bool m_sceneChanged = false;
+    // Animation alpha of the last drawn frame, a new frame is only needed if it changed
+    float m_renderedAlpha = 0.f;
+
+    // Resources are created once and reused by every frame. They're only used by the render thread.
+    IDWriteTextFormat* m_textFormat = nullptr;
+    std::vector<std::pair<D2D1_COLOR_F, ID2D1SolidColorBrush*>> m_brushes;
 
     float GetAnimationAlpha();
+    bool ShouldRenderFrame();
+    ID2D1SolidColorBrush* GetBrush(const D2D1_COLOR_F& color);
+    static bool IsSameScene(const std::vector<DrawableRect>& first, const std::vector<DrawableRect>& second);
     static ID2D1Factory* GetD2DFactory();
     static IDWriteFactory* GetWriteFactory();
     static D2D1_COLOR_F ConvertColor(COLORREF color);
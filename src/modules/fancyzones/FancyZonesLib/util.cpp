@@ -3,9 +3,11 @@
 #include "Settings.h"
 
 #include <common/display/dpi_aware.h>
+#include <common/utils/excluded_apps.h>
 #include <common/utils/process_path.h>
 #include <common/utils/window.h>
 
+#include <algorithm>
 #include <array>
 #include <complex>
 #include <wil/Resource.h>
@@ -20,31 +22,22 @@ namespace NonLocalizable
     const wchar_t SplashClassName[] = L"MsoSplash";
 }
 
-bool find_app_name_in_path(const std::wstring& where, const std::vector<std::wstring>& what)
-{
-    for (const auto& row : what)
-    {
-        const auto pos = where.rfind(row);
-        const auto last_slash = where.rfind('\\');
-        //Check that row occurs in where, and its last occurrence contains in itself the first character after the last backslash.
-        if (pos != std::wstring::npos && pos <= last_slash + 1 && pos + row.length() > last_slash)
-        {
-            return true;
-        }
-    }
-    return false;
-}
 namespace
 {
-    bool IsZonableByProcessPath(const std::wstring& processPath, const std::vector<std::wstring>& excludedApps)
+    // Windows collected by the DeferredWindowSizing alive on this thread
+    thread_local std::vector<std::pair<HWND, RECT>>* deferredWindowSizes = nullptr;
+
+    bool IsZonableByProcessPath(std::wstring processPath, const ExcludedAppsMatcher& excludedApps)
     {
+        static const ExcludedAppsMatcher editor({ NonLocalizable::PowerToysAppFZEditor });
+
         // Filter out user specified apps
-        CharUpperBuffW(const_cast<std::wstring&>(processPath).data(), (DWORD)processPath.length());
-        if (find_app_name_in_path(processPath, excludedApps))
+        CharUpperBuffW(processPath.data(), (DWORD)processPath.length());
+        if (excludedApps.Matches(processPath))
         {
             return false;
         }
-        if (find_app_name_in_path(processPath, { NonLocalizable::PowerToysAppFZEditor }))
+        if (editor.Matches(processPath))
         {
             return false;
         }
@@ -329,6 +322,12 @@ namespace FancyZonesUtils
 
     void SizeWindowToRect(HWND window, RECT rect) noexcept
     {
+        if (deferredWindowSizes)
+        {
+            deferredWindowSizes->emplace_back(window, rect);
+            return;
+        }
+
         WINDOWPLACEMENT placement{};
         ::GetWindowPlacement(window, &placement);
 
@@ -339,6 +338,17 @@ namespace FancyZonesUtils
             ::GetWindowPlacement(window, &placement);
         }
 
+        ScreenToWorkAreaCoords(window, rect);
+        placement = GetPlacementForRect(placement, rect);
+
+        ::SetWindowPlacement(window, &placement);
+        // Do it again, allowing Windows to resize the window and set correct scaling
+        // This fixes Issue #365
+        ::SetWindowPlacement(window, &placement);
+    }
+
+    WINDOWPLACEMENT GetPlacementForRect(WINDOWPLACEMENT placement, RECT rect) noexcept
+    {
         // Do not restore minimized windows. We change their placement though so they restore to the correct zone.
         if ((placement.showCmd != SW_SHOWMINIMIZED) &&
             (placement.showCmd != SW_MINIMIZE))
@@ -353,15 +363,58 @@ namespace FancyZonesUtils
             placement.flags &= ~WPF_RESTORETOMAXIMIZED;
         }
 
-        ScreenToWorkAreaCoords(window, rect);
-
         placement.rcNormalPosition = rect;
         placement.flags |= WPF_ASYNCWINDOWPLACEMENT;
+        return placement;
+    }
 
-        ::SetWindowPlacement(window, &placement);
-        // Do it again, allowing Windows to resize the window and set correct scaling
-        // This fixes Issue #365
-        ::SetWindowPlacement(window, &placement);
+    DeferredWindowSizing::DeferredWindowSizing() noexcept
+    {
+        // Nested scopes leave the sizing to the outermost one
+        if (!deferredWindowSizes)
+        {
+            deferredWindowSizes = &m_windows;
+            m_active = true;
+        }
+    }
+
+    DeferredWindowSizing::~DeferredWindowSizing() noexcept
+    {
+        if (!m_active)
+        {
+            return;
+        }
+        deferredWindowSizes = nullptr;
+
+        std::vector<WINDOWPLACEMENT> placements(m_windows.size(), WINDOWPLACEMENT{ sizeof(WINDOWPLACEMENT) });
+        for (size_t i = 0; i < m_windows.size(); ++i)
+        {
+            ::GetWindowPlacement(m_windows[i].first, &placements[i]);
+        }
+
+        // Wait if SW_SHOWMINIMIZED would be removed from windows (Issue #1685), once for all of them
+        const auto isBeingMinimized = [](const WINDOWPLACEMENT& placement) { return placement.showCmd == SW_SHOWMINIMIZED; };
+        for (int i = 0; i < 5 && std::any_of(placements.begin(), placements.end(), isBeingMinimized); ++i)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            for (size_t j = 0; j < m_windows.size(); ++j)
+            {
+                if (isBeingMinimized(placements[j]))
+                {
+                    ::GetWindowPlacement(m_windows[j].first, &placements[j]);
+                }
+            }
+        }
+
+        // Done twice like in SizeWindowToRect, allowing Windows to set correct scaling (Issue #365)
+        for (size_t i = 0; i < m_windows.size(); ++i)
+        {
+            auto [window, rect] = m_windows[i];
+            ScreenToWorkAreaCoords(window, rect);
+            const auto placement = GetPlacementForRect(placements[i], rect);
+            ::SetWindowPlacement(window, &placement);
+            ::SetWindowPlacement(window, &placement);
+        }
     }
 
     void SwitchToWindow(HWND window) noexcept
@@ -441,7 +494,7 @@ namespace FancyZonesUtils
         return true;
     }
 
-    bool IsCandidateForZoning(HWND window, const std::vector<std::wstring>& excludedApps) noexcept
+    bool IsCandidateForZoning(HWND window, const ExcludedAppsMatcher& excludedApps) noexcept
     {
         auto zonable = IsStandardWindow(window) && HasNoVisibleOwner(window);
         if (!zonable)
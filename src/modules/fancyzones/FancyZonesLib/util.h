@@ -3,6 +3,8 @@
 #include "gdiplus.h"
 #include <common/utils/string_utils.h>
 
+class ExcludedAppsMatcher;
+
 namespace FancyZonesDataTypes
 {
     struct DeviceIdData;
@@ -195,11 +197,31 @@ namespace FancyZonesUtils
     // Parameter rect must be in screen coordinates (e.g. obtained from GetWindowRect)
     void SizeWindowToRect(HWND window, RECT rect) noexcept;
 
+    // Parameter rect is in workspace coordinates. Minimized windows stay minimized, others are restored
+    WINDOWPLACEMENT GetPlacementForRect(WINDOWPLACEMENT placement, RECT rect) noexcept;
+
+    // While alive, SizeWindowToRect calls made on the same thread are collected instead of being applied.
+    // They are applied on destruction, and the wait for windows being minimized is shared instead of being
+    // made for each window.
+    class DeferredWindowSizing
+    {
+    public:
+        DeferredWindowSizing() noexcept;
+        ~DeferredWindowSizing() noexcept;
+
+        DeferredWindowSizing(const DeferredWindowSizing&) = delete;
+        DeferredWindowSizing& operator=(const DeferredWindowSizing&) = delete;
+
+    private:
+        std::vector<std::pair<HWND, RECT>> m_windows;
+        bool m_active = false;
+    };
+
     void SwitchToWindow(HWND window) noexcept;
 
     bool HasNoVisibleOwner(HWND window) noexcept;
     bool IsStandardWindow(HWND window);
-    bool IsCandidateForZoning(HWND window, const std::vector<std::wstring>& excludedApps) noexcept;
+    bool IsCandidateForZoning(HWND window, const ExcludedAppsMatcher& excludedApps) noexcept;
 
     bool IsWindowMaximized(HWND window) noexcept;
     void SaveWindowSizeAndOrigin(HWND window) noexcept;
@@ -2,6 +2,9 @@
 #include <filesystem>
 
 #include <FancyZonesLib/FancyZonesData/AppZoneHistory.h>
+#include <FancyZonesLib/FancyZonesData/DeferredSave.h>
+
+#include <common/utils/json.h>
 
 #include "util.h"
 
@@ -21,6 +24,8 @@ namespace FancyZonesUnitTests
 
         TEST_METHOD_CLEANUP(CleanUp)
         {
+            // Write pending changes now, so they can't recreate the file after it's removed
+            AppZoneHistory::instance().FlushPendingChanges();
             std::filesystem::remove(AppZoneHistory::instance().AppZoneHistoryFileName());
         }
 
@@ -125,5 +130,105 @@ namespace FancyZonesUnitTests
 
             Assert::IsFalse(AppZoneHistory::instance().RemoveAppLastZone(nullptr, deviceId, zoneSetId));
         }
+
+        TEST_METHOD (AppLastZoneSnapsAreSavedOnFlush)
+        {
+            const std::wstring zoneSetId = L"{2FEC41DA-3A0B-4E31-9CE1-9473C65D99F2}";
+            const FancyZonesDataTypes::DeviceIdData deviceId{ L"DELA026#5&10a58c63&0&UID16777488_2194_1234_{39B25DD2-130D-4B5D-8851-4791D66B1539}" };
+            const auto window = Mocks::WindowCreate(m_hInst);
+            const auto file = AppZoneHistory::AppZoneHistoryFileName();
+            std::filesystem::remove(file);
+
+            for (int i = 0; i < 1000; i++)
+            {
+                Assert::IsTrue(AppZoneHistory::instance().SetAppLastZones(window, deviceId, zoneSetId, { static_cast<ZoneIndex>(i % 4) }));
+            }
+
+            Assert::IsFalse(std::filesystem::exists(file));
+            AppZoneHistory::instance().FlushPendingChanges();
+            Assert::IsTrue(std::filesystem::exists(file));
+            Assert::IsFalse(std::filesystem::exists(file + L".tmp"));
+
+            AppZoneHistory::instance().LoadData();
+            Assert::IsTrue(std::vector<ZoneIndex>{ 3 } == AppZoneHistory::instance().GetAppLastZoneIndexSet(window, deviceId, zoneSetId));
+        }
+    };
+
+    TEST_CLASS (DeferredSaveUnitTests)
+    {
+        TEST_METHOD (BurstIsSavedOnce)
+        {
+            // The injected writer saves the latest value to a file and counts how often it runs
+            const std::wstring file = (std::filesystem::temp_directory_path() / L"FancyZonesDeferredSaveTest.json").wstring();
+            std::filesystem::remove(file);
+
+            std::atomic<int> value = 0;
+            std::atomic<int> saves = 0;
+            std::atomic<bool> written = true;
+            DeferredSave deferredSave(std::chrono::seconds(10), [&] {
+                saves++;
+                json::JsonObject root{};
+                root.SetNamedValue(L"value", json::value(value.load()));
+                written = written && json::write_file_atomic(file, json::serialize(root));
+            });
+
+            for (int i = 1; i <= 1000; i++)
+            {
+                value = i;
+                deferredSave.Schedule();
+            }
+
+            Assert::AreEqual(0, saves.load());
+            Assert::IsFalse(std::filesystem::exists(file));
+            Assert::IsTrue(deferredSave.IsPending());
+
+            deferredSave.Flush();
+            Assert::AreEqual(1, saves.load());
+            Assert::IsTrue(written.load());
+            Assert::IsFalse(deferredSave.IsPending());
+
+            // The file holds the state at the end of the burst
+            auto saved = json::from_file(file);
+            Assert::IsTrue(saved.has_value());
+            Assert::AreEqual(1000.0, saved->GetNamedNumber(L"value"));
+
+            deferredSave.Flush();
+            Assert::AreEqual(1, saves.load());
+
+            std::filesystem::remove(file);
+        }
+
+        TEST_METHOD (SavedAfterQuietPeriod)
+        {
+            std::atomic<int> saves = 0;
+            DeferredSave deferredSave(std::chrono::milliseconds(50), [&] { saves++; });
+
+            for (int i = 0; i < 100; i++)
+            {
+                deferredSave.Schedule();
+            }
+
+            for (int i = 0; i < 100 && saves == 0; i++)
+            {
+                Sleep(20);
+            }
+
+            Assert::AreEqual(1, saves.load());
+            Assert::IsFalse(deferredSave.IsPending());
+        }
+
+        TEST_METHOD (CancelDropsPendingSave)
+        {
+            int saves = 0;
+            DeferredSave deferredSave(std::chrono::seconds(10), [&] { saves++; });
+
+            deferredSave.Schedule();
+            deferredSave.Cancel();
+            deferredSave.Flush();
+            Assert::AreEqual(0, saves);
+
+            deferredSave.SaveNow();
+            Assert::AreEqual(1, saves);
+        }
     };
 }
\ No newline at end of file
@@ -368,6 +368,72 @@ namespace FancyZonesUnitTests
             const auto actual = HexToRGB(L"zzz");
             Assert::AreEqual(expected, actual);
         }
+
+        TEST_METHOD (TestGetPlacementForRect_restoresMaximized)
+        {
+            WINDOWPLACEMENT placement{ sizeof(WINDOWPLACEMENT) };
+            placement.showCmd = SW_SHOWMAXIMIZED;
+            const RECT rect{ 10, 20, 110, 220 };
+
+            const auto actual = GetPlacementForRect(placement, rect);
+            Assert::AreEqual(static_cast<UINT>(SW_RESTORE), actual.showCmd);
+            Assert::IsTrue(actual.flags & WPF_ASYNCWINDOWPLACEMENT);
+            Assert::AreEqual(rect.left, actual.rcNormalPosition.left);
+            Assert::AreEqual(rect.bottom, actual.rcNormalPosition.bottom);
+        }
+
+        TEST_METHOD (TestGetPlacementForRect_keepsMinimized)
+        {
+            WINDOWPLACEMENT placement{ sizeof(WINDOWPLACEMENT) };
+            placement.showCmd = SW_SHOWMINIMIZED;
+            const RECT rect{ 10, 20, 110, 220 };
+
+            const auto actual = GetPlacementForRect(placement, rect);
+            Assert::AreEqual(static_cast<UINT>(SW_SHOWMINIMIZED), actual.showCmd);
+            Assert::AreEqual(rect.right, actual.rcNormalPosition.right);
+        }
+
+        TEST_METHOD (TestDeferredWindowSizing_sizesOnDestruction)
+        {
+            const auto hInst = (HINSTANCE)GetModuleHandleW(nullptr);
+            const auto deferredWindow = Mocks::WindowCreate(hInst);
+            const auto directWindow = Mocks::WindowCreate(hInst);
+            const RECT rect{ 50, 60, 250, 260 };
+
+            const auto normalPosition = [](HWND window) {
+                WINDOWPLACEMENT placement{ sizeof(WINDOWPLACEMENT) };
+                GetWindowPlacement(window, &placement);
+                return placement.rcNormalPosition;
+            };
+            const RECT initialPosition = normalPosition(deferredWindow);
+
+            {
+                DeferredWindowSizing deferredSizing;
+                {
+                    // Nested scopes leave the sizing to the outermost one
+                    DeferredWindowSizing nestedSizing;
+                    SizeWindowToRect(deferredWindow, rect);
+                }
+                CustomAssert::AreEqual(initialPosition, normalPosition(deferredWindow));
+            }
+            SizeWindowToRect(directWindow, rect);
+
+            // Both windows are placed asynchronously
+            RECT directPosition{}, deferredPosition{};
+            for (int i = 0; i < 40; ++i)
+            {
+                directPosition = normalPosition(directWindow);
+                deferredPosition = normalPosition(deferredWindow);
+                if (!EqualRect(&directPosition, &initialPosition) && EqualRect(&directPosition, &deferredPosition))
+                {
+                    break;
+                }
+                Sleep(50);
+            }
+
+            Assert::IsFalse(EqualRect(&directPosition, &initialPosition));
+            CustomAssert::AreEqual(directPosition, deferredPosition);
+        }
     };
 }
 
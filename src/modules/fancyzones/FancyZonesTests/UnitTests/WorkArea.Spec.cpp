@@ -79,6 +79,7 @@ namespace FancyZonesUnitTests
         TEST_METHOD_CLEANUP(CleanUp)
         {
             std::filesystem::remove(AppliedLayouts::AppliedLayoutsFileName());
+            AppZoneHistory::instance().FlushPendingChanges();
             std::filesystem::remove(AppZoneHistory::AppZoneHistoryFileName());
         }
 
@@ -239,6 +240,7 @@ namespace FancyZonesUnitTests
 
         TEST_METHOD_CLEANUP(CleanUp)
         {
+            AppZoneHistory::instance().FlushPendingChanges();
             std::filesystem::remove(AppZoneHistory::AppZoneHistoryFileName());
             std::filesystem::remove(AppliedLayouts::AppliedLayoutsFileName());
         }
@@ -4,8 +4,10 @@
 #include "FancyZonesLib\JsonHelpers.h"
 #include "FancyZonesLib\VirtualDesktop.h"
 #include "FancyZonesLib\ZoneSet.h"
+#include "FancyZonesLib\ZoneHitTestIndex.h"
 
 #include <filesystem>
+#include <random>
 
 #include "Util.h"
 #include <common/SettingsAPI/settings_helpers.h>
@@ -293,6 +295,68 @@ namespace FancyZonesUnitTests
                 compareZones(zone4, m_set->GetZones()[actual[3]]);
             }
 
+            TEST_METHOD (ZoneHitTestIndexMatchesFullScan)
+            {
+                std::mt19937 random(42);
+                const int radius = DefaultValues::SensitivityRadius;
+                for (ZoneIndex id = 0; id < 100; id++)
+                {
+                    const LONG left = random() % 3000, top = random() % 1000;
+                    m_set->AddZone(MakeZone({ left, top, left + static_cast<LONG>(random() % 600), top + static_cast<LONG>(random() % 600) }, id));
+                }
+
+                const auto zones = m_set->GetZones();
+                ZoneHitTestIndex index(zones, radius);
+                for (int i = 0; i < 10000; i++)
+                {
+                    const POINT pt{ static_cast<LONG>(random() % 3800) - 100, static_cast<LONG>(random() % 1800) - 100 };
+
+                    ZoneIndexSet expectedZones;
+                    bool expectedStrict = false;
+                    for (const auto& [id, zone] : zones)
+                    {
+                        const RECT rect = zone->GetZoneRect();
+                        if (rect.left - radius <= pt.x && pt.x <= rect.right + radius && rect.top - radius <= pt.y && pt.y <= rect.bottom + radius)
+                        {
+                            expectedZones.push_back(id);
+                        }
+                        expectedStrict = expectedStrict || (rect.left <= pt.x && pt.x < rect.right && rect.top <= pt.y && pt.y < rect.bottom);
+                    }
+
+                    bool expectedOverlap = false;
+                    for (size_t a = 0; a < expectedZones.size(); a++)
+                    {
+                        for (size_t b = a + 1; b < expectedZones.size(); b++)
+                        {
+                            const RECT rectA = zones.at(expectedZones[a])->GetZoneRect();
+                            const RECT rectB = zones.at(expectedZones[b])->GetZoneRect();
+                            expectedOverlap = expectedOverlap ||
+                                              (std::max<LONG>(rectA.top, rectB.top) + radius < std::min<LONG>(rectA.bottom, rectB.bottom) &&
+                                               std::max<LONG>(rectA.left, rectB.left) + radius < std::min<LONG>(rectA.right, rectB.right));
+                        }
+                    }
+
+                    const auto actual = index.HitTest(pt);
+                    Assert::IsTrue(expectedZones == actual.capturedZones);
+                    Assert::AreEqual(expectedStrict, actual.strictlyCaptured);
+                    Assert::AreEqual(expectedOverlap, actual.overlapping);
+                }
+            }
+
+            TEST_METHOD (ZoneFromPointAfterAddZone)
+            {
+                winrt::com_ptr<IZone> zone1 = MakeZone({ 0, 0, 100, 100 }, 1);
+                m_set->AddZone(zone1);
+                Assert::IsTrue(m_set->ZonesFromPoint(POINT{ 150, 50 }).empty());
+
+                // Adding a zone has to invalidate the hit-test index built by the previous lookup
+                winrt::com_ptr<IZone> zone2 = MakeZone({ 100, 0, 200, 100 }, 2);
+                m_set->AddZone(zone2);
+                auto actual = m_set->ZonesFromPoint(POINT{ 150, 50 });
+                Assert::IsTrue(actual.size() == 1);
+                compareZones(zone2, m_set->GetZones()[actual[0]]);
+            }
+
             TEST_METHOD (ZoneIndexFromWindowUnknown)
             {
                 winrt::com_ptr<IZone> zone = MakeZone({ 0, 0, 100, 100 }, 1);
@@ -957,6 +1021,69 @@ namespace FancyZonesUnitTests
                     }
                 }
 
+                TEST_METHOD (SameLayoutOnSameWorkAreaSize)
+                {
+                    const int spacing = 7;
+                    const int zoneCount = 7;
+
+                    for (int type = static_cast<int>(ZoneSetLayoutType::Focus); type < static_cast<int>(ZoneSetLayoutType::Custom); type++)
+                    {
+                        ZoneSetConfig m_config = ZoneSetConfig(m_id, static_cast<ZoneSetLayoutType>(type), m_monitor, DefaultValues::SensitivityRadius);
+
+                        for (const auto& monitorInfo : m_popularMonitors)
+                        {
+                            ClearCalculatedZonesCache();
+                            auto set = MakeZoneSet(m_config);
+                            Assert::IsTrue(set->CalculateZones(monitorInfo.rcWork, zoneCount, spacing));
+
+                            // The second zone set gets the zones calculated for the first one
+                            auto cachedSet = MakeZoneSet(m_config);
+                            Assert::IsTrue(cachedSet->CalculateZones(monitorInfo.rcWork, zoneCount, spacing));
+
+                            // Calculated again without the cache, for reference
+                            ClearCalculatedZonesCache();
+                            auto uncachedSet = MakeZoneSet(m_config);
+                            Assert::IsTrue(uncachedSet->CalculateZones(monitorInfo.rcWork, zoneCount, spacing));
+
+                            // A work area of another size doesn't get the zones cached for the reference
+                            RECT otherSizeWorkArea = monitorInfo.rcWork;
+                            otherSizeWorkArea.right -= 1;
+                            auto otherSizeSet = MakeZoneSet(m_config);
+                            Assert::IsTrue(otherSizeSet->CalculateZones(otherSizeWorkArea, zoneCount, spacing));
+
+                            auto otherSpacingSet = MakeZoneSet(m_config);
+                            Assert::IsTrue(otherSpacingSet->CalculateZones(monitorInfo.rcWork, zoneCount, spacing + 1));
+
+                            const auto zones = set->GetZones();
+                            const auto cachedZones = cachedSet->GetZones();
+                            const auto uncachedZones = uncachedSet->GetZones();
+                            const auto otherSizeZones = otherSizeSet->GetZones();
+                            const auto otherSpacingZones = otherSpacingSet->GetZones();
+                            Assert::AreEqual(uncachedZones.size(), cachedZones.size());
+                            Assert::AreEqual(uncachedZones.size(), otherSizeZones.size());
+                            Assert::AreEqual(uncachedZones.size(), otherSpacingZones.size());
+
+                            bool spacingChanged = false;
+                            for (const auto& [id, zone] : uncachedZones)
+                            {
+                                // Zones served from the cache are the very same objects
+                                Assert::IsTrue(zones.at(id) == cachedZones.at(id));
+                                Assert::IsFalse(zone == cachedZones.at(id));
+                                Assert::IsFalse(zone == otherSizeZones.at(id));
+
+                                const auto rect = zone->GetZoneRect();
+                                const auto cachedRect = cachedZones.at(id)->GetZoneRect();
+                                const auto otherSpacingRect = otherSpacingZones.at(id)->GetZoneRect();
+                                Assert::IsTrue(memcmp(&rect, &cachedRect, sizeof(RECT)) == 0);
+                                spacingChanged = spacingChanged || memcmp(&rect, &otherSpacingRect, sizeof(RECT)) != 0;
+                            }
+
+                            //Focus doesn't depends on spacing
+                            Assert::AreEqual(type != static_cast<int>(ZoneSetLayoutType::Focus), spacingChanged);
+                        }
+                    }
+                }
+
                 TEST_METHOD (CustomZonesFromNonexistentFile)
                 {
                     const int spacing = 10;
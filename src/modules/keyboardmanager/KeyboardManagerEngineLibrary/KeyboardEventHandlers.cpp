@@ -9,6 +9,9 @@
 
 namespace KeyboardEventHandlers
 {
+    // Upper bound of the key events sent for one hook event: the modifiers and action keys of two shortcuts and a dummy key event. The key events are built on the stack to avoid allocating inside the hook
+    constexpr size_t MaxKeyEventCount = 16;
+
     // Function to a handle a single key remap
     intptr_t HandleSingleKeyRemapEvent(KeyboardManagerInput::InputInterface& ii, LowlevelKeyboardEvent* data, State& state) noexcept
     {
@@ -42,8 +45,7 @@ namespace KeyboardEventHandlers
                     key_count = std::get<Shortcut>(it->second).Size();
                 }
 
-                LPINPUT keyEventList = new INPUT[size_t(key_count)]();
-                memset(keyEventList, 0, sizeof(keyEventList));
+                INPUT keyEventList[MaxKeyEventCount] = {};
 
                 // Handle remaps to VK_WIN_BOTH
                 DWORD target;
@@ -94,7 +96,6 @@ namespace KeyboardEventHandlers
                 }
 
                 UINT res = ii.SendVirtualInput(key_count, keyEventList, sizeof(INPUT));
-                delete[] keyEventList;
 
                 if (data->wParam == WM_KEYDOWN || data->wParam == WM_SYSKEYDOWN)
                 {
@@ -184,11 +185,18 @@ namespace KeyboardEventHandlers
         // Get shortcut table for given activatedApp
         ShortcutRemapTable& reMap = state.GetShortcutRemapTable(activatedApp);
 
-        // Iterate through the shortcut remaps and apply whichever has been pressed
-        for (auto& itShortcut : state.GetSortedShortcutRemapVector(activatedApp))
+        // If no shortcut is invoked, only a key down of a shortcut's action key can invoke one, so only the remaps with that action key have to be checked
+        if (!isShortcutInvoked && data->wParam != WM_KEYDOWN && data->wParam != WM_SYSKEYDOWN)
         {
-            const auto it = reMap.find(itShortcut);
+            return 0;
+        }
+
+        const ShortcutRemapIndex& reMapIndex = state.GetShortcutRemapIndex(activatedApp);
+        const ShortcutRemapIndex::Entries& candidates = isShortcutInvoked ? reMapIndex.GetEntries() : reMapIndex.GetEntriesForActionKey(data->lParam->vkCode);
 
+        // Iterate through the shortcut remaps and apply whichever has been pressed
+        for (const auto& it : candidates)
+        {
             // If a shortcut is currently in the invoked state then skip till the shortcut that is currently invoked
             if (isShortcutInvoked && !it->second.isShortcutInvoked)
             {
@@ -213,7 +221,7 @@ namespace KeyboardEventHandlers
                     }
 
                     size_t key_count;
-                    LPINPUT keyEventList;
+                    INPUT keyEventList[MaxKeyEventCount] = {};
 
                     // Remember which win key was pressed initially
                     if (ii.GetVirtualKeyState(VK_RWIN))
@@ -235,8 +243,6 @@ namespace KeyboardEventHandlers
                         {
                             // key down for all new shortcut keys except the common modifiers
                             key_count = dest_size - commonKeys;
-                            keyEventList = new INPUT[key_count]();
-                            memset(keyEventList, 0, sizeof(keyEventList));
                             int i = 0;
                             Helpers::SetModifierKeyEvents(std::get<Shortcut>(it->second.targetShortcut), it->second.winKeyInvoked, keyEventList, i, true, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG, it->first);
                             Helpers::SetKeyEvent(keyEventList, i, INPUT_KEYBOARD, (WORD)std::get<Shortcut>(it->second.targetShortcut).GetActionKey(), 0, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
@@ -246,8 +252,6 @@ namespace KeyboardEventHandlers
                         {
                             // Dummy key, key up for all the original shortcut modifier keys and key down for all the new shortcut keys but common keys in each are not repeated
                             key_count = KeyboardManagerConstants::DUMMY_KEY_EVENT_SIZE + (src_size - 1) + (dest_size) - (2 * (size_t)commonKeys);
-                            keyEventList = new INPUT[key_count]();
-                            memset(keyEventList, 0, sizeof(keyEventList));
 
                             // Send a dummy key event to prevent modifier press+release from being triggered. Example: Win+A->Ctrl+V, press Win+A, since Win will be released here we need to send a dummy event before it
                             int i = 0;
@@ -285,9 +289,6 @@ namespace KeyboardEventHandlers
                             it->second.isOriginalActionKeyPressed = true;
                         }
 
-                        keyEventList = new INPUT[key_count]();
-                        memset(keyEventList, 0, sizeof(keyEventList));
-
                         // Send a dummy key event to prevent modifier press+release from being triggered. Example: Win+A->V, press Win+A, since Win will be released here we need to send a dummy event before it
                         int i = 0;
                         Helpers::SetDummyKeyEvent(keyEventList, i, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
@@ -317,7 +318,6 @@ namespace KeyboardEventHandlers
                     }
 
                     UINT res = ii.SendVirtualInput((UINT)key_count, keyEventList, sizeof(INPUT));
-                    delete[] keyEventList;
 
                     // Log telemetry event when shortcut remap is invoked
                     Trace::ShortcutRemapInvoked(remapToShortcut, activatedApp.has_value());
@@ -344,7 +344,7 @@ namespace KeyboardEventHandlers
                 {
                     // Release new shortcut, and set original shortcut keys except the one released
                     size_t key_count;
-                    LPINPUT keyEventList;
+                    INPUT keyEventList[MaxKeyEventCount] = {};
                     if (remapToShortcut)
                     {
                         // if the released key is present in both shortcuts' modifiers (i.e part of the common modifiers)
@@ -367,9 +367,6 @@ namespace KeyboardEventHandlers
                             key_count += 1;
                         }
 
-                        keyEventList = new INPUT[key_count]();
-                        memset(keyEventList, 0, sizeof(keyEventList));
-
                         // Release new shortcut state (release in reverse order of shortcut to be accurate)
                         int i = 0;
                         if (isActionKeyPressed)
@@ -406,9 +403,6 @@ namespace KeyboardEventHandlers
                             key_count--;
                         }
 
-                        keyEventList = new INPUT[key_count]();
-                        memset(keyEventList, 0, sizeof(keyEventList));
-
                         // Release new key state
                         int i = 0;
                         if (std::get<DWORD>(it->second.targetShortcut) != CommonSharedConstants::VK_DISABLED && isTargetKeyPressed)
@@ -439,7 +433,6 @@ namespace KeyboardEventHandlers
                     if (key_count > 0)
                     {
                         UINT res = ii.SendVirtualInput((UINT)key_count, keyEventList, sizeof(INPUT));
-                        delete[] keyEventList;
                     }
                     return 1;
                 }
@@ -459,8 +452,7 @@ namespace KeyboardEventHandlers
                         }
 
                         size_t key_count = 1;
-                        LPINPUT keyEventList = new INPUT[key_count]();
-                        memset(keyEventList, 0, sizeof(keyEventList));
+                        INPUT keyEventList[MaxKeyEventCount] = {};
                         if (remapToShortcut)
                         {
                             Helpers::SetKeyEvent(keyEventList, 0, INPUT_KEYBOARD, (WORD)std::get<Shortcut>(it->second.targetShortcut).GetActionKey(), 0, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
@@ -471,7 +463,6 @@ namespace KeyboardEventHandlers
                         }
 
                         UINT res = ii.SendVirtualInput((UINT)key_count, keyEventList, sizeof(INPUT));
-                        delete[] keyEventList;
                         return 1;
                     }
 
@@ -479,11 +470,9 @@ namespace KeyboardEventHandlers
                     if (data->lParam->vkCode == it->first.GetActionKey() && (data->wParam == WM_KEYUP || data->wParam == WM_SYSKEYUP))
                     {
                         size_t key_count = 1;
-                        LPINPUT keyEventList;
+                        INPUT keyEventList[MaxKeyEventCount] = {};
                         if (remapToShortcut)
                         {
-                            keyEventList = new INPUT[key_count]();
-                            memset(keyEventList, 0, sizeof(keyEventList));
                             Helpers::SetKeyEvent(keyEventList, 0, INPUT_KEYBOARD, (WORD)std::get<Shortcut>(it->second.targetShortcut).GetActionKey(), KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
                         }
                         else if (std::get<DWORD>(it->second.targetShortcut) == CommonSharedConstants::VK_DISABLED)
@@ -496,13 +485,13 @@ namespace KeyboardEventHandlers
                         else
                         {
                             // Check if the keyboard state is clear apart from the target remap key (by creating a temp Shortcut object with the target key)
-                            bool isKeyboardStateClear = Shortcut(std::vector<int32_t>({ Helpers::FilterArtificialKeys(std::get<DWORD>(it->second.targetShortcut)) })).IsKeyboardStateClearExceptShortcut(ii);
+                            Shortcut targetKeyShortcut;
+                            targetKeyShortcut.SetKey(Helpers::FilterArtificialKeys(std::get<DWORD>(it->second.targetShortcut)));
+                            bool isKeyboardStateClear = targetKeyShortcut.IsKeyboardStateClearExceptShortcut(ii);
                             
                             // If the keyboard state is clear, we release the target key but do not reset the remap state
                             if (isKeyboardStateClear)
                             {
-                                keyEventList = new INPUT[key_count]();
-                                memset(keyEventList, 0, sizeof(keyEventList));
                                 Helpers::SetKeyEvent(keyEventList, 0, INPUT_KEYBOARD, (WORD)Helpers::FilterArtificialKeys(std::get<DWORD>(it->second.targetShortcut)), KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
                             }
                             else
@@ -513,9 +502,6 @@ namespace KeyboardEventHandlers
                                 // 1 for releasing new key and original shortcut modifiers, and dummy key
                                 key_count = dest_size + (src_size - 1) + KeyboardManagerConstants::DUMMY_KEY_EVENT_SIZE;
 
-                                keyEventList = new INPUT[key_count]();
-                                memset(keyEventList, 0, sizeof(keyEventList));
-
                                 // Release new key state
                                 int i = 0;
                                 Helpers::SetKeyEvent(keyEventList, i, INPUT_KEYBOARD, (WORD)Helpers::FilterArtificialKeys(std::get<DWORD>(it->second.targetShortcut)), KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
@@ -541,7 +527,6 @@ namespace KeyboardEventHandlers
                         }
 
                         UINT res = ii.SendVirtualInput((UINT)key_count, keyEventList, sizeof(INPUT));
-                        delete[] keyEventList;
                         return 1;
                     }
 
@@ -579,7 +564,7 @@ namespace KeyboardEventHandlers
                             }
 
                             size_t key_count;
-                            LPINPUT keyEventList = nullptr;
+                            INPUT keyEventList[MaxKeyEventCount] = {};
                             
                             // Check if a new remapping should be applied
                             Shortcut currentlyPressed = it->first;
@@ -593,8 +578,6 @@ namespace KeyboardEventHandlers
                                 {
                                     DWORD to = std::get<0>(newRemapping.targetShortcut);
                                     key_count = from.Size() - 1 + 1;
-                                    keyEventList = new INPUT[key_count]();
-                                    memset(keyEventList, 0, sizeof(keyEventList));
                                     int i = 0;
                                     Helpers::SetModifierKeyEvents(from, it->second.winKeyInvoked, keyEventList, i, false, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
                                     Helpers::SetKeyEvent(keyEventList, i, INPUT_KEYBOARD, (WORD)to, 0, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
@@ -602,7 +585,6 @@ namespace KeyboardEventHandlers
                                 {
                                     Shortcut to = std::get<Shortcut>(newRemapping.targetShortcut);
                                     key_count = from.Size() - 1 + to.Size() - 1 - 2* from.GetCommonModifiersCount(to) + 1;
-                                    keyEventList = new INPUT[key_count]();
 
                                     int i = 0;
                                     Helpers::SetModifierKeyEvents(from, it->second.winKeyInvoked, keyEventList, i, false, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG, to);
@@ -635,9 +617,6 @@ namespace KeyboardEventHandlers
                                     key_count += 2;
                                 }
 
-                                keyEventList = new INPUT[key_count]();
-                                memset(keyEventList, 0, sizeof(keyEventList));
-
                                 // Release new shortcut state (release in reverse order of shortcut to be accurate)
                                 int i = 0;
                                 if (isActionKeyPressed)
@@ -676,7 +655,6 @@ namespace KeyboardEventHandlers
                             }
 
                             UINT res = ii.SendVirtualInput((UINT)key_count, keyEventList, sizeof(INPUT));
-                            delete[] keyEventList;
                             return 1;
                         }
                         else
@@ -708,8 +686,7 @@ namespace KeyboardEventHandlers
                                 // Key down for original shortcut modifiers and action key, and current key press
                                 size_t key_count = src_size + 1;
 
-                                LPINPUT keyEventList = new INPUT[key_count]();
-                                memset(keyEventList, 0, sizeof(keyEventList));
+                                INPUT keyEventList[MaxKeyEventCount] = {};
 
                                 // Set original shortcut key down state
                                 int i = 0;
@@ -745,7 +722,6 @@ namespace KeyboardEventHandlers
                                 }
 
                                 UINT res = ii.SendVirtualInput((UINT)key_count, keyEventList, sizeof(INPUT));
-                                delete[] keyEventList;
                                 return 1;
                             }
                             else
@@ -843,13 +819,11 @@ namespace KeyboardEventHandlers
             if (Helpers::IsModifierKey(key) && !(key == VK_LWIN || key == VK_RWIN || key == CommonSharedConstants::VK_WIN_BOTH))
             {
                 int key_count = 1;
-                LPINPUT keyEventList = new INPUT[size_t(key_count)]();
-                memset(keyEventList, 0, sizeof(keyEventList));
+                INPUT keyEventList[1] = {};
 
                 // Use the suppress flag to ensure these are not intercepted by any remapped keys or shortcuts
                 Helpers::SetKeyEvent(keyEventList, 0, INPUT_KEYBOARD, (WORD)key, KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SUPPRESS_FLAG);
                 UINT res = ii.SendVirtualInput((UINT)key_count, keyEventList, sizeof(INPUT));
-                delete[] keyEventList;
             }
         }
     }
@@ -82,6 +82,9 @@ LRESULT CALLBACK KeyboardManager::HookProc(int nCode, WPARAM wParam, LPARAM lPar
             }
             return 1;
         }
+
+        // The event reaches the system, so track the new key state for the remapping logic
+        keyboardManagerObjectPtr->inputHandler.UpdateKeyboardState(event.lParam->vkCode, event.wParam == WM_KEYUP || event.wParam == WM_SYSKEYUP);
     }
     
     return CallNextHookEx(hookHandleCopy, nCode, wParam, lParam);
@@ -98,6 +101,7 @@ void KeyboardManager::StartLowlevelKeyboardHook()
 
     if (!hookHandle)
     {
+        inputHandler.SyncKeyboardState();
         hookHandle = SetWindowsHookEx(WH_KEYBOARD_LL, HookProc, GetModuleHandle(NULL), NULL);
         hookHandleCopy = hookHandle;
         if (!hookHandle)
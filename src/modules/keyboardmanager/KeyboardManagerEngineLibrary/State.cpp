@@ -50,6 +50,19 @@ std::vector<Shortcut>& State::GetSortedShortcutRemapVector(const std::optional<s
     return appName ? appSpecificShortcutReMapSortedKeys[*appName] : osLevelShortcutReMapSortedKeys;
 }
 
+// Function to get the shortcut remappings grouped by action key. Returns an empty index if the app has no remappings
+const ShortcutRemapIndex& State::GetShortcutRemapIndex(const std::optional<std::wstring>& appName)
+{
+    if (!appName)
+    {
+        return osLevelShortcutReMapIndex;
+    }
+
+    static const ShortcutRemapIndex emptyIndex;
+    auto it = appSpecificShortcutReMapIndex.find(*appName);
+    return it != appSpecificShortcutReMapIndex.end() ? it->second : emptyIndex;
+}
+
 // Sets the activated target application in app-specific shortcut
 void State::SetActivatedApp(const std::wstring& appName)
 {
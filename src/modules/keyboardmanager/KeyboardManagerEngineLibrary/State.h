@@ -18,6 +18,9 @@ public:
 
     std::vector<Shortcut>& GetSortedShortcutRemapVector(const std::optional<std::wstring>& appName);
 
+    // Function to get the shortcut remappings grouped by action key. Returns an empty index if the app has no remappings
+    const ShortcutRemapIndex& GetShortcutRemapIndex(const std::optional<std::wstring>& appName);
+
     // Sets the activated target application in app-specific shortcut
     void SetActivatedApp(const std::wstring& appName);
 
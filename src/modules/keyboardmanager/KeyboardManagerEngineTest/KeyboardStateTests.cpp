@@ -0,0 +1,183 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "MockedInput.h"
+#include <keyboardmanager/common/Shortcut.h>
+#include <random>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace RemappingLogicTests
+{
+    // Input whose tracked state has missed some key downs
+    class UntrackedKeysInput : public KeyboardManagerInput::InputInterface
+    {
+    public:
+        KeyboardManagerInput::KeyboardState trackedState;
+        KeyboardManagerInput::KeyboardState actualState;
+
+        UINT SendVirtualInput(UINT, LPINPUT, int)
+        {
+            return 0;
+        }
+
+        bool GetVirtualKeyState(int key)
+        {
+            return actualState.IsKeyPressed(key);
+        }
+
+        const KeyboardManagerInput::KeyboardState& GetKeyboardState()
+        {
+            return trackedState;
+        }
+
+        void GetForegroundProcess(_Out_ std::wstring& foregroundProcess)
+        {
+            foregroundProcess = L"";
+        }
+    };
+
+    // Tests for the tracked keyboard state and the shortcut checks using it
+    TEST_CLASS (KeyboardStateTests)
+    {
+    private:
+        KeyboardManagerInput::MockedInput mockedInputHandler;
+
+        // Function to check if a pressed key is allowed by the shortcut, following the checks made for each key code before the keyboard state was tracked
+        static bool IsKeyAllowed(const Shortcut& shortcut, DWORD key)
+        {
+            const auto isAllowed = [](ModifierKey modifier, DWORD key, DWORD leftKey, DWORD rightKey) {
+                return (key == leftKey && (modifier == ModifierKey::Left || modifier == ModifierKey::Both)) || (key == rightKey && (modifier == ModifierKey::Right || modifier == ModifierKey::Both));
+            };
+
+            switch (key)
+            {
+            case VK_LWIN:
+            case VK_RWIN:
+                return isAllowed(shortcut.winKey, key, VK_LWIN, VK_RWIN);
+            case VK_LCONTROL:
+            case VK_RCONTROL:
+                return isAllowed(shortcut.ctrlKey, key, VK_LCONTROL, VK_RCONTROL);
+            case VK_LMENU:
+            case VK_RMENU:
+                return isAllowed(shortcut.altKey, key, VK_LMENU, VK_RMENU);
+            case VK_LSHIFT:
+            case VK_RSHIFT:
+                return isAllowed(shortcut.shiftKey, key, VK_LSHIFT, VK_RSHIFT);
+            case VK_CONTROL:
+                return shortcut.ctrlKey != ModifierKey::Disabled;
+            case VK_MENU:
+                return shortcut.altKey != ModifierKey::Disabled;
+            case VK_SHIFT:
+                return shortcut.shiftKey != ModifierKey::Disabled;
+            default:
+                return key == shortcut.actionKey;
+            }
+        }
+
+    public:
+        TEST_METHOD_INITIALIZE(InitializeTestEnv)
+        {
+            mockedInputHandler.ResetKeyboardState();
+        }
+
+        // Test if the generic modifier key codes follow the left and right keys
+        TEST_METHOD (KeyboardState_ShouldUpdateGenericModifiers_OnModifierEvents)
+        {
+            KeyboardManagerInput::KeyboardState state;
+            state.UpdateKeyState(VK_LCONTROL, false);
+            state.UpdateKeyState(VK_RCONTROL, false);
+            Assert::IsTrue(state.IsKeyPressed(VK_CONTROL));
+
+            state.UpdateKeyState(VK_LCONTROL, true);
+            Assert::IsTrue(state.IsKeyPressed(VK_CONTROL));
+            state.UpdateKeyState(VK_RCONTROL, true);
+            Assert::IsFalse(state.IsKeyPressed(VK_CONTROL));
+
+            state.UpdateKeyState(VK_LSHIFT, false);
+            state.UpdateKeyState(VK_SHIFT, true);
+            Assert::IsTrue(state.IsEmpty());
+        }
+
+        // Test if the pressed keys are listed in increasing order
+        TEST_METHOD (KeyboardState_ShouldListPressedKeys)
+        {
+            KeyboardManagerInput::KeyboardState state;
+            for (DWORD key : { 0xFE, 0x41, VK_LWIN, 0x01 })
+            {
+                state.SetKeyState(key, true);
+            }
+
+            std::vector<DWORD> pressedKeys;
+            state.ForEachPressedKey([&](DWORD key) { pressedKeys.push_back(key); });
+            Assert::IsTrue(std::vector<DWORD>{ 0x01, 0x41, VK_LWIN, 0xFE } == pressedKeys);
+        }
+
+        // Test if Num Lock, mouse buttons and ignored key codes don't prevent a shortcut from being detected
+        TEST_METHOD (IsKeyboardStateClearExceptShortcut_ShouldSkipIgnoredKeys)
+        {
+            Shortcut shortcut(std::vector<int32_t>{ VK_LCONTROL, 0x41 });
+            mockedInputHandler.SetVirtualKeyState(VK_LCONTROL, true);
+            mockedInputHandler.SetVirtualKeyState(VK_CONTROL, true);
+            mockedInputHandler.SetVirtualKeyState(0x41, true);
+            mockedInputHandler.SetVirtualKeyState(0xFF, true);
+            mockedInputHandler.SetVirtualKeyState(VK_LBUTTON, true);
+            mockedInputHandler.SetVirtualKeyState(VK_PROCESSKEY, true);
+            Assert::IsTrue(shortcut.IsKeyboardStateClearExceptShortcut(mockedInputHandler));
+
+            mockedInputHandler.SetVirtualKeyState(VK_RCONTROL, true);
+            Assert::IsFalse(shortcut.IsKeyboardStateClearExceptShortcut(mockedInputHandler));
+        }
+
+        // Test if a modifier which isn't part of the shortcut prevents it from being detected even if the tracked state missed it
+        TEST_METHOD (IsKeyboardStateClearExceptShortcut_ShouldConfirmModifiers_WhenTrackedStateMissedThem)
+        {
+            Shortcut shortcut(std::vector<int32_t>{ VK_LCONTROL, 0x41 });
+            UntrackedKeysInput input;
+            for (DWORD key : { VK_LCONTROL, VK_CONTROL, 0x41 })
+            {
+                input.trackedState.SetKeyState(key, true);
+                input.actualState.SetKeyState(key, true);
+            }
+            Assert::IsTrue(shortcut.IsKeyboardStateClearExceptShortcut(input));
+
+            input.actualState.SetKeyState(VK_RMENU, true);
+            Assert::IsFalse(shortcut.IsKeyboardStateClearExceptShortcut(input));
+
+            // Other keys are only checked through the tracked state
+            input.actualState.SetKeyState(VK_RMENU, false);
+            input.actualState.SetKeyState(0x42, true);
+            Assert::IsTrue(shortcut.IsKeyboardStateClearExceptShortcut(input));
+        }
+
+        // Test if the mask based check gives the same result as checking every key code
+        TEST_METHOD (IsKeyboardStateClearExceptShortcut_ShouldMatchPerKeyCheck_ForRandomStates)
+        {
+            const DWORD keys[] = { VK_LWIN, VK_RWIN, VK_CONTROL, VK_LCONTROL, VK_RCONTROL, VK_MENU, VK_LMENU, VK_RMENU, VK_SHIFT, VK_LSHIFT, VK_RSHIFT, 0x41, 0x42, VK_F5, VK_NUMPAD1, VK_SPACE };
+            const ModifierKey modifiers[] = { ModifierKey::Disabled, ModifierKey::Left, ModifierKey::Right, ModifierKey::Both };
+            std::mt19937 random(7);
+
+            for (int i = 0; i < 5000; i++)
+            {
+                Shortcut shortcut;
+                shortcut.winKey = modifiers[random() % 4];
+                shortcut.ctrlKey = modifiers[random() % 4];
+                shortcut.altKey = modifiers[random() % 4];
+                shortcut.shiftKey = modifiers[random() % 4];
+                shortcut.actionKey = keys[random() % ARRAYSIZE(keys)];
+
+                mockedInputHandler.ResetKeyboardState();
+                bool expected = true;
+                for (DWORD key : keys)
+                {
+                    if (random() % 4 == 0)
+                    {
+                        mockedInputHandler.SetVirtualKeyState(key, true);
+                        expected = expected && IsKeyAllowed(shortcut, key);
+                    }
+                }
+
+                Assert::AreEqual(expected, shortcut.IsKeyboardStateClearExceptShortcut(mockedInputHandler));
+            }
+        }
+    };
+}
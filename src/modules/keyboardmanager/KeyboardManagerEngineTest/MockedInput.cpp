@@ -20,7 +20,7 @@ UINT MockedInput::SendVirtualInput(UINT cInputs, LPINPUT pInputs, int cbSize)
         // Distinguish between key and sys key by checking if the key is either F10 (for syskeydown) or if the key message is sent while Alt is held down. SYSKEY messages are also sent if there is no window in focus, but that has not been mocked since it would require many changes. More details on key messages at https://docs.microsoft.com/en-us/windows/win32/inputdev/wm-syskeydown
         if (pInputs[i].ki.dwFlags & KEYEVENTF_KEYUP)
         {
-            if (keyboardState[VK_MENU] == true)
+            if (keyboardState.IsKeyPressed(VK_MENU))
             {
                 keyEvent.wParam = WM_SYSKEYUP;
             }
@@ -31,7 +31,7 @@ UINT MockedInput::SendVirtualInput(UINT cInputs, LPINPUT pInputs, int cbSize)
         }
         else
         {
-            if (pInputs[i].ki.wVk == VK_F10 || keyboardState[VK_MENU] == true)
+            if (pInputs[i].ki.wVk == VK_F10 || keyboardState.IsKeyPressed(VK_MENU))
             {
                 keyEvent.wParam = WM_SYSKEYDOWN;
             }
@@ -60,7 +60,7 @@ UINT MockedInput::SendVirtualInput(UINT cInputs, LPINPUT pInputs, int cbSize)
         if (result == 0)
         {
             // If key up flag is set, then set keyboard state to false
-            keyboardState[pInputs[i].ki.wVk] = (pInputs[i].ki.dwFlags & KEYEVENTF_KEYUP) ? false : true;
+            keyboardState.SetKeyState(pInputs[i].ki.wVk, (pInputs[i].ki.dwFlags & KEYEVENTF_KEYUP) ? false : true);
 
             // Handling modifier key codes
             switch (pInputs[i].ki.wVk)
@@ -68,41 +68,41 @@ UINT MockedInput::SendVirtualInput(UINT cInputs, LPINPUT pInputs, int cbSize)
             case VK_CONTROL:
                 if (pInputs[i].ki.dwFlags & KEYEVENTF_KEYUP)
                 {
-                    keyboardState[VK_LCONTROL] = false;
-                    keyboardState[VK_RCONTROL] = false;
+                    keyboardState.SetKeyState(VK_LCONTROL, false);
+                    keyboardState.SetKeyState(VK_RCONTROL, false);
                 }
                 break;
             case VK_LCONTROL:
-                keyboardState[VK_CONTROL] = (pInputs[i].ki.dwFlags & KEYEVENTF_KEYUP) ? false : true;
+                keyboardState.SetKeyState(VK_CONTROL, (pInputs[i].ki.dwFlags & KEYEVENTF_KEYUP) ? false : true);
                 break;
             case VK_RCONTROL:
-                keyboardState[VK_CONTROL] = (pInputs[i].ki.dwFlags & KEYEVENTF_KEYUP) ? false : true;
+                keyboardState.SetKeyState(VK_CONTROL, (pInputs[i].ki.dwFlags & KEYEVENTF_KEYUP) ? false : true);
                 break;
             case VK_MENU:
                 if (pInputs[i].ki.dwFlags & KEYEVENTF_KEYUP)
                 {
-                    keyboardState[VK_LMENU] = false;
-                    keyboardState[VK_RMENU] = false;
+                    keyboardState.SetKeyState(VK_LMENU, false);
+                    keyboardState.SetKeyState(VK_RMENU, false);
                 }
                 break;
             case VK_LMENU:
-                keyboardState[VK_MENU] = (pInputs[i].ki.dwFlags & KEYEVENTF_KEYUP) ? false : true;
+                keyboardState.SetKeyState(VK_MENU, (pInputs[i].ki.dwFlags & KEYEVENTF_KEYUP) ? false : true);
                 break;
             case VK_RMENU:
-                keyboardState[VK_MENU] = (pInputs[i].ki.dwFlags & KEYEVENTF_KEYUP) ? false : true;
+                keyboardState.SetKeyState(VK_MENU, (pInputs[i].ki.dwFlags & KEYEVENTF_KEYUP) ? false : true);
                 break;
             case VK_SHIFT:
                 if (pInputs[i].ki.dwFlags & KEYEVENTF_KEYUP)
                 {
-                    keyboardState[VK_LSHIFT] = false;
-                    keyboardState[VK_RSHIFT] = false;
+                    keyboardState.SetKeyState(VK_LSHIFT, false);
+                    keyboardState.SetKeyState(VK_RSHIFT, false);
                 }
                 break;
             case VK_LSHIFT:
-                keyboardState[VK_SHIFT] = (pInputs[i].ki.dwFlags & KEYEVENTF_KEYUP) ? false : true;
+                keyboardState.SetKeyState(VK_SHIFT, (pInputs[i].ki.dwFlags & KEYEVENTF_KEYUP) ? false : true);
                 break;
             case VK_RSHIFT:
-                keyboardState[VK_SHIFT] = (pInputs[i].ki.dwFlags & KEYEVENTF_KEYUP) ? false : true;
+                keyboardState.SetKeyState(VK_SHIFT, (pInputs[i].ki.dwFlags & KEYEVENTF_KEYUP) ? false : true);
                 break;
             }
         }
@@ -128,13 +128,25 @@ intptr_t MockedInput::MockedKeyboardHook(LowlevelKeyboardEvent* data)
 // Function to get the state of a particular key
 bool MockedInput::GetVirtualKeyState(int key)
 {
-    return keyboardState[key];
+    return keyboardState.IsKeyPressed(key);
+}
+
+// Function to get the keys pressed down
+const KeyboardState& MockedInput::GetKeyboardState()
+{
+    return keyboardState;
+}
+
+// Function to set the state of a particular key without going through the hook
+void MockedInput::SetVirtualKeyState(int key, bool pressed)
+{
+    keyboardState.SetKeyState(key, pressed);
 }
 
 // Function to reset the mocked keyboard state
 void MockedInput::ResetKeyboardState()
 {
-    std::fill(keyboardState.begin(), keyboardState.end(), false);
+    keyboardState.Reset();
 }
 
 // Function to set SendVirtualInput call count condition
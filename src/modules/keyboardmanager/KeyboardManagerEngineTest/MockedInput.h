@@ -13,7 +13,7 @@ namespace KeyboardManagerInput
     {
     private:
         // Stores the states for all the keys - false for key up, and true for key down
-        std::vector<bool> keyboardState;
+        KeyboardState keyboardState;
 
         // Function to be executed as a low level hook. By default it is nullptr so the hook is skipped
         std::function<intptr_t(LowlevelKeyboardEvent*)> hookProc;
@@ -25,11 +25,6 @@ namespace KeyboardManagerInput
         std::wstring currentProcess;
 
     public:
-        MockedInput()
-        {
-            keyboardState.resize(256, false);
-        }
-
         // Set the keyboard hook procedure to be tested
         void SetHookProc(std::function<intptr_t(LowlevelKeyboardEvent*)> hookProcedure);
 
@@ -42,6 +37,12 @@ namespace KeyboardManagerInput
         // Function to get the state of a particular key
         bool GetVirtualKeyState(int key);
 
+        // Function to get the keys pressed down
+        const KeyboardState& GetKeyboardState();
+
+        // Function to set the state of a particular key without going through the hook, e.g. to simulate a key which was pressed before the hook was installed
+        void SetVirtualKeyState(int key, bool pressed);
+
         // Function to reset the mocked keyboard state
         void ResetKeyboardState();
 
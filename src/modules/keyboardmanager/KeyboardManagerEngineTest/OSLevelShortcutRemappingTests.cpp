@@ -2687,5 +2687,67 @@ namespace RemappingLogicTests
             // LWin should be pressed
             Assert::AreEqual(true, mockedInputHandler.GetVirtualKeyState(VK_LWIN));
         }
+
+        // Test if the remap index lists the remaps with each action key in the order of the sorted shortcut vector
+        TEST_METHOD (ShortcutRemapIndex_ShouldGroupRemapsByActionKeyInSortedOrder)
+        {
+            // Remap Ctrl+A to B, Ctrl+Shift+A to C and Alt+D to E
+            testState.AddOSLevelShortcut(Shortcut(std::vector<int32_t>{ VK_CONTROL, 0x41 }), (DWORD)0x42);
+            testState.AddOSLevelShortcut(Shortcut(std::vector<int32_t>{ VK_CONTROL, VK_SHIFT, 0x41 }), (DWORD)0x43);
+            testState.AddOSLevelShortcut(Shortcut(std::vector<int32_t>{ VK_MENU, 0x44 }), (DWORD)0x45);
+
+            const auto& index = testState.GetShortcutRemapIndex(std::nullopt);
+            Assert::AreEqual((size_t)3, index.GetEntries().size());
+
+            const auto& remapsForA = index.GetEntriesForActionKey(0x41);
+            Assert::AreEqual((size_t)2, remapsForA.size());
+            Assert::IsTrue(Shortcut(std::vector<int32_t>{ VK_CONTROL, VK_SHIFT, 0x41 }) == remapsForA[0]->first);
+            Assert::IsTrue(Shortcut(std::vector<int32_t>{ VK_CONTROL, 0x41 }) == remapsForA[1]->first);
+            Assert::AreEqual((size_t)0, index.GetEntriesForActionKey(0x46).size());
+
+            testState.ClearOSLevelShortcuts();
+            Assert::AreEqual((size_t)0, testState.GetShortcutRemapIndex(std::nullopt).GetEntriesForActionKey(0x41).size());
+        }
+
+        // Test if the right remap is invoked when many shortcuts are remapped
+        TEST_METHOD (RemappedShortcut_ShouldInvokeMatchingRemap_WhenManyShortcutsAreRemapped)
+        {
+            // Remap Ctrl+<key> and Ctrl+Alt+<key> to F1 for every letter and digit, and Ctrl+Alt+Q to V
+            for (int32_t key = 0x30; key <= 0x5A; key++)
+            {
+                if (key > 0x39 && key < 0x41)
+                {
+                    continue;
+                }
+
+                testState.AddOSLevelShortcut(Shortcut(std::vector<int32_t>{ VK_CONTROL, key }), (DWORD)VK_F1);
+                if (key != 0x51)
+                {
+                    testState.AddOSLevelShortcut(Shortcut(std::vector<int32_t>{ VK_CONTROL, VK_MENU, key }), (DWORD)VK_F1);
+                }
+            }
+            Shortcut src(std::vector<int32_t>{ VK_CONTROL, VK_MENU, 0x51 });
+            testState.AddOSLevelShortcut(src, (DWORD)0x56);
+
+            const int nInputs = 3;
+            INPUT input[nInputs] = {};
+            input[0].type = INPUT_KEYBOARD;
+            input[0].ki.wVk = VK_CONTROL;
+            input[1].type = INPUT_KEYBOARD;
+            input[1].ki.wVk = VK_MENU;
+            input[2].type = INPUT_KEYBOARD;
+            input[2].ki.wVk = 0x51;
+
+            // Send Ctrl+Alt+Q keydown
+            mockedInputHandler.SendVirtualInput(nInputs, input, sizeof(INPUT));
+
+            // V should be pressed, and Ctrl, Alt, Q and F1 should be released
+            Assert::AreEqual(true, mockedInputHandler.GetVirtualKeyState(0x56));
+            Assert::AreEqual(false, mockedInputHandler.GetVirtualKeyState(VK_CONTROL));
+            Assert::AreEqual(false, mockedInputHandler.GetVirtualKeyState(VK_MENU));
+            Assert::AreEqual(false, mockedInputHandler.GetVirtualKeyState(0x51));
+            Assert::AreEqual(false, mockedInputHandler.GetVirtualKeyState(VK_F1));
+            Assert::AreEqual(true, testState.osLevelShortcutReMap[src].isShortcutInvoked);
+        }
     };
 }
@@ -8,6 +8,10 @@ namespace KeyboardManagerInput
     // Class used to wrap keyboard input library methods
     class Input : public InputInterface
     {
+    private:
+        // Keys pressed down, updated by the owner of the keyboard hook
+        KeyboardState keyboardState;
+
     public:
         // Function to simulate input
         UINT SendVirtualInput(UINT cInputs, LPINPUT pInputs, int cbSize)
@@ -21,6 +25,28 @@ namespace KeyboardManagerInput
             return (GetAsyncKeyState(key) & 0x8000);
         }
 
+        // Function to get the keys pressed down, as tracked from the keyboard hook events
+        const KeyboardState& GetKeyboardState()
+        {
+            return keyboardState;
+        }
+
+        // Function to update the tracked state from a key event which was not suppressed by the keyboard hook
+        void UpdateKeyboardState(DWORD key, bool keyUp)
+        {
+            keyboardState.UpdateKeyState(key, keyUp);
+        }
+
+        // Function to initialize the tracked state from the current state of all the keys, for keys which were pressed before the hook was installed
+        void SyncKeyboardState()
+        {
+            keyboardState.Reset();
+            for (int key = 1; key < 0xFF; key++)
+            {
+                keyboardState.SetKeyState(key, GetVirtualKeyState(key));
+            }
+        }
+
         // Function to get the foreground process name
         void GetForegroundProcess(_Out_ std::wstring& foregroundProcess)
         {
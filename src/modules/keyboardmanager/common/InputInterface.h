@@ -1,4 +1,5 @@
 #pragma once
+#include "KeyboardState.h"
 
 namespace KeyboardManagerInput
 {
@@ -12,6 +13,9 @@ namespace KeyboardManagerInput
         // Function to get the state of a particular key
         virtual bool GetVirtualKeyState(int key) = 0;
 
+        // Function to get the keys pressed down, as tracked from the keyboard hook events. Can be stale, so GetVirtualKeyState should be used to confirm a key is pressed
+        virtual const KeyboardState& GetKeyboardState() = 0;
+
         // Function to get the foreground process name
         virtual void GetForegroundProcess(_Out_ std::wstring& foregroundProcess) = 0;
     };
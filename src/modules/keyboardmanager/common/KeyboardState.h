@@ -0,0 +1,111 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <cstdint>
+
+namespace KeyboardManagerInput
+{
+    // Bitmap of the 256 virtual key codes, with a bit set for every key that is pressed down
+    class KeyboardState
+    {
+    private:
+        std::array<uint64_t, 4> bits = {};
+
+    public:
+        // Function to get the state of a particular key
+        bool IsKeyPressed(DWORD key) const
+        {
+            return key < 256 && (bits[key >> 6] >> (key & 63)) & 1;
+        }
+
+        // Function to set the state of a particular key
+        void SetKeyState(DWORD key, bool pressed)
+        {
+            if (key >= 256)
+            {
+                return;
+            }
+
+            const uint64_t mask = uint64_t{ 1 } << (key & 63);
+            if (pressed)
+            {
+                bits[key >> 6] |= mask;
+            }
+            else
+            {
+                bits[key >> 6] &= ~mask;
+            }
+        }
+
+        // Function to update the state from a key event that reached the system. The generic modifier codes follow their left and right keys like GetAsyncKeyState does
+        void UpdateKeyState(DWORD key, bool keyUp)
+        {
+            SetKeyState(key, !keyUp);
+
+            const auto updateGeneric = [this](DWORD key, DWORD genericKey, DWORD leftKey, DWORD rightKey, bool keyUp) {
+                if (key == genericKey && keyUp)
+                {
+                    SetKeyState(leftKey, false);
+                    SetKeyState(rightKey, false);
+                }
+                else if (key == leftKey || key == rightKey)
+                {
+                    SetKeyState(genericKey, IsKeyPressed(leftKey) || IsKeyPressed(rightKey));
+                }
+            };
+
+            updateGeneric(key, VK_CONTROL, VK_LCONTROL, VK_RCONTROL, keyUp);
+            updateGeneric(key, VK_MENU, VK_LMENU, VK_RMENU, keyUp);
+            updateGeneric(key, VK_SHIFT, VK_LSHIFT, VK_RSHIFT, keyUp);
+        }
+
+        // Function to set all the keys to key up
+        void Reset()
+        {
+            bits = {};
+        }
+
+        // Function to check if no key is pressed down
+        bool IsEmpty() const
+        {
+            return (bits[0] | bits[1] | bits[2] | bits[3]) == 0;
+        }
+
+        // Function to call the callback with every key which is pressed down, in increasing order
+        template<typename Callback>
+        void ForEachPressedKey(Callback&& callback) const
+        {
+            for (DWORD word = 0; word < bits.size(); word++)
+            {
+                uint64_t remaining = bits[word];
+                while (remaining != 0)
+                {
+                    callback(word * 64 + static_cast<DWORD>(std::countr_zero(remaining)));
+                    remaining &= remaining - 1;
+                }
+            }
+        }
+
+        KeyboardState operator&(const KeyboardState& other) const
+        {
+            KeyboardState result;
+            for (size_t i = 0; i < bits.size(); i++)
+            {
+                result.bits[i] = bits[i] & other.bits[i];
+            }
+            return result;
+        }
+
+        KeyboardState operator~() const
+        {
+            KeyboardState result;
+            for (size_t i = 0; i < bits.size(); i++)
+            {
+                result.bits[i] = ~bits[i];
+            }
+            return result;
+        }
+
+        bool operator==(const KeyboardState& other) const = default;
+    };
+}
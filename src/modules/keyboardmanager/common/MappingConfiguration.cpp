@@ -10,11 +10,42 @@
 #include "RemapShortcut.h"
 #include "Helpers.h"
 
+// Function to rebuild the index after the table or the sorted shortcut vector has changed
+void ShortcutRemapIndex::Rebuild(ShortcutRemapTable& table, const std::vector<Shortcut>& sortedKeys)
+{
+    entries.clear();
+    entriesByActionKey.clear();
+    for (const auto& shortcut : sortedKeys)
+    {
+        auto it = table.find(shortcut);
+        if (it != table.end())
+        {
+            entries.push_back(it);
+            entriesByActionKey[shortcut.GetActionKey()].push_back(it);
+        }
+    }
+}
+
+// Function to get all the remappings
+const ShortcutRemapIndex::Entries& ShortcutRemapIndex::GetEntries() const
+{
+    return entries;
+}
+
+// Function to get the remappings with the given action key
+const ShortcutRemapIndex::Entries& ShortcutRemapIndex::GetEntriesForActionKey(DWORD actionKey) const
+{
+    static const Entries noEntries;
+    auto it = entriesByActionKey.find(actionKey);
+    return it != entriesByActionKey.end() ? it->second : noEntries;
+}
+
 // Function to clear the OS Level shortcut remapping table
 void MappingConfiguration::ClearOSLevelShortcuts()
 {
     osLevelShortcutReMap.clear();
     osLevelShortcutReMapSortedKeys.clear();
+    osLevelShortcutReMapIndex.Rebuild(osLevelShortcutReMap, osLevelShortcutReMapSortedKeys);
 }
 
 
@@ -29,6 +60,7 @@ void MappingConfiguration::ClearAppSpecificShortcuts()
 {
     appSpecificShortcutReMap.clear();
     appSpecificShortcutReMapSortedKeys.clear();
+    appSpecificShortcutReMapIndex.clear();
 }
 
 // Function to add a new OS level shortcut remapping
@@ -44,6 +76,7 @@ bool MappingConfiguration::AddOSLevelShortcut(const Shortcut& originalSC, const
     osLevelShortcutReMap[originalSC] = RemapShortcut(newSC);
     osLevelShortcutReMapSortedKeys.push_back(originalSC);
     Helpers::SortShortcutVectorBasedOnSize(osLevelShortcutReMapSortedKeys);
+    osLevelShortcutReMapIndex.Rebuild(osLevelShortcutReMap, osLevelShortcutReMapSortedKeys);
 
     return true;
 }
@@ -89,6 +122,7 @@ bool MappingConfiguration::AddAppSpecificShortcut(const std::wstring& app, const
     appSpecificShortcutReMap[process_name][originalSC] = RemapShortcut(newSC);
     appSpecificShortcutReMapSortedKeys[process_name].push_back(originalSC);
     Helpers::SortShortcutVectorBasedOnSize(appSpecificShortcutReMapSortedKeys[process_name]);
+    appSpecificShortcutReMapIndex[process_name].Rebuild(appSpecificShortcutReMap[process_name], appSpecificShortcutReMapSortedKeys[process_name]);
     return true;
 }
 
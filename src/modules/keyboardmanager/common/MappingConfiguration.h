@@ -10,6 +10,26 @@ using SingleKeyRemapTable = std::unordered_map<DWORD, KeyShortcutUnion>;
 using ShortcutRemapTable = std::map<Shortcut, RemapShortcut>;
 using AppSpecificShortcutRemapTable = std::map<std::wstring, ShortcutRemapTable>;
 
+// Remappings of a shortcut table grouped by action key, so a key event only has to go through the remappings it can trigger. Both lists follow the order of the sorted shortcut vector
+class ShortcutRemapIndex
+{
+public:
+    using Entries = std::vector<ShortcutRemapTable::iterator>;
+
+    // Function to rebuild the index after the table or the sorted shortcut vector has changed
+    void Rebuild(ShortcutRemapTable& table, const std::vector<Shortcut>& sortedKeys);
+
+    // Function to get all the remappings
+    const Entries& GetEntries() const;
+
+    // Function to get the remappings with the given action key
+    const Entries& GetEntriesForActionKey(DWORD actionKey) const;
+
+private:
+    Entries entries;
+    std::unordered_map<DWORD, Entries> entriesByActionKey;
+};
+
 class MappingConfiguration
 {
 public:
@@ -49,10 +69,12 @@ public:
     // Stores the os level shortcut remappings
     ShortcutRemapTable osLevelShortcutReMap;
     std::vector<Shortcut> osLevelShortcutReMapSortedKeys;
+    ShortcutRemapIndex osLevelShortcutReMapIndex;
 
     // Stores the app-specific shortcut remappings. Maps application name to the shortcut map
     AppSpecificShortcutRemapTable appSpecificShortcutReMap;
     std::map<std::wstring, std::vector<Shortcut>> appSpecificShortcutReMapSortedKeys;
+    std::map<std::wstring, ShortcutRemapIndex> appSpecificShortcutReMapIndex;
 
     // Stores the current configuration name.
     std::wstring currentConfig = KeyboardManagerConstants::DefaultConfiguration;
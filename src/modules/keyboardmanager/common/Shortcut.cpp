@@ -643,150 +643,68 @@ bool IgnoreKeyCode(DWORD key)
     }
 }
 
+// Function to get the keys which may be pressed down while the shortcut is pressed
+KeyboardManagerInput::KeyboardState Shortcut::GetShortcutKeyMask() const
+{
+    KeyboardManagerInput::KeyboardState mask;
+    const auto setModifier = [&mask](ModifierKey modifier, DWORD genericKey, DWORD leftKey, DWORD rightKey) {
+        mask.SetKeyState(leftKey, modifier == ModifierKey::Left || modifier == ModifierKey::Both);
+        mask.SetKeyState(rightKey, modifier == ModifierKey::Right || modifier == ModifierKey::Both);
+        if (genericKey != NULL)
+        {
+            mask.SetKeyState(genericKey, modifier != ModifierKey::Disabled);
+        }
+    };
+
+    // Modifier key codes are only allowed through the modifiers, even if the action key is one of them
+    if (actionKey != NULL)
+    {
+        mask.SetKeyState(actionKey, true);
+    }
+    setModifier(winKey, NULL, VK_LWIN, VK_RWIN);
+    setModifier(ctrlKey, VK_CONTROL, VK_LCONTROL, VK_RCONTROL);
+    setModifier(altKey, VK_MENU, VK_LMENU, VK_RMENU);
+    setModifier(shiftKey, VK_SHIFT, VK_LSHIFT, VK_RSHIFT);
+    return mask;
+}
+
 // Function to check if any keys are pressed down except those in the shortcut
 bool Shortcut::IsKeyboardStateClearExceptShortcut(KeyboardManagerInput::InputInterface& ii) const
 {
-    // Iterate through all the virtual key codes - 0xFF is set to key down because of the Num Lock
-    for (int keyVal = 1; keyVal < 0xFF; keyVal++)
-    {
-        // Ignore problematic key codes
-        if (IgnoreKeyCode(keyVal))
-        {
-            continue;
-        }
-        // Check state of the key. If the key is pressed down but it is not part of the shortcut then the keyboard state is not clear
-        if (ii.GetVirtualKeyState(keyVal))
-        {
-            // If one of the win keys is pressed check if it is part of the shortcut
-            if (keyVal == VK_LWIN)
-            {
-                if (winKey != ModifierKey::Left && winKey != ModifierKey::Both)
-                {
-                    return false;
-                }
-                else
-                {
-                    continue;
-                }
-            }
-            else if (keyVal == VK_RWIN)
-            {
-                if (winKey != ModifierKey::Right && winKey != ModifierKey::Both)
-                {
-                    return false;
-                }
-                else
-                {
-                    continue;
-                }
-            }
-            // If one of the ctrl keys is pressed check if it is part of the shortcut
-            else if (keyVal == VK_LCONTROL)
-            {
-                if (ctrlKey != ModifierKey::Left && ctrlKey != ModifierKey::Both)
-                {
-                    return false;
-                }
-                else
-                {
-                    continue;
-                }
-            }
-            else if (keyVal == VK_RCONTROL)
-            {
-                if (ctrlKey != ModifierKey::Right && ctrlKey != ModifierKey::Both)
-                {
-                    return false;
-                }
-                else
-                {
-                    continue;
-                }
-            }
-            else if (keyVal == VK_CONTROL)
-            {
-                if (ctrlKey == ModifierKey::Disabled)
-                {
-                    return false;
-                }
-                else
-                {
-                    continue;
-                }
-            }
-            // If one of the alt keys is pressed check if it is part of the shortcut
-            else if (keyVal == VK_LMENU)
-            {
-                if (altKey != ModifierKey::Left && altKey != ModifierKey::Both)
-                {
-                    return false;
-                }
-                else
-                {
-                    continue;
-                }
-            }
-            else if (keyVal == VK_RMENU)
-            {
-                if (altKey != ModifierKey::Right && altKey != ModifierKey::Both)
-                {
-                    return false;
-                }
-                else
-                {
-                    continue;
-                }
-            }
-            else if (keyVal == VK_MENU)
-            {
-                if (altKey == ModifierKey::Disabled)
-                {
-                    return false;
-                }
-                else
-                {
-                    continue;
-                }
-            }
-            // If one of the shift keys is pressed check if it is part of the shortcut
-            else if (keyVal == VK_LSHIFT)
-            {
-                if (shiftKey != ModifierKey::Left && shiftKey != ModifierKey::Both)
-                {
-                    return false;
-                }
-                else
-                {
-                    continue;
-                }
-            }
-            else if (keyVal == VK_RSHIFT)
-            {
-                if (shiftKey != ModifierKey::Right && shiftKey != ModifierKey::Both)
-                {
-                    return false;
-                }
-                else
-                {
-                    continue;
-                }
-            }
-            else if (keyVal == VK_SHIFT)
-            {
-                if (shiftKey == ModifierKey::Disabled)
-                {
-                    return false;
-                }
-                else
-                {
-                    continue;
-                }
-            }
-            // If any other key is pressed check if it is the action key
-            else if (keyVal != actionKey)
-            {
-                return false;
-            }
+    // Key codes taken into account - 0xFF is set to key down because of the Num Lock, and problematic key codes are ignored
+    static const KeyboardManagerInput::KeyboardState checkedKeys = [] {
+        KeyboardManagerInput::KeyboardState keys;
+        for (DWORD keyVal = 1; keyVal < 0xFF; keyVal++)
+        {
+            keys.SetKeyState(keyVal, !IgnoreKeyCode(keyVal));
+        }
+        return keys;
+    }();
+
+    const KeyboardManagerInput::KeyboardState allowedKeys = GetShortcutKeyMask();
+    const KeyboardManagerInput::KeyboardState otherKeys = ii.GetKeyboardState() & checkedKeys & ~allowedKeys;
+
+    // The tracked state can miss a key up, e.g. one sent while the secure desktop was shown, so confirm the keys it reports
+    bool isClear = true;
+    otherKeys.ForEachPressedKey([&](DWORD keyVal) {
+        if (isClear && ii.GetVirtualKeyState(keyVal))
+        {
+            isClear = false;
+        }
+    });
+
+    if (!isClear)
+    {
+        return false;
+    }
+
+    // It can also miss a key down, e.g. a modifier suppressed by the hook or pressed before it was installed. The modifiers decide
+    // which shortcut is pressed, so the ones the shortcut doesn't use are always confirmed
+    for (DWORD keyVal : { VK_LWIN, VK_RWIN, VK_LCONTROL, VK_RCONTROL, VK_LMENU, VK_RMENU, VK_LSHIFT, VK_RSHIFT })
+    {
+        if (!allowedKeys.IsKeyPressed(keyVal) && !otherKeys.IsKeyPressed(keyVal) && ii.GetVirtualKeyState(keyVal))
+        {
+            return false;
         }
     }
 
@@ -1,5 +1,6 @@
 #pragma once
 #include "ModifierKey.h"
+#include "KeyboardState.h"
 #include <variant>
 
 namespace KeyboardManagerInput
@@ -155,6 +156,9 @@ public:
     // Function to check if all the modifiers in the shortcut have been pressed down
     bool CheckModifiersKeyboardState(KeyboardManagerInput::InputInterface& ii) const;
 
+    // Function to get the keys which may be pressed down while the shortcut is pressed
+    KeyboardManagerInput::KeyboardState GetShortcutKeyMask() const;
+
     // Function to check if any keys are pressed down except those in the shortcut
     bool IsKeyboardStateClearExceptShortcut(KeyboardManagerInput::InputInterface& ii) const;
 
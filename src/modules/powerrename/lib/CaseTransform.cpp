@@ -0,0 +1,268 @@
+#include "pch.h"
+#include "CaseTransform.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cwctype>
+#include <numeric>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define CASE_TRANSFORM_SSE2
+#endif
+
+namespace
+{
+    // Words kept in lowercase by title case unless they are the first or the last word, sorted
+    constexpr std::wstring_view titlecaseExceptions[] = { L"a", L"an", L"and", L"as", L"at", L"but", L"by", L"for", L"in", L"nor", L"of", L"on", L"or", L"the", L"to", L"up" };
+
+    struct CaseTables
+    {
+        std::vector<wchar_t> upper;
+        std::vector<wchar_t> lower;
+    };
+
+    void BuildCaseTable(DWORD mapFlags, std::vector<wchar_t>& table)
+    {
+        table.resize(0x10000);
+        std::iota(table.begin(), table.end(), L'\0');
+
+        // Every UTF-16 unit outside of the surrogates, mapped on its own like towupper and towlower did
+        std::wstring characters;
+        for (unsigned int c = 0x80; c < 0x10000; c++)
+        {
+            if (c < 0xD800 || c > 0xDFFF)
+            {
+                characters.push_back(static_cast<wchar_t>(c));
+            }
+        }
+
+        std::wstring mapped(characters.size(), L'\0');
+        const int length = static_cast<int>(characters.size());
+        if (LCMapStringEx(LOCALE_NAME_USER_DEFAULT, mapFlags, characters.data(), length, mapped.data(), length, nullptr, nullptr, 0) == length)
+        {
+            for (size_t i = 0; i < characters.size(); i++)
+            {
+                table[characters[i]] = mapped[i];
+            }
+            return;
+        }
+
+        for (wchar_t c : characters)
+        {
+            wchar_t mappedChar;
+            if (LCMapStringEx(LOCALE_NAME_USER_DEFAULT, mapFlags, &c, 1, &mappedChar, 1, nullptr, nullptr, 0) == 1)
+            {
+                table[c] = mappedChar;
+            }
+        }
+    }
+
+    const CaseTables& GetCaseTables()
+    {
+        static const CaseTables tables = [] {
+            CaseTables tables;
+            BuildCaseTable(LCMAP_UPPERCASE, tables.upper);
+            BuildCaseTable(LCMAP_LOWERCASE, tables.lower);
+            return tables;
+        }();
+        return tables;
+    }
+
+    // iswspace or iswpunct for each ASCII character
+    constexpr auto asciiSeparators = [] {
+        std::array<bool, 0x80> separators{};
+        for (wchar_t c : std::wstring_view(L"\t\n\v\f\r !\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~"))
+        {
+            separators[c] = true;
+        }
+        return separators;
+    }();
+
+    inline bool IsWordSeparator(wchar_t c)
+    {
+        if (c < 0x80)
+        {
+            return asciiSeparators[c];
+        }
+        return iswspace(c) || iswpunct(c);
+    }
+
+    bool IsTitlecaseException(std::wstring_view word)
+    {
+        return std::binary_search(std::begin(titlecaseExceptions), std::end(titlecaseExceptions), word);
+    }
+
+    void AppendMapped(std::wstring_view source, bool upper, std::wstring& result)
+    {
+        const size_t start = result.size();
+        result.resize(start + source.size());
+        wchar_t* out = result.data() + start;
+
+        // ASCII letters differ from their other case by a single bit
+        const wchar_t first = upper ? L'a' : L'A';
+        const wchar_t last = upper ? L'z' : L'Z';
+        const wchar_t* table = nullptr;
+        const auto map = [&](wchar_t c) {
+            if (c < 0x80)
+            {
+                return (c >= first && c <= last) ? static_cast<wchar_t>(c ^ 0x20) : c;
+            }
+            if (!table)
+            {
+                table = upper ? GetCaseTables().upper.data() : GetCaseTables().lower.data();
+            }
+            return table[static_cast<uint16_t>(c)];
+        };
+
+        size_t i = 0;
+#ifdef CASE_TRANSFORM_SSE2
+        if constexpr (sizeof(wchar_t) == sizeof(uint16_t))
+        {
+            const __m128i nonAsciiBits = _mm_set1_epi16(static_cast<short>(0xFF80));
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i beforeFirst = _mm_set1_epi16(static_cast<short>(first - 1));
+            const __m128i afterLast = _mm_set1_epi16(static_cast<short>(last + 1));
+            const __m128i caseBit = _mm_set1_epi16(0x20);
+
+            for (; i + 8 <= source.size(); i += 8)
+            {
+                __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source.data() + i));
+                if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(block, nonAsciiBits), zero)) != 0xFFFF)
+                {
+                    for (size_t j = i; j < i + 8; j++)
+                    {
+                        out[j] = map(source[j]);
+                    }
+                    continue;
+                }
+
+                const __m128i isLetter = _mm_and_si128(_mm_cmpgt_epi16(block, beforeFirst), _mm_cmplt_epi16(block, afterLast));
+                block = _mm_xor_si128(block, _mm_and_si128(isLetter, caseBit));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), block);
+            }
+        }
+#endif
+
+        for (; i < source.size(); i++)
+        {
+            out[i] = map(source[i]);
+        }
+    }
+}
+
+void CCaseTransform::SplitFileName(std::wstring_view name, std::wstring_view& stem, std::wstring_view& extension)
+{
+    const size_t lastDot = name.rfind(L'.');
+    if (lastDot == std::wstring_view::npos || lastDot == 0 || name == L"..")
+    {
+        stem = name;
+        extension = {};
+        return;
+    }
+
+    stem = name.substr(0, lastDot);
+    extension = name.substr(lastDot);
+}
+
+void CCaseTransform::AppendUppercase(std::wstring_view source, std::wstring& result)
+{
+    AppendMapped(source, true, result);
+}
+
+void CCaseTransform::AppendLowercase(std::wstring_view source, std::wstring& result)
+{
+    AppendMapped(source, false, result);
+}
+
+void CCaseTransform::Transform(std::wstring_view name, bool isFolder, std::wstring& result) const
+{
+    result.clear();
+
+    std::wstring_view stem = name;
+    std::wstring_view extension;
+    if (!isFolder)
+    {
+        SplitFileName(name, stem, extension);
+    }
+
+    if (m_flags & (Uppercase | Lowercase))
+    {
+        const auto append = (m_flags & Uppercase) ? AppendUppercase : AppendLowercase;
+        if (!isFolder && (m_flags & NameOnly))
+        {
+            append(stem, result);
+            result += extension;
+        }
+        else if (!isFolder && (m_flags & ExtensionOnly) && !extension.empty())
+        {
+            result += stem;
+            append(extension, result);
+        }
+        else
+        {
+            append(name, result);
+        }
+    }
+    else if ((m_flags & (Titlecase | Capitalized)) && !(m_flags & ExtensionOnly))
+    {
+        AppendWordsCapitalized(stem, result);
+        result += extension;
+    }
+    else
+    {
+        result = name;
+    }
+}
+
+void CCaseTransform::AppendWordsCapitalized(std::wstring_view stem, std::wstring& result) const
+{
+    // Separators at the end of the stem are left as they are
+    size_t stemLength = stem.size();
+    while (stemLength > 0 && IsWordSeparator(stem[stemLength - 1]))
+    {
+        stemLength--;
+    }
+
+    bool isFirstWord = true;
+    size_t i = 0;
+    while (i < stemLength)
+    {
+        if (IsWordSeparator(stem[i]))
+        {
+            result.push_back(stem[i]);
+            i++;
+            continue;
+        }
+
+        size_t wordEnd = i + 1;
+        while (wordEnd < stemLength && !IsWordSeparator(stem[wordEnd]))
+        {
+            wordEnd++;
+        }
+
+        const std::wstring_view word = stem.substr(i, wordEnd - i);
+        if (!(m_flags & Titlecase) || isFirstWord || wordEnd == stemLength || !IsTitlecaseException(word))
+        {
+            AppendUppercase(word.substr(0, 1), result);
+        }
+        else
+        {
+            AppendLowercase(word.substr(0, 1), result);
+        }
+        AppendLowercase(word.substr(1), result);
+        isFirstWord = false;
+
+        // The separator right after a word was lowercased along with it
+        if (wordEnd < stemLength)
+        {
+            AppendLowercase(stem.substr(wordEnd, 1), result);
+            wordEnd++;
+        }
+        i = wordEnd;
+    }
+
+    result += stem.substr(stemLength);
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "PowerRenameInterfaces.h"
+#include <string>
+#include <string_view>
+
+// Case transforms of the PowerRename flags (Uppercase, Lowercase, Titlecase and Capitalized, limited by
+// NameOnly and ExtensionOnly) applied to a file or folder name.
+// Upper and lower case use a mapping table built once from the default user locale instead of towupper and
+// towlower after setting the global C++ locale, so names can be transformed on several threads at once.
+// ASCII runs are converted 8 characters at a time.
+class CCaseTransform
+{
+public:
+    CCaseTransform() = default;
+    explicit CCaseTransform(DWORD flags) :
+        m_flags(flags) {}
+
+    // Returns true if the flags contain a case transform.
+    bool Enabled() const { return (m_flags & (Uppercase | Lowercase | Titlecase | Capitalized)) != 0; }
+
+    // Writes the transformed name into result, reusing its buffer.
+    void Transform(std::wstring_view name, bool isFolder, std::wstring& result) const;
+
+    // Splits a file name into its stem and extension like std::filesystem::path does.
+    static void SplitFileName(std::wstring_view name, std::wstring_view& stem, std::wstring_view& extension);
+
+    static void AppendUppercase(std::wstring_view source, std::wstring& result);
+    static void AppendLowercase(std::wstring_view source, std::wstring& result);
+
+private:
+    void AppendWordsCapitalized(std::wstring_view stem, std::wstring& result) const;
+
+    DWORD m_flags = 0;
+};
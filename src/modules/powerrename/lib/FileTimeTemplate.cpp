@@ -0,0 +1,316 @@
+#include "pch.h"
+#include "FileTimeTemplate.h"
+
+#include <algorithm>
+#include <array>
+#include <map>
+#include <mutex>
+
+struct CFileTimeTemplate::DateNames
+{
+    std::array<std::wstring, 12> months;
+    std::array<std::wstring, 12> monthShortNames;
+    // Starting on Sunday, like SYSTEMTIME::wDayOfWeek
+    std::array<std::wstring, 7> days;
+    std::array<std::wstring, 7> dayShortNames;
+};
+
+namespace
+{
+    using Token = CFileTimeTemplate::Token;
+
+    struct TokenPattern
+    {
+        std::wstring_view text;
+        Token token;
+    };
+
+    // In the order the regex passes were made, longer tokens first
+    constexpr TokenPattern tokenPatterns[] = {
+        { L"YYYY", Token::Year4 },
+        { L"YY", Token::Year2 },
+        { L"Y", Token::Year1 },
+        { L"MMMM", Token::MonthName },
+        { L"MMM", Token::MonthShortName },
+        { L"MM", Token::Month2 },
+        { L"M", Token::Month1 },
+        { L"DDDD", Token::DayName },
+        { L"DDD", Token::DayShortName },
+        { L"DD", Token::Day2 },
+        { L"D", Token::Day1 },
+        { L"hh", Token::Hour2 },
+        { L"h", Token::Hour1 },
+        { L"mm", Token::Minute2 },
+        { L"m", Token::Minute1 },
+        { L"ss", Token::Second2 },
+        { L"s", Token::Second1 },
+        { L"fff", Token::Millisecond3 },
+        { L"ff", Token::Millisecond2 },
+        { L"f", Token::Millisecond1 },
+    };
+
+    // Calendars whose month names only depend on the Gregorian month
+    bool HasGregorianMonths(CALTYPE calendar)
+    {
+        switch (calendar)
+        {
+        case CAL_GREGORIAN:
+        case CAL_GREGORIAN_US:
+        case CAL_JAPAN:
+        case CAL_TAIWAN:
+        case CAL_KOREA:
+        case CAL_THAI:
+        case CAL_GREGORIAN_ME_FRENCH:
+        case CAL_GREGORIAN_ARABIC:
+        case CAL_GREGORIAN_XLIT_ENGLISH:
+        case CAL_GREGORIAN_XLIT_FRENCH:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    // Formats a single date part like GetDatedFileName always has, with the first letter uppercased
+    std::wstring FormatDateName(PCWSTR localeName, const SYSTEMTIME& date, PCWSTR format)
+    {
+        wchar_t formattedDate[MAX_PATH] = { 0 };
+        if (GetDateFormatEx(localeName, 0, &date, format, formattedDate, MAX_PATH, nullptr) == 0)
+        {
+            return {};
+        }
+
+        std::wstring name(formattedDate);
+        if (!name.empty())
+        {
+            LCMapStringEx(localeName, LCMAP_UPPERCASE | LCMAP_LINGUISTIC_CASING, name.data(), 1, name.data(), 1, nullptr, nullptr, 0);
+        }
+        return name;
+    }
+
+    std::shared_ptr<const CFileTimeTemplate::DateNames> GetDateNames(const std::wstring& localeName)
+    {
+        static std::mutex cacheMutex;
+        static std::map<std::wstring, std::shared_ptr<const CFileTimeTemplate::DateNames>> cache;
+
+        std::scoped_lock lock(cacheMutex);
+        auto& names = cache[localeName];
+        if (!names)
+        {
+            auto newNames = std::make_shared<CFileTimeTemplate::DateNames>();
+            for (WORD month = 1; month <= 12; month++)
+            {
+                const SYSTEMTIME date{ .wYear = 2000, .wMonth = month, .wDay = 1 };
+                newNames->months[month - 1] = FormatDateName(localeName.c_str(), date, L"MMMM");
+                newNames->monthShortNames[month - 1] = FormatDateName(localeName.c_str(), date, L"MMM");
+            }
+
+            // January 2, 2000 was a Sunday
+            for (WORD day = 0; day < 7; day++)
+            {
+                const SYSTEMTIME date{ .wYear = 2000, .wMonth = 1, .wDayOfWeek = day, .wDay = static_cast<WORD>(2 + day) };
+                newNames->days[day] = FormatDateName(localeName.c_str(), date, L"dddd");
+                newNames->dayShortNames[day] = FormatDateName(localeName.c_str(), date, L"ddd");
+            }
+            names = std::move(newNames);
+        }
+        return names;
+    }
+
+    // Day of week of a Gregorian date, 0 being Sunday
+    int DayOfWeek(int year, int month, int day)
+    {
+        static constexpr int monthOffsets[] = { 0, 3, 2, 5, 0, 3, 5, 1, 4, 6, 2, 4 };
+        if (month < 3)
+        {
+            year--;
+        }
+        return (year + year / 4 - year / 100 + year / 400 + monthOffsets[month - 1] + day) % 7;
+    }
+
+    void AppendNumber(std::wstring& result, unsigned int value, size_t minDigits)
+    {
+        wchar_t digits[16];
+        size_t count = 0;
+        do
+        {
+            digits[count++] = static_cast<wchar_t>(L'0' + value % 10);
+            value /= 10;
+        } while (value != 0);
+
+        for (; count < minDigits; count++)
+        {
+            digits[count] = L'0';
+        }
+
+        while (count > 0)
+        {
+            result.push_back(digits[--count]);
+        }
+    }
+}
+
+CFileTimeTemplate::CFileTimeTemplate(std::wstring_view replaceTerm)
+{
+    // End of the last token and the pattern it was replaced by, a token directly following the same token
+    // after its $ isn't replaced by that pattern
+    size_t lastTokenEnd = std::wstring_view::npos;
+    Token lastToken{};
+
+    size_t literalStart = 0;
+    size_t i = 0;
+    while (i < replaceTerm.size())
+    {
+        if (replaceTerm[i] != L'$')
+        {
+            i++;
+            continue;
+        }
+
+        const size_t runStart = i;
+        while (i < replaceTerm.size() && replaceTerm[i] == L'$')
+        {
+            i++;
+        }
+
+        // Pairs of $ are escaped $, so only an odd number of them starts a token
+        if ((i - runStart) % 2 == 0)
+        {
+            continue;
+        }
+
+        const std::wstring_view rest = replaceTerm.substr(i);
+        for (const auto& pattern : tokenPatterns)
+        {
+            if (!rest.starts_with(pattern.text) || (lastTokenEnd == runStart && lastToken == pattern.token))
+            {
+                continue;
+            }
+
+            m_parts.push_back({ std::wstring(replaceTerm.substr(literalStart, i - 1 - literalStart)), pattern.token });
+            i += pattern.text.size();
+            literalStart = i;
+            lastTokenEnd = i;
+            lastToken = pattern.token;
+            break;
+        }
+    }
+    m_tail = replaceTerm.substr(literalStart);
+
+    const bool usesNames = std::any_of(m_parts.begin(), m_parts.end(), [](const Part& part) {
+        return part.token == Token::MonthName || part.token == Token::MonthShortName || part.token == Token::DayName || part.token == Token::DayShortName;
+    });
+
+    if (usesNames)
+    {
+        wchar_t localeName[LOCALE_NAME_MAX_LENGTH];
+        if (GetUserDefaultLocaleName(localeName, LOCALE_NAME_MAX_LENGTH) == 0)
+        {
+            StringCchCopy(localeName, LOCALE_NAME_MAX_LENGTH, L"en_US");
+        }
+        m_localeName = localeName;
+
+        CALTYPE calendar = 0;
+        if (GetLocaleInfoEx(localeName, LOCALE_ICALENDARTYPE | LOCALE_RETURN_NUMBER, reinterpret_cast<LPWSTR>(&calendar), sizeof(calendar) / sizeof(wchar_t)) != 0 && HasGregorianMonths(calendar))
+        {
+            m_names = GetDateNames(m_localeName);
+        }
+    }
+}
+
+void CFileTimeTemplate::Format(const SYSTEMTIME& fileTime, std::wstring& result) const
+{
+    result.clear();
+    for (const auto& part : m_parts)
+    {
+        result += part.literal;
+        switch (part.token)
+        {
+        case Token::Year4:
+            AppendNumber(result, fileTime.wYear, 4);
+            break;
+        case Token::Year2:
+            AppendNumber(result, fileTime.wYear % 100, 2);
+            break;
+        case Token::Year1:
+            AppendNumber(result, fileTime.wYear % 10, 1);
+            break;
+        case Token::Month2:
+            AppendNumber(result, fileTime.wMonth, 2);
+            break;
+        case Token::Month1:
+            AppendNumber(result, fileTime.wMonth, 1);
+            break;
+        case Token::Day2:
+            AppendNumber(result, fileTime.wDay, 2);
+            break;
+        case Token::Day1:
+            AppendNumber(result, fileTime.wDay, 1);
+            break;
+        case Token::Hour2:
+            AppendNumber(result, fileTime.wHour, 2);
+            break;
+        case Token::Hour1:
+            AppendNumber(result, fileTime.wHour, 1);
+            break;
+        case Token::Minute2:
+            AppendNumber(result, fileTime.wMinute, 2);
+            break;
+        case Token::Minute1:
+            AppendNumber(result, fileTime.wMinute, 1);
+            break;
+        case Token::Second2:
+            AppendNumber(result, fileTime.wSecond, 2);
+            break;
+        case Token::Second1:
+            AppendNumber(result, fileTime.wSecond, 1);
+            break;
+        case Token::Millisecond3:
+            AppendNumber(result, fileTime.wMilliseconds, 3);
+            break;
+        case Token::Millisecond2:
+            AppendNumber(result, fileTime.wMilliseconds / 10, 2);
+            break;
+        case Token::Millisecond1:
+            AppendNumber(result, fileTime.wMilliseconds / 100, 1);
+            break;
+        default:
+            AppendName(fileTime, part.token, result);
+            break;
+        }
+    }
+    result += m_tail;
+}
+
+void CFileTimeTemplate::AppendName(const SYSTEMTIME& fileTime, Token token, std::wstring& result) const
+{
+    if (!m_names)
+    {
+        PCWSTR format = token == Token::MonthName ? L"MMMM" : token == Token::MonthShortName ? L"MMM" : token == Token::DayName ? L"dddd" : L"ddd";
+        result += FormatDateName(m_localeName.c_str(), fileTime, format);
+        return;
+    }
+
+    // GetDateFormatEx fails on invalid dates, which left the names empty
+    SYSTEMTIME date{ .wYear = fileTime.wYear, .wMonth = fileTime.wMonth, .wDay = fileTime.wDay };
+    FILETIME unused;
+    if (!SystemTimeToFileTime(&date, &unused))
+    {
+        return;
+    }
+
+    switch (token)
+    {
+    case Token::MonthName:
+        result += m_names->months[fileTime.wMonth - 1];
+        break;
+    case Token::MonthShortName:
+        result += m_names->monthShortNames[fileTime.wMonth - 1];
+        break;
+    case Token::DayName:
+        result += m_names->days[DayOfWeek(fileTime.wYear, fileTime.wMonth, fileTime.wDay)];
+        break;
+    case Token::DayShortName:
+        result += m_names->dayShortNames[DayOfWeek(fileTime.wYear, fileTime.wMonth, fileTime.wDay)];
+        break;
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Replace term with its file time tokens ($YYYY, $MMM, $DD, $hh, ...) parsed once, so expanding it for the time
+// of each file is a single pass over the parts instead of a regex compile and replace for each token.
+// Tokens are replaced like the per-token regex passes PowerRename used before: a token counts only after an odd
+// number of $, and a token directly following the same token after its $ is left to the shorter tokens.
+// Month and day names are looked up once per locale.
+class CFileTimeTemplate
+{
+public:
+    CFileTimeTemplate() = default;
+    explicit CFileTimeTemplate(std::wstring_view replaceTerm);
+
+    // Returns true if the replace term contains any file time token.
+    bool UsesFileTime() const { return !m_parts.empty(); }
+
+    // Writes the replace term with its tokens replaced by the parts of fileTime into result, reusing its buffer.
+    void Format(const SYSTEMTIME& fileTime, std::wstring& result) const;
+
+    struct DateNames;
+
+    enum class Token : unsigned char
+    {
+        Year4,
+        Year2,
+        Year1,
+        MonthName,
+        MonthShortName,
+        Month2,
+        Month1,
+        DayName,
+        DayShortName,
+        Day2,
+        Day1,
+        Hour2,
+        Hour1,
+        Minute2,
+        Minute1,
+        Second2,
+        Second1,
+        Millisecond3,
+        Millisecond2,
+        Millisecond1,
+    };
+
+private:
+    struct Part
+    {
+        std::wstring literal;
+        Token token;
+    };
+
+    void AppendName(const SYSTEMTIME& fileTime, Token token, std::wstring& result) const;
+
+    std::vector<Part> m_parts;
+    std::wstring m_tail;
+    std::wstring m_localeName;
+    // nullptr if the names depend on more than the month and day of week in the calendar of the locale
+    std::shared_ptr<const DateNames> m_names;
+};
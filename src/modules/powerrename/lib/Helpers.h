@@ -2,6 +2,7 @@
 
 #include "PowerRenameInterfaces.h"
 
+#include <functional>
 #include <string>
 
 HRESULT GetTrimmedFileName(_Out_ PWSTR result, UINT cchMax, _In_ PCWSTR source);
@@ -10,13 +11,6 @@ HRESULT GetDatedFileName(_Out_ PWSTR result, UINT cchMax, _In_ PCWSTR source, SY
 bool isFileTimeUsed(_In_ PCWSTR source);
 bool DataObjectContainsRenamableItem(_In_ IUnknown* dataSource);
 HRESULT GetShellItemArrayFromDataObject(_In_ IUnknown* dataSource, _COM_Outptr_ IShellItemArray** items);
-BOOL GetEnumeratedFileName(
-    __out_ecount(cchMax) PWSTR pszUniqueName,
-    UINT cchMax,
-    __in PCWSTR pszTemplate,
-    __in_opt PCWSTR pszDir,
-    unsigned long ulMinLong,
-    __inout unsigned long* pulNumUsed);
 HWND CreateMsgWindow(_In_ HINSTANCE hInst, _In_ WNDPROC pfnWndProc, _In_ void* p);
 
 std::wstring GetRegString(const std::wstring& valueName, const std::wstring& subPath);
@@ -25,3 +19,7 @@ void SetRegNumber(const std::wstring& valueName, unsigned int value);
 bool GetRegBoolean(const std::wstring& valueName, bool defaultValue);
 void SetRegBoolean(const std::wstring& valueName, bool value);
 bool LastModifiedTime(const std::wstring& filePath, FILETIME* lpFileTime);
+
+// Calls func for consecutive [begin, end) chunks of [0, count), spread across the available cores.
+// The calling thread takes part and the call returns once every chunk is done.
+void ParallelForChunks(size_t count, size_t chunkSize, const std::function<void(size_t begin, size_t end)>& func);
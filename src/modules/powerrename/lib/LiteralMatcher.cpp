@@ -0,0 +1,151 @@
+#include "pch.h"
+#include "LiteralMatcher.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cwctype>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define LITERAL_MATCHER_SSE2
+#endif
+
+namespace
+{
+    inline wchar_t FoldCase(wchar_t c)
+    {
+        if (c < 0x80)
+        {
+            return (c >= L'A' && c <= L'Z') ? static_cast<wchar_t>(c | 0x20) : c;
+        }
+        return static_cast<wchar_t>(towlower(c));
+    }
+}
+
+CLiteralMatcher::CLiteralMatcher(std::wstring_view pattern, bool caseSensitive) :
+    m_pattern(pattern), m_caseSensitive(caseSensitive)
+{
+    if (!m_caseSensitive)
+    {
+        std::transform(m_pattern.begin(), m_pattern.end(), m_pattern.begin(), FoldCase);
+    }
+}
+
+bool CLiteralMatcher::MatchesAt(std::wstring_view text, size_t pos) const
+{
+    if (m_caseSensitive)
+    {
+        return text.compare(pos, m_pattern.size(), m_pattern) == 0;
+    }
+
+    for (size_t i = 0; i < m_pattern.size(); i++)
+    {
+        if (FoldCase(text[pos + i]) != m_pattern[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t CLiteralMatcher::Find(std::wstring_view text, size_t pos) const
+{
+    const size_t patternLength = m_pattern.size();
+    if (patternLength == 0 || pos > text.size() || text.size() - pos < patternLength)
+    {
+        return std::wstring_view::npos;
+    }
+
+    // Last position a match can start at
+    const size_t lastStart = text.size() - patternLength;
+    const wchar_t first = m_pattern[0];
+    size_t i = pos;
+
+#ifdef LITERAL_MATCHER_SSE2
+    if constexpr (sizeof(wchar_t) == sizeof(uint16_t))
+    {
+        // Look for candidates for the first pattern character 8 UTF-16 units at a time.
+        const __m128i firstChar = _mm_set1_epi16(static_cast<short>(first));
+        const __m128i nonAsciiBits = _mm_set1_epi16(static_cast<short>(0xFF80));
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i upperA = _mm_set1_epi16(static_cast<short>(L'A' - 1));
+        const __m128i upperZ = _mm_set1_epi16(static_cast<short>(L'Z' + 1));
+        const __m128i caseBit = _mm_set1_epi16(0x20);
+
+        for (; i + 8 <= lastStart + 1; i += 8)
+        {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + i));
+            unsigned int candidates = 0;
+            if (m_caseSensitive)
+            {
+                candidates = static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpeq_epi16(block, firstChar)));
+            }
+            else if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(block, nonAsciiBits), zero)) == 0xFFFF)
+            {
+                // All ASCII: fold A-Z in the register
+                const __m128i isUpper = _mm_and_si128(_mm_cmpgt_epi16(block, upperA), _mm_cmplt_epi16(block, upperZ));
+                block = _mm_or_si128(block, _mm_and_si128(isUpper, caseBit));
+                candidates = static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpeq_epi16(block, firstChar)));
+            }
+            else
+            {
+                for (unsigned int j = 0; j < 8; j++)
+                {
+                    if (FoldCase(text[i + j]) == first)
+                    {
+                        candidates |= 3u << (j * 2);
+                    }
+                }
+            }
+
+            while (candidates != 0)
+            {
+                const int bit = std::countr_zero(candidates);
+                const size_t candidate = i + bit / 2;
+                if (MatchesAt(text, candidate))
+                {
+                    return candidate;
+                }
+                candidates &= ~(3u << bit);
+            }
+        }
+    }
+#endif
+
+    for (; i <= lastStart; i++)
+    {
+        const wchar_t c = m_caseSensitive ? text[i] : FoldCase(text[i]);
+        if (c == first && MatchesAt(text, i))
+        {
+            return i;
+        }
+    }
+
+    return std::wstring_view::npos;
+}
+
+bool CLiteralMatcher::Replace(std::wstring_view source, std::wstring_view replacement, bool allOccurrences, std::wstring& result) const
+{
+    result.clear();
+
+    bool matched = false;
+    size_t copied = 0;
+    size_t pos = Find(source, 0);
+    while (pos != std::wstring_view::npos)
+    {
+        matched = true;
+        result.append(source, copied, pos - copied);
+        result.append(replacement);
+        copied = pos + m_pattern.size();
+
+        if (!allOccurrences)
+        {
+            break;
+        }
+        pos = Find(source, copied);
+    }
+
+    result.append(source, copied);
+    return matched;
+}
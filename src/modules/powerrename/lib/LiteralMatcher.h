@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+// Plain (non-regex) search and replace used by CPowerRenameRegEx.
+// The pattern is case folded once on construction and the source is folded on the fly while
+// scanning, so matching doesn't allocate. Case folding is the same per-character towlower the
+// literal search has always used.
+class CLiteralMatcher
+{
+public:
+    CLiteralMatcher() = default;
+    CLiteralMatcher(std::wstring_view pattern, bool caseSensitive);
+
+    // Returns the position of the first match at or after pos, or std::wstring_view::npos.
+    size_t Find(std::wstring_view text, size_t pos = 0) const;
+
+    // Writes source with the first (or every) non-overlapping match replaced into result, reusing
+    // its buffer. Returns true if anything matched.
+    bool Replace(std::wstring_view source, std::wstring_view replacement, bool allOccurrences, std::wstring& result) const;
+
+    const std::wstring& Pattern() const { return m_pattern; }
+
+private:
+    bool MatchesAt(std::wstring_view text, size_t pos) const;
+
+    std::wstring m_pattern;
+    bool m_caseSensitive = false;
+};
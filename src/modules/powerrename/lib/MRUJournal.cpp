@@ -0,0 +1,84 @@
+#include "pch.h"
+#include "MRUJournal.h"
+
+#include <charconv>
+
+CMRUJournal::CMRUJournal(std::wstring filePath) :
+    m_filePath(std::move(filePath))
+{
+}
+
+bool CMRUJournal::Append(std::wstring_view item)
+{
+    if (!m_file.is_open())
+    {
+        m_file.clear();
+        m_file.open(m_filePath, std::ios::binary | std::ios::app);
+    }
+
+    EncodeRecord(item, m_record);
+    return m_file.write(m_record.data(), m_record.size()) && m_file.flush();
+}
+
+void CMRUJournal::Close()
+{
+    m_file.close();
+}
+
+void CMRUJournal::EncodeRecord(std::wstring_view item, std::string& record)
+{
+    const int itemLength = static_cast<int>(item.size());
+    const int utf8Length = itemLength > 0 ? WideCharToMultiByte(CP_UTF8, 0, item.data(), itemLength, nullptr, 0, nullptr, nullptr) : 0;
+
+    record = std::to_string(utf8Length);
+    record += ':';
+    const size_t start = record.size();
+    record.resize(start + utf8Length);
+    if (utf8Length > 0)
+    {
+        WideCharToMultiByte(CP_UTF8, 0, item.data(), itemLength, record.data() + start, utf8Length, nullptr, nullptr);
+    }
+    record += '\n';
+}
+
+size_t CMRUJournal::Replay(std::string_view contents, const std::function<void(std::wstring_view item)>& onItem)
+{
+    size_t count = 0;
+    std::wstring item;
+    while (!contents.empty())
+    {
+        size_t utf8Length = 0;
+        const auto [lengthEnd, error] = std::from_chars(contents.data(), contents.data() + contents.size(), utf8Length);
+        const size_t recordStart = lengthEnd - contents.data();
+        if (error != std::errc() || recordStart >= contents.size() || contents[recordStart] != ':' ||
+            contents.size() - recordStart - 1 <= utf8Length || contents[recordStart + 1 + utf8Length] != '\n')
+        {
+            break;
+        }
+
+        const std::string_view utf8 = contents.substr(recordStart + 1, utf8Length);
+        const int length = utf8.empty() ? 0 : MultiByteToWideChar(CP_UTF8, 0, utf8.data(), static_cast<int>(utf8.size()), nullptr, 0);
+        item.resize(length);
+        if (length > 0)
+        {
+            MultiByteToWideChar(CP_UTF8, 0, utf8.data(), static_cast<int>(utf8.size()), item.data(), length);
+        }
+
+        onItem(item);
+        count++;
+        contents.remove_prefix(recordStart + utf8Length + 2);
+    }
+    return count;
+}
+
+size_t CMRUJournal::ReplayFile(const std::wstring& filePath, const std::function<void(std::wstring_view item)>& onItem)
+{
+    std::ifstream file(filePath, std::ios::binary);
+    if (!file.is_open())
+    {
+        return 0;
+    }
+
+    const std::string contents{ std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+    return Replay(contents, onItem);
+}
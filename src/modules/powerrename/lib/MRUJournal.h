@@ -0,0 +1,32 @@
+#pragma once
+
+#include <fstream>
+#include <functional>
+#include <string>
+#include <string_view>
+
+// Append-only log of the strings pushed to an MRU list since its last saved snapshot.
+// Each record is "<UTF-8 byte count>:<UTF-8 bytes>\n". A record torn by a crash in the middle of a write doesn't
+// end where its count says, so it is dropped along with anything after it.
+// Records are flushed to the OS but not to the disk, so they survive the process crashing but not the machine
+// losing power. A push costs a write instead of a disk round trip, and losing the last few MRU entries is harmless.
+class CMRUJournal
+{
+public:
+    explicit CMRUJournal(std::wstring filePath);
+
+    // Opens the file on first use and flushes the record to the OS before returning
+    bool Append(std::wstring_view item);
+    void Close();
+
+    static void EncodeRecord(std::wstring_view item, std::string& record);
+
+    // Calls onItem for each complete record at the start of contents, returns how many there were
+    static size_t Replay(std::string_view contents, const std::function<void(std::wstring_view item)>& onItem);
+    static size_t ReplayFile(const std::wstring& filePath, const std::function<void(std::wstring_view item)>& onItem);
+
+private:
+    std::wstring m_filePath;
+    std::ofstream m_file;
+    std::string m_record;
+};
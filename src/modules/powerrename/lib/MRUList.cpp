@@ -0,0 +1,42 @@
+#include "pch.h"
+#include "MRUList.h"
+
+CMRUList::CMRUList(size_t capacity) :
+    m_capacity(capacity)
+{
+    m_index.reserve(capacity);
+}
+
+void CMRUList::Push(std::wstring_view item)
+{
+    if (m_capacity == 0)
+    {
+        return;
+    }
+
+    if (auto existing = m_index.find(item); existing != m_index.end())
+    {
+        m_items.splice(m_items.begin(), m_items, existing->second);
+        return;
+    }
+
+    if (m_items.size() == m_capacity)
+    {
+        m_index.erase(m_items.back());
+        m_items.pop_back();
+    }
+
+    m_items.emplace_front(item);
+    m_index.emplace(m_items.front(), m_items.begin());
+}
+
+bool CMRUList::Contains(std::wstring_view item) const
+{
+    return m_index.find(item) != m_index.end();
+}
+
+void CMRUList::Clear()
+{
+    m_index.clear();
+    m_items.clear();
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Most recently used strings, most recent first, holding at most capacity of them.
+// Pushing a string which is already in the list moves it to the front instead of adding it again, and the
+// least recently used string is dropped when the list is full. Both are O(1) through a hash index of the items.
+class CMRUList
+{
+public:
+    explicit CMRUList(size_t capacity);
+
+    CMRUList(const CMRUList&) = delete;
+    CMRUList& operator=(const CMRUList&) = delete;
+
+    void Push(std::wstring_view item);
+    bool Contains(std::wstring_view item) const;
+    void Clear();
+
+    size_t Size() const { return m_items.size(); }
+    size_t Capacity() const { return m_capacity; }
+
+    // Most recent first
+    const std::list<std::wstring>& Items() const { return m_items; }
+
+private:
+    size_t m_capacity;
+    std::list<std::wstring> m_items;
+    // Views into the nodes of m_items, which don't move when the list is reordered
+    std::unordered_map<std::wstring_view, std::list<std::wstring>::iterator> m_index;
+};
@@ -10,46 +10,68 @@ namespace
     const wchar_t c_mruList[] = L"MRUList";
     const wchar_t c_insertionIdx[] = L"InsertionIdx";
     const wchar_t c_maxMRUSize[] = L"MaxMRUSize";
+    const wchar_t c_journalExtension[] = L".journal";
+    const wchar_t c_rotatedJournalExtension[] = L".journal.old";
+
+    // The journal is compacted after this many records, or after as many as the list holds if that's more
+    const size_t c_minCompactionRecords = 32;
 }
 
 MRUListHandler::MRUListHandler(unsigned int size, const std::wstring& filePath, const std::wstring& regPath) :
-    pushIdx(0),
-    nextIdx(1),
     size(size),
     jsonFilePath(PTSettingsHelper::get_module_save_folder_location(PowerRenameConstants::ModuleKey) + filePath),
-    registryFilePath(regPath)
+    journalFilePath(jsonFilePath + c_journalExtension),
+    rotatedJournalFilePath(jsonFilePath + c_rotatedJournalExtension),
+    registryFilePath(regPath),
+    mruList(size),
+    journal(journalFilePath),
+    journalRecords(0),
+    itemsChanged(true),
+    nextIdx(1)
 {
-    items.resize(size);
     Load();
 }
 
+MRUListHandler::~MRUListHandler()
+{
+    if (compaction.joinable())
+    {
+        compaction.join();
+    }
+}
+
 void MRUListHandler::Push(const std::wstring& data)
 {
-    if (Exists(data))
+    if (data.empty())
     {
-        // TODO: Already existing item should be put on top of MRU list.
         return;
     }
-    items[pushIdx] = data;
-    pushIdx = (pushIdx + 1) % size;
-    Save();
+
+    if (!mruList.Items().empty() && mruList.Items().front() == data)
+    {
+        return;
+    }
+
+    mruList.Push(data);
+    itemsChanged = true;
+
+    journal.Append(data);
+    if (++journalRecords >= max(static_cast<size_t>(size), c_minCompactionRecords))
+    {
+        Compact();
+    }
 }
 
 bool MRUListHandler::Next(std::wstring& data)
 {
-    if (nextIdx == size + 1)
-    {
-        Reset();
-        return false;
-    }
-    // Go backwards to consume latest items first.
-    unsigned int idx = (pushIdx + size - nextIdx) % size;
-    if (items[idx].empty())
+    // Go from the latest item to the oldest one.
+    const std::vector<std::wstring>& mruItems = GetItems();
+    if (nextIdx > mruItems.size())
     {
         Reset();
         return false;
     }
-    data = items[idx];
+    data = mruItems[nextIdx - 1];
     ++nextIdx;
     return true;
 }
@@ -61,6 +83,11 @@ void MRUListHandler::Reset()
 
 const std::vector<std::wstring>& MRUListHandler::GetItems()
 {
+    if (itemsChanged)
+    {
+        items.assign(mruList.Items().begin(), mruList.Items().end());
+        itemsChanged = false;
+    }
     return items;
 }
 
@@ -76,30 +103,97 @@ void MRUListHandler::Load()
     {
         ParseJson();
     }
+
+    // Replaying the rotated journal again after its compaction wrote the snapshot is harmless: moving the same
+    // items to the front in the same order leaves the list as it was.
+    const auto push = [this](std::wstring_view item) { mruList.Push(item); };
+    CMRUJournal::ReplayFile(rotatedJournalFilePath, push);
+    journalRecords = CMRUJournal::ReplayFile(journalFilePath, push);
+
+    if (FoldRotatedJournal() && std::filesystem::exists(journalFilePath))
+    {
+        // Also drops a record torn by a crash, which would hide the records appended after it
+        Compact();
+    }
 }
 
-void MRUListHandler::Save()
+bool MRUListHandler::Save()
 {
-    json::JsonObject jsonData;
+    return json::to_file_atomic(jsonFilePath, Serialize());
+}
 
-    jsonData.SetNamedValue(c_maxMRUSize, json::value(size));
-    jsonData.SetNamedValue(c_insertionIdx, json::value(pushIdx));
-    jsonData.SetNamedValue(c_mruList, Serialize());
+void MRUListHandler::Compact()
+{
+    if (compaction.joinable())
+    {
+        compaction.join();
+    }
+
+    if (!FoldRotatedJournal())
+    {
+        return;
+    }
 
-    json::to_file(jsonFilePath, jsonData);
+    journal.Close();
+    std::error_code err;
+    std::filesystem::rename(journalFilePath, rotatedJournalFilePath, err);
+    if (err)
+    {
+        return;
+    }
+    journalRecords = 0;
+
+    // The JSON is built here, only the file system work is left to the background thread
+    // write_file_atomic flushes the snapshot to the disk before replacing the file, so the rotated journal is only
+    // removed once the snapshot holding its records has been written through.
+    compaction = std::thread([snapshot = json::serialize(Serialize()), jsonFilePath = jsonFilePath, rotatedJournalFilePath = rotatedJournalFilePath] {
+        if (json::write_file_atomic(jsonFilePath, snapshot))
+        {
+            std::error_code err;
+            std::filesystem::remove(rotatedJournalFilePath, err);
+        }
+    });
 }
 
-json::JsonArray MRUListHandler::Serialize()
+bool MRUListHandler::FoldRotatedJournal()
 {
+    // A compaction which didn't get to write its snapshot leaves the rotated journal behind. It's saved
+    // synchronously, since rotating the journal again would overwrite it.
+    if (!std::filesystem::exists(rotatedJournalFilePath))
+    {
+        return true;
+    }
+
+    if (!Save())
+    {
+        return false;
+    }
+
+    std::error_code err;
+    return std::filesystem::remove(rotatedJournalFilePath, err);
+}
+
+json::JsonObject MRUListHandler::Serialize()
+{
+    // Laid out like the ring buffer older versions kept, oldest item first
     json::JsonArray searchMRU{};
 
-    std::wstring data{};
-    for (const std::wstring& item : items)
+    for (auto it = mruList.Items().rbegin(); it != mruList.Items().rend(); ++it)
     {
-        searchMRU.Append(json::value(item));
+        searchMRU.Append(json::value(*it));
     }
+    for (size_t i = mruList.Size(); i < size; ++i)
+    {
+        searchMRU.Append(json::value(std::wstring{}));
+    }
+
+    json::JsonObject jsonData;
+
+    jsonData.SetNamedValue(c_maxMRUSize, json::value(size));
+    jsonData.SetNamedValue(c_insertionIdx, json::value(static_cast<unsigned int>(mruList.Size() % max(size, 1u))));
+    jsonData.SetNamedValue(c_mruList, searchMRU);
 
-    return searchMRU;
+    return jsonData;
 }
 
 void MRUListHandler::MigrateFromRegistry()
@@ -108,7 +202,11 @@ void MRUListHandler::MigrateFromRegistry()
     std::sort(std::begin(searchListKeys), std::end(searchListKeys));
     for (const wchar_t& key : searchListKeys)
     {
-        Push(GetRegString(std::wstring(1, key), registryFilePath));
+        std::wstring data = GetRegString(std::wstring(1, key), registryFilePath);
+        if (!data.empty())
+        {
+            mruList.Push(data);
+        }
     }
 }
 
@@ -134,37 +232,24 @@ void MRUListHandler::ParseJson()
                     oldPushIdx = 0;
                 }
             }
-            if (json::has(jsonObject, c_mruList, json::JsonValueType::Array))
+            if (json::has(jsonObject, c_mruList, json::JsonValueType::Array) && oldSize > 0)
             {
+                // The array is a ring buffer whose oldest item is at the insertion index
                 auto jsonArray = jsonObject.GetNamedArray(c_mruList);
-                if (oldSize == size)
+                for (unsigned int i = 0; i < oldSize; ++i)
                 {
-                    for (uint32_t i = 0; i < jsonArray.Size(); ++i)
+                    unsigned int idx = (oldPushIdx + i) % oldSize;
+                    if (idx < jsonArray.Size())
                     {
-                        items[i] = std::wstring(jsonArray.GetStringAt(i));
+                        std::wstring data{ jsonArray.GetStringAt(idx) };
+                        if (!data.empty())
+                        {
+                            mruList.Push(data);
+                        }
                     }
-                    pushIdx = oldPushIdx;
                 }
-                else
+                if (oldSize != size)
                 {
-                    std::vector<std::wstring> temp;
-                    for (unsigned int i = 0; i < min(jsonArray.Size(), size); ++i)
-                    {
-                        int idx = (oldPushIdx + oldSize - (i + 1)) % oldSize;
-                        temp.push_back(std::wstring(jsonArray.GetStringAt(idx)));
-                    }
-                    if (size > oldSize)
-                    {
-                        std::reverse(std::begin(temp), std::end(temp));
-                        pushIdx = (unsigned int)temp.size();
-                        temp.resize(size);
-                    }
-                    else
-                    {
-                        temp.resize(size);
-                        std::reverse(std::begin(temp), std::end(temp));
-                    }
-                    items = std::move(temp);
                     Save();
                 }
             }
@@ -174,8 +259,3 @@ void MRUListHandler::ParseJson()
         }
     }
 }
-
-bool MRUListHandler::Exists(const std::wstring& data)
-{
-    return std::find(std::begin(items), std::end(items), data) != std::end(items);
-}
@@ -3,33 +3,48 @@
 
 #include <filesystem>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include <common/utils/json.h>
 
+#include "MRUJournal.h"
+#include "MRUList.h"
+
+// Pushes are appended to a journal next to the JSON file instead of rewriting it every time. Once the journal
+// holds enough records it is rotated out and the JSON snapshot is rewritten on a background thread.
 class MRUListHandler
 {
 public:
     MRUListHandler(unsigned int size, const std::wstring& filePath, const std::wstring& regPath);
+    ~MRUListHandler();
 
     void Push(const std::wstring& data);
     bool Next(std::wstring& data);
 
     void Reset();
 
+    // Most recent first
     const std::vector<std::wstring>& GetItems();
 private:
     void Load();
-    void Save();
+    bool Save();
+    void Compact();
+    bool FoldRotatedJournal();
     void MigrateFromRegistry();
-    json::JsonArray Serialize();
+    json::JsonObject Serialize();
     void ParseJson();
 
-    bool Exists(const std::wstring& data);
-
-    std::vector<std::wstring> items;
-    unsigned int pushIdx;
-    unsigned int nextIdx;
     unsigned int size;
     const std::wstring jsonFilePath;
+    const std::wstring journalFilePath;
+    const std::wstring rotatedJournalFilePath;
     const std::wstring registryFilePath;
+    CMRUList mruList;
+    CMRUJournal journal;
+    size_t journalRecords;
+    std::thread compaction;
+    std::vector<std::wstring> items;
+    bool itemsChanged;
+    unsigned int nextIdx;
 };
@@ -2,6 +2,369 @@
 #include "PowerRenameEnum.h"
 #include <ShlGuid.h>
 #include <helpers.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace
+{
+    // We shouldn't get this deep since we only enum the contents of
+    // regular folders but adding just in case
+    const int c_maxDepth = MAX_PATH / 2;
+
+    // Number of shell items fetched per IEnumShellItems::Next call
+    const ULONG c_enumBatchSize = 64;
+
+    // Folder enumeration is mostly I/O bound, so a few threads are enough to keep ahead of the UI.
+    const unsigned int c_maxPrefetchThreads = 4;
+
+    // Folders are only read ahead while fewer than this many items wait to be added to the manager,
+    // so a large tree isn't held in memory faster than the manager takes it.
+    const size_t c_maxPrefetchedItems = 64 * 1024;
+
+    // How often a blocked enumeration checks whether it was canceled
+    const std::chrono::milliseconds c_cancelPollInterval{ 50 };
+}
+
+struct EnumFolderEntry
+{
+    PIDLIST_ABSOLUTE pidl = nullptr;
+    bool isFolder = false;
+    // LCMapStringEx sort key of the name, compared bytewise
+    std::string sortKey;
+    std::wstring name;
+    // Contents of the folder, filled in by the prefetcher
+    std::shared_ptr<EnumFolderListing> contents;
+};
+
+// Sorted contents of one folder. Entries hold absolute ID lists rather than shell items so they can be
+// handed from the prefetch threads to the enumerating thread without marshaling.
+struct EnumFolderListing
+{
+    EnumFolderListing(PIDLIST_ABSOLUTE folderPidl, int folderDepth) :
+        pidl(folderPidl), depth(folderDepth)
+    {
+    }
+
+    ~EnumFolderListing()
+    {
+        CoTaskMemFree(pidl);
+        for (auto& entry : entries)
+        {
+            CoTaskMemFree(entry.pidl);
+        }
+    }
+
+    EnumFolderListing(const EnumFolderListing&) = delete;
+    EnumFolderListing& operator=(const EnumFolderListing&) = delete;
+
+    PIDLIST_ABSOLUTE pidl = nullptr;
+    int depth = 0;
+    std::vector<EnumFolderEntry> entries;
+    HRESULT hr = S_OK;
+    bool ready = false;
+};
+
+namespace
+{
+    std::string GetCollationKey(_In_ PCWSTR name)
+    {
+        // Same ordering as StrCmpLogicalW, which the shell uses to sort by name
+        const DWORD flags = LCMAP_SORTKEY | NORM_IGNORECASE | SORT_DIGITSASNUMBERS;
+        std::string key;
+        int size = LCMapStringEx(LOCALE_NAME_USER_DEFAULT, flags, name, -1, nullptr, 0, nullptr, nullptr, 0);
+        if (size > 0)
+        {
+            key.resize(size);
+            size = LCMapStringEx(LOCALE_NAME_USER_DEFAULT, flags, name, -1, reinterpret_cast<LPWSTR>(key.data()), size, nullptr, nullptr, 0);
+            key.resize(size > 0 ? size : 0);
+        }
+        return key;
+    }
+
+    // Reads every item of the enumerator into listing and sorts it in display order: folders first, then by name.
+    void ReadFolderListing(_In_ IEnumShellItems* pesi, _In_ EnumFolderListing& listing, _In_ const std::atomic<bool>& canceled)
+    {
+        IShellItem* items[c_enumBatchSize] = {};
+        ULONG fetched = 0;
+        HRESULT hr = S_OK;
+        while (hr == S_OK && !canceled)
+        {
+            fetched = 0;
+            hr = pesi->Next(c_enumBatchSize, items, &fetched);
+            if (FAILED(hr))
+            {
+                break;
+            }
+
+            for (ULONG i = 0; i < fetched; i++)
+            {
+                EnumFolderEntry entry;
+                if (SUCCEEDED(SHGetIDListFromObject(items[i], &entry.pidl)))
+                {
+                    SFGAOF att = 0;
+                    if (SUCCEEDED(items[i]->GetAttributes(SFGAO_FOLDER | SFGAO_STREAM, &att)))
+                    {
+                        // Some items can be both folders and streams (ex: zip folders).
+                        entry.isFolder = (att & SFGAO_FOLDER) && !(att & SFGAO_STREAM);
+                    }
+
+                    PWSTR name = nullptr;
+                    if (SUCCEEDED(items[i]->GetDisplayName(SIGDN_PARENTRELATIVEPARSING, &name)))
+                    {
+                        entry.name = name;
+                        entry.sortKey = GetCollationKey(name);
+                        CoTaskMemFree(name);
+                    }
+
+                    listing.entries.push_back(std::move(entry));
+                }
+                items[i]->Release();
+            }
+        }
+
+        std::sort(listing.entries.begin(), listing.entries.end(), [](const EnumFolderEntry& l, const EnumFolderEntry& r) {
+            if (l.isFolder != r.isFolder)
+            {
+                return l.isFolder;
+            }
+            if (l.sortKey != r.sortKey)
+            {
+                return l.sortKey < r.sortKey;
+            }
+            return l.name < r.name;
+        });
+
+        for (auto& entry : listing.entries)
+        {
+            if (entry.isFolder)
+            {
+                PIDLIST_ABSOLUTE folderPidl = ILCloneFull(entry.pidl);
+                if (folderPidl)
+                {
+                    entry.contents = std::make_shared<EnumFolderListing>(folderPidl, listing.depth + 1);
+                }
+            }
+        }
+    }
+}
+
+// Enumerates subfolders on a few background threads ahead of the thread adding items to the manager.
+// Folders are picked in roughly the order they will be needed: the subfolders of a finished folder go
+// to the front of the queue. Once c_maxPrefetchedItems items have been read ahead, the threads only
+// read the folder the enumerating thread is waiting for. If no thread can be started, the enumerating
+// thread reads each folder itself when it needs it.
+class CEnumFolderPrefetcher
+{
+public:
+    using ThreadStarter = std::function<std::thread(std::function<void()> threadProc)>;
+
+    CEnumFolderPrefetcher(const std::atomic<bool>& canceled, ThreadStarter startThread) :
+        m_canceled(canceled), m_startThread(std::move(startThread))
+    {
+    }
+
+    ~CEnumFolderPrefetcher()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_workAvailable.notify_all();
+        for (auto& thread : m_threads)
+        {
+            thread.join();
+        }
+    }
+
+    CEnumFolderPrefetcher(const CEnumFolderPrefetcher&) = delete;
+    CEnumFolderPrefetcher& operator=(const CEnumFolderPrefetcher&) = delete;
+
+    // Queues the subfolders of a listing that has just been read.
+    void QueueSubfolders(_In_ const EnumFolderListing& listing)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            _QueueSubfolders(listing);
+        }
+        m_workAvailable.notify_all();
+    }
+
+    // Blocks until the listing has been read. Returns the enumeration result or E_ABORT if canceled.
+    HRESULT Wait(_In_ const EnumFolderListing& listing)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!listing.ready)
+        {
+            // Let the listing through even if the threads are waiting for items to be added
+            auto queued = std::find_if(m_queue.begin(), m_queue.end(), [&](const auto& l) { return l.get() == &listing; });
+            if (queued != m_queue.end() && m_threads.empty())
+            {
+                // Nothing else would ever read it
+                std::shared_ptr<EnumFolderListing> needed = std::move(*queued);
+                m_queue.erase(queued);
+                lock.unlock();
+                _ReadListing(*needed);
+                lock.lock();
+            }
+            else if (queued != m_queue.end())
+            {
+                std::rotate(m_queue.begin(), queued, queued + 1);
+            }
+            m_needed = &listing;
+            m_workAvailable.notify_all();
+        }
+
+        HRESULT hr = listing.hr;
+        while (!listing.ready)
+        {
+            if (m_canceled)
+            {
+                hr = E_ABORT;
+                break;
+            }
+            m_listingReady.wait_for(lock, c_cancelPollInterval);
+            hr = listing.hr;
+        }
+        m_needed = nullptr;
+        return hr;
+    }
+
+    // Called once the items of a listing have been added, to let the threads read further ahead.
+    void Release(_In_ const EnumFolderListing& listing)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!listing.ready)
+            {
+                return;
+            }
+            m_prefetchedItems -= listing.entries.size();
+        }
+        m_workAvailable.notify_all();
+    }
+
+private:
+    _Requires_lock_held_(m_mutex)
+    void _QueueSubfolders(_In_ const EnumFolderListing& listing)
+    {
+        auto insertAt = m_queue.begin();
+        for (const auto& entry : listing.entries)
+        {
+            if (entry.contents)
+            {
+                insertAt = m_queue.insert(insertAt, entry.contents) + 1;
+            }
+        }
+
+        if (!m_queue.empty())
+        {
+            _StartThreads();
+        }
+    }
+
+    _Requires_lock_held_(m_mutex)
+    void _StartThreads()
+    {
+        const unsigned int threadCount = std::clamp(std::thread::hardware_concurrency(), 1u, c_maxPrefetchThreads);
+        try
+        {
+            while (m_threads.size() < threadCount)
+            {
+                m_threads.push_back(m_startThread([this] { _WorkerThread(); }));
+            }
+        }
+        catch (const std::system_error&)
+        {
+            // Keep going with the threads we have, Wait reads the listings itself if there are none
+        }
+    }
+
+    void _WorkerThread()
+    {
+        HRESULT hrCoInit = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+        for (;;)
+        {
+            std::shared_ptr<EnumFolderListing> listing;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_workAvailable.wait(lock, [this] {
+                    return m_stop || (!m_queue.empty() && (m_prefetchedItems < c_maxPrefetchedItems || m_queue.front().get() == m_needed));
+                });
+                if (m_stop)
+                {
+                    break;
+                }
+                listing = std::move(m_queue.front());
+                m_queue.pop_front();
+            }
+
+            _ReadListing(*listing);
+        }
+
+        if (SUCCEEDED(hrCoInit))
+        {
+            CoUninitialize();
+        }
+    }
+
+    // Reads a listing taken off the queue and publishes it
+    void _ReadListing(_In_ EnumFolderListing& listing)
+    {
+        HRESULT hr = E_ABORT;
+        if (!m_canceled)
+        {
+            hr = E_INVALIDARG;
+            if (listing.depth < c_maxDepth)
+            {
+                CComPtr<IShellItem> spsi;
+                hr = SHCreateItemFromIDList(listing.pidl, IID_PPV_ARGS(&spsi));
+                if (SUCCEEDED(hr))
+                {
+                    // Bind to the IShellItem for the IEnumShellItems interface
+                    CComPtr<IEnumShellItems> spesi;
+                    hr = spsi->BindToHandler(nullptr, BHID_EnumItems, IID_PPV_ARGS(&spesi));
+                    if (SUCCEEDED(hr))
+                    {
+                        ReadFolderListing(spesi, listing, m_canceled);
+                    }
+                }
+            }
+        }
+
+        {
+            // Queue the subfolders before publishing the listing, the enumerating thread
+            // releases their contents once it is done with them.
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (SUCCEEDED(hr))
+            {
+                _QueueSubfolders(listing);
+            }
+            listing.hr = hr;
+            listing.ready = true;
+            m_prefetchedItems += listing.entries.size();
+        }
+        m_workAvailable.notify_all();
+        m_listingReady.notify_all();
+    }
+
+    const std::atomic<bool>& m_canceled;
+    const ThreadStarter m_startThread;
+    std::mutex m_mutex;
+    std::condition_variable m_workAvailable;
+    std::condition_variable m_listingReady;
+    _Guarded_by_(m_mutex) std::deque<std::shared_ptr<EnumFolderListing>> m_queue;
+    _Guarded_by_(m_mutex) std::vector<std::thread> m_threads;
+    _Guarded_by_(m_mutex) bool m_stop = false;
+    // Items in listings that have been read but not yet added
+    _Guarded_by_(m_mutex) size_t m_prefetchedItems = 0;
+    // Listing the enumerating thread is waiting for
+    _Guarded_by_(m_mutex) const EnumFolderListing* m_needed = nullptr;
+};
 
 IFACEMETHODIMP_(ULONG) CPowerRenameEnum::AddRef()
 {
@@ -77,74 +440,73 @@ HRESULT CPowerRenameEnum::_Init(_In_ IUnknown* pdo, _In_ IPowerRenameManager* pM
     return S_OK;
 }
 
-HRESULT CPowerRenameEnum::_ParseEnumItems(_In_ IEnumShellItems* pesi, _In_ int depth)
+HRESULT CPowerRenameEnum::_ParseEnumItems(_In_ IEnumShellItems* pesi)
 {
     HRESULT hr = E_INVALIDARG;
-
-    // We shouldn't get this deep since we only enum the contents of
-    // regular folders but adding just in case
-    if ((pesi) && (depth < (MAX_PATH / 2)))
+    if (pesi)
     {
-        hr = S_OK;
+        // Declared before the prefetcher so its threads are done with the listings before they go away
+        EnumFolderListing listing(nullptr, 0);
+        ReadFolderListing(pesi, listing, m_canceled);
 
-        ULONG celtFetched;
-        CComPtr<IShellItem> spsi;
-        std::vector<CComPtr<IShellItem>> items;
+        CEnumFolderPrefetcher prefetcher(m_canceled, [this](std::function<void()> threadProc) { return _StartPrefetchThread(std::move(threadProc)); });
+        prefetcher.QueueSubfolders(listing);
+        hr = _AddItems(listing, prefetcher);
+    }
+
+    return hr;
+}
 
-        while ((S_OK == pesi->Next(1, &spsi, &celtFetched)))
+std::thread CPowerRenameEnum::_StartPrefetchThread(_In_ std::function<void()> threadProc)
+{
+    return std::thread(std::move(threadProc));
+}
+
+HRESULT CPowerRenameEnum::_AddItems(_In_ EnumFolderListing& listing, _In_ CEnumFolderPrefetcher& prefetcher)
+{
+    CComPtr<IPowerRenameItemFactory> spFactory;
+    HRESULT hr = m_spsrm->GetRenameItemFactory(&spFactory);
+
+    for (auto& entry : listing.entries)
+    {
+        if (FAILED(hr))
         {
-            items.push_back(spsi);
-            spsi = nullptr;
+            break;
         }
 
-        auto cmpShellItems = [](CComPtr<IShellItem> l, CComPtr<IShellItem> r) {
-            int res = 0;
-            l->Compare(r, SICHINT_DISPLAY, &res);
-            return res < 0;
-        };
-        std::sort(items.begin(), items.end(), cmpShellItems);
-
-        for (const auto& item : items)
+        if (m_canceled)
         {
-            if (m_canceled)
-            {
-                return E_ABORT;
-            }
+            return E_ABORT;
+        }
 
-            CComPtr<IPowerRenameItemFactory> spFactory;
-            hr = m_spsrm->GetRenameItemFactory(&spFactory);
+        CComPtr<IShellItem> spsi;
+        CComPtr<IPowerRenameItem> spNewItem;
+        // Failure may be valid if we come across a shell item that does
+        // not support a file system path.  In that case we simply ignore
+        // the item.
+        if (SUCCEEDED(SHCreateItemFromIDList(entry.pidl, IID_PPV_ARGS(&spsi))) &&
+            SUCCEEDED(spFactory->Create(spsi, &spNewItem)))
+        {
+            spNewItem->PutDepth(listing.depth);
+            hr = m_spsrm->AddItem(spNewItem);
             if (SUCCEEDED(hr))
             {
-                CComPtr<IPowerRenameItem> spNewItem;
-                // Failure may be valid if we come across a shell item that does
-                // not support a file system path.  In that case we simply ignore
-                // the item.
-                if (SUCCEEDED(spFactory->Create(item, &spNewItem)))
+                bool isFolder = false;
+                if (SUCCEEDED(spNewItem->GetIsFolder(&isFolder)) && isFolder && entry.contents)
                 {
-                    spNewItem->PutDepth(depth);
-                    hr = m_spsrm->AddItem(spNewItem);
+                    hr = prefetcher.Wait(*entry.contents);
                     if (SUCCEEDED(hr))
                     {
-                        bool isFolder = false;
-                        if (SUCCEEDED(spNewItem->GetIsFolder(&isFolder)) && isFolder)
-                        {
-                            // Bind to the IShellItem for the IEnumShellItems interface
-                            CComPtr<IEnumShellItems> spesiNext;
-                            hr = item->BindToHandler(nullptr, BHID_EnumItems, IID_PPV_ARGS(&spesiNext));
-                            if (SUCCEEDED(hr))
-                            {
-                                // Parse the folder contents recursively
-                                hr = _ParseEnumItems(spesiNext, depth + 1);
-                            }
-                        }
+                        // Add the folder contents recursively
+                        hr = _AddItems(*entry.contents, prefetcher);
                     }
+                    prefetcher.Release(*entry.contents);
                 }
             }
-            if (FAILED(hr))
-            {
-                break;
-            }
         }
+
+        // The folder contents are no longer needed once they have been added
+        entry.contents = nullptr;
     }
 
     return hr;
@@ -1,9 +1,15 @@
 #pragma once
 #include "pch.h"
 #include "PowerRenameInterfaces.h"
+#include <atomic>
+#include <functional>
+#include <thread>
 #include <vector>
 #include "srwlock.h"
 
+struct EnumFolderListing;
+class CEnumFolderPrefetcher;
+
 class CPowerRenameEnum :
     public IPowerRenameEnum
 {
@@ -25,10 +31,13 @@ protected:
     virtual ~CPowerRenameEnum();
 
     HRESULT _Init(_In_ IUnknown* pdo, _In_ IPowerRenameManager* pManager);
-    HRESULT _ParseEnumItems(_In_ IEnumShellItems* pesi, _In_ int depth = 0);
+    HRESULT _ParseEnumItems(_In_ IEnumShellItems* pesi);
+    HRESULT _AddItems(_In_ EnumFolderListing& listing, _In_ CEnumFolderPrefetcher& prefetcher);
+    // Starts a thread reading subfolders ahead, throws std::system_error if it can't
+    virtual std::thread _StartPrefetchThread(_In_ std::function<void()> threadProc);
 
     CComPtr<IPowerRenameManager> m_spsrm;
     CComPtr<IUnknown> m_spdo;
-    bool m_canceled = false;
+    std::atomic<bool> m_canceled = false;
     long m_refCount = 0;
 };
\ No newline at end of file
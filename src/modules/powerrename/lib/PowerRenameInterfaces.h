@@ -51,6 +51,9 @@ public:
     IFACEMETHOD(PutFileTime)(_In_ SYSTEMTIME fileTime) = 0;
     IFACEMETHOD(ResetFileTime)() = 0;
     IFACEMETHOD(Replace)(_In_ PCWSTR source, _Outptr_ PWSTR* result) = 0;
+    // Replaces count sources at once like Replace does. If fileTimes is given, the file time tokens of the replace
+    // term are expanded with the time of each source instead of the one set with PutFileTime.
+    IFACEMETHOD(ReplaceBatch)(_In_ UINT count, _In_reads_(count) const PCWSTR* sources, _In_reads_opt_(count) const SYSTEMTIME* fileTimes, _Out_writes_(count) PWSTR* results) = 0;
 };
 
 interface __declspec(uuid("C7F59201-4DE1-4855-A3A2-26FC3279C8A5")) IPowerRenameItem : public IUnknown
@@ -107,7 +110,6 @@ public:
     IFACEMETHOD(Reset)() = 0;
     IFACEMETHOD(Shutdown)() = 0;
     IFACEMETHOD(Rename)(_In_ HWND hwndParent, _In_ bool closeWindow) = 0;
-    IFACEMETHOD(UpdateChildrenPath)(_In_ int parentId, _In_ size_t oldParentPathSize) = 0;
     IFACEMETHOD(GetCloseUIWindowAfterRenaming)(_Out_ bool* closeUIWindowAfterRenaming) = 0;
     IFACEMETHOD(AddItem)(_In_ IPowerRenameItem * pItem) = 0;
     IFACEMETHOD(GetItemByIndex)(_In_ UINT index, _COM_Outptr_ IPowerRenameItem** ppItem) = 0;
@@ -1,7 +1,11 @@
 #include "pch.h"
 #include "PowerRenameManager.h"
 #include "PowerRenameRegEx.h" // Default RegEx handler
+#include "RenameExecutor.h"
+#include "CaseTransform.h"
+#include "UniqueNameAllocator.h"
 #include <algorithm>
+#include <memory>
 #include <shlobj.h>
 #include <cstring>
 #include "helpers.h"
@@ -99,43 +103,6 @@ IFACEMETHODIMP CPowerRenameManager::Rename(_In_ HWND hwndParent, bool closeWindo
     return _PerformFileOperation();
 }
 
-IFACEMETHODIMP CPowerRenameManager::UpdateChildrenPath(_In_ int parentId, _In_ size_t oldParentPathSize)
-{
-    auto parentIt = m_renameItems.find(parentId);
-    if (parentIt != m_renameItems.end())
-    {
-        UINT depth = 0;
-        winrt::check_hresult(parentIt->second->GetDepth(&depth));
-
-        PWSTR renamedPath = nullptr;
-        winrt::check_hresult(parentIt->second->GetPath(&renamedPath));
-        std::wstring renamedPathStr{ renamedPath };
-
-        for (auto it = ++parentIt; it != m_renameItems.end(); ++it)
-        {
-            UINT nextDepth = 0;
-            winrt::check_hresult(it->second->GetDepth(&nextDepth));
-
-            if (nextDepth > depth)
-            {
-                // This is child, update path
-                PWSTR path = nullptr;
-                winrt::check_hresult(it->second->GetPath(&path));
-                std::wstring pathStr{ path };
-
-                std::wstring newPath = pathStr.replace(0, oldParentPathSize, renamedPath);
-                it->second->PutPath(newPath.c_str());
-            }
-            else
-            {
-                break;
-            }
-        }
-    }
-
-    return S_OK;
-}
-
 IFACEMETHODIMP CPowerRenameManager::GetCloseUIWindowAfterRenaming(_Out_ bool* closeUIWindowAfterRenaming)
 {
     *closeUIWindowAfterRenaming = m_closeUIWindowAfterRenaming;
@@ -169,6 +136,7 @@ IFACEMETHODIMP CPowerRenameManager::AddItem(_In_ IPowerRenameItem* pItem)
         {
             m_renameItems[id] = pItem;
             m_isVisible.push_back(true);
+            m_previewItemsStale = true;
             pItem->AddRef();
             hr = S_OK;
         }
@@ -504,7 +472,7 @@ HRESULT CPowerRenameManager::_Init()
 // Custom messages for worker threads
 enum
 {
-    SRM_REGEX_ITEM_UPDATED = (WM_APP + 1), // Single rename item processed by regex worker thread
+    SRM_REGEX_ITEMS_UPDATED = (WM_APP + 1), // Batch of rename items processed by regex worker thread
     SRM_REGEX_ITEM_RENAMED_KEEP_UI, // Single rename item processed by rename worker thread in case UI remains opened
     SRM_REGEX_STARTED, // RegEx operation was started
     SRM_REGEX_CANCELED, // Regex operation was canceled
@@ -512,8 +480,21 @@ enum
     SRM_FILEOP_COMPLETE // File Operation worker thread completed
 };
 
+namespace
+{
+    // Item updates from the regex worker are posted in batches of at most this many items...
+    const size_t c_maxItemsPerUpdate = 256;
+    // ...or whatever was processed within roughly one frame.
+    const ULONGLONG c_updateIntervalMs = 16;
+    // How many items the regex worker processes between checks of the cancel event.
+    const UINT c_cancelCheckInterval = 64;
+    // How many names the regex worker replaces at once, spread over several threads.
+    const UINT c_replaceBatchSize = 1024;
+}
+
 struct WorkerThreadData
 {
+    CPowerRenameManager* manager = nullptr;
     HWND hwndManager = nullptr;
     HANDLE startEvent = nullptr;
     HANDLE cancelEvent = nullptr;
@@ -552,13 +533,16 @@ LRESULT CPowerRenameManager::_WndProc(_In_ HWND hwnd, _In_ UINT msg, _In_ WPARAM
 
     switch (msg)
     {
-    case SRM_REGEX_ITEM_UPDATED:
+    case SRM_REGEX_ITEMS_UPDATED:
     {
-        int id = static_cast<int>(lParam);
-        CComPtr<IPowerRenameItem> spItem;
-        if (SUCCEEDED(GetItemById(id, &spItem)))
+        std::unique_ptr<std::vector<int>> ids(reinterpret_cast<std::vector<int>*>(lParam));
+        for (int id : *ids)
         {
-            _OnUpdate(spItem);
+            CComPtr<IPowerRenameItem> spItem;
+            if (SUCCEEDED(GetItemById(id, &spItem)))
+            {
+                _OnUpdate(spItem);
+            }
         }
         break;
     }
@@ -692,12 +676,88 @@ HRESULT CPowerRenameManager::_PerformFileOperation()
             }
         }
 
+        // Renamed items have new original names
+        _InvalidatePreviewItems();
+
         _OnRenameCompleted();
     }
 
     return S_OK;
 }
 
+namespace
+{
+    // Queues renames on an IFileOperation, which keeps undo, elevation and collision handling.
+    // The operation isn't thread safe, so renames are queued one at a time.
+    class CFileOperationRenameBackend : public IRenameBackend
+    {
+    public:
+        explicit CFileOperationRenameBackend(IFileOperation* fileOp) :
+            m_fileOp(fileOp)
+        {
+        }
+
+        HRESULT Rename(const RenameEntry& entry) override
+        {
+            CComPtr<IShellItem> spShellItem;
+            HRESULT hr = entry.item->GetShellItem(&spShellItem);
+            if (SUCCEEDED(hr))
+            {
+                hr = m_fileOp->RenameItem(spShellItem, entry.newName.c_str(), nullptr);
+            }
+            return hr;
+        }
+
+        bool CanRenameConcurrently() const override { return false; }
+
+    private:
+        IFileOperation* m_fileOp;
+    };
+}
+
+std::vector<RenameEntry> CPowerRenameManager::_GetRenameEntries(DWORD flags)
+{
+    std::vector<RenameEntry> entries;
+
+    CSRWSharedAutoLock lock(&m_lockItems);
+    entries.reserve(m_renameItems.size());
+    for (auto& [id, item] : m_renameItems)
+    {
+        RenameEntry entry;
+        entry.item = item;
+        item->GetDepth(&entry.depth);
+
+        PWSTR path = nullptr;
+        if (SUCCEEDED(item->GetPath(&path)))
+        {
+            entry.path = path;
+            CoTaskMemFree(path);
+        }
+
+        PWSTR originalName = nullptr;
+        if (SUCCEEDED(item->GetOriginalName(&originalName)))
+        {
+            entry.originalName = originalName;
+            CoTaskMemFree(originalName);
+        }
+
+        bool shouldRename = false;
+        if (SUCCEEDED(item->ShouldRenameItem(flags, &shouldRename)) && shouldRename)
+        {
+            PWSTR newName = nullptr;
+            if (SUCCEEDED(item->GetNewName(&newName)) && newName)
+            {
+                entry.newName = newName;
+                CoTaskMemFree(newName);
+            }
+        }
+
+        entries.push_back(std::move(entry));
+    }
+
+    return entries;
+}
+
 HRESULT CPowerRenameManager::_CreateFileOpWorkerThread()
 {
     WorkerThreadData* pwtd = new WorkerThreadData;
@@ -708,6 +768,7 @@ HRESULT CPowerRenameManager::_CreateFileOpWorkerThread()
         pwtd->startEvent = m_startRegExWorkerEvent;
         pwtd->cancelEvent = nullptr;
         pwtd->spsrm = this;
+        pwtd->manager = this;
         m_fileOpWorkerThreadHandle = CreateThread(nullptr, 0, s_fileOpWorkerThread, pwtd, 0, nullptr);
         hr = E_FAIL;
         if (m_fileOpWorkerThreadHandle)
@@ -746,80 +807,34 @@ DWORD WINAPI CPowerRenameManager::s_fileOpWorkerThread(_In_ void* pv)
                         DWORD flags = 0;
                         spRenameRegEx->GetFlags(&flags);
 
-                        UINT itemCount = 0;
-                        pwtd->spsrm->GetItemCount(&itemCount);
+                        CRenameExecutor executor(pwtd->manager->_GetRenameEntries(flags));
 
-                        // We add the items to the operation in depth-first order.  This allows child items to be
-                        // renamed before parent items.
+                        // Items are added to the operation deepest first, so child items are renamed
+                        // before their parent folders.
+                        CFileOperationRenameBackend backend(spFileOp);
+                        executor.Execute(backend);
 
-                        // Creating a vector of vectors of items of the same depth
-                        std::vector<std::vector<UINT>> matrix(itemCount);
-
-                        for (UINT u = 0; u < itemCount; u++)
+                        if (!closeUIWindowAfterRenaming)
                         {
-                            CComPtr<IPowerRenameItem> spItem;
-                            if (SUCCEEDED(pwtd->spsrm->GetItemByIndex(u, &spItem)))
+                            // Update item data
+                            const std::vector<RenameEntry>& entries = executor.GetEntries();
+                            const std::vector<std::wstring> renamedPaths = executor.GetRenamedPaths();
+                            for (size_t i = 0; i < entries.size(); i++)
                             {
-                                UINT depth = 0;
-                                spItem->GetDepth(&depth);
-                                matrix[depth].push_back(u);
-                            }
-                        }
+                                const RenameEntry& entry = entries[i];
+                                if (entry.path != renamedPaths[i])
+                                {
+                                    entry.item->PutPath(renamedPaths[i].c_str());
+                                }
 
-                        // From the greatest depth first, add all items of that depth to the operation
-                        for (LONG v = itemCount - 1; v >= 0; v--)
-                        {
-                            for (auto it : matrix[v])
-                            {
-                                CComPtr<IPowerRenameItem> spItem;
-                                if (SUCCEEDED(pwtd->spsrm->GetItemByIndex(it, &spItem)))
+                                if (!entry.newName.empty())
                                 {
-                                    bool shouldRename = false;
-                                    if (SUCCEEDED(spItem->ShouldRenameItem(flags, &shouldRename)) && shouldRename)
-                                    {
-                                        PWSTR newName = nullptr;
-                                        if (SUCCEEDED(spItem->GetNewName(&newName)))
-                                        {
-                                            CComPtr<IShellItem> spShellItem;
-                                            if (SUCCEEDED(spItem->GetShellItem(&spShellItem)))
-                                            {
-                                                spFileOp->RenameItem(spShellItem, newName, nullptr);
-                                                if (!closeUIWindowAfterRenaming)
-                                                {
-                                                    // Update item data
-                                                    PWSTR originalName = nullptr;
-                                                    winrt::check_hresult(spItem->GetOriginalName(&originalName));
-                                                    std::wstring originalNameStr{ originalName };
-
-                                                    PWSTR path = nullptr;
-                                                    winrt::check_hresult(spItem->GetPath(&path));
-                                                    std::wstring pathStr{ path };
-                                                    size_t oldPathSize = pathStr.size();
-
-                                                    auto fileNamePos = pathStr.find_last_of(L"\\");
-                                                    pathStr.replace(fileNamePos + 1, originalNameStr.length(), std::wstring{ newName });
-                                                    spItem->PutPath(pathStr.c_str());
-                                                    spItem->PutOriginalName(newName);
-                                                    spItem->PutNewName(nullptr);
-
-                                                    // if folder, update children path
-                                                    bool isFolder = false;
-                                                    winrt::check_hresult(spItem->GetIsFolder(&isFolder));
-                                                    if (isFolder)
-                                                    {
-                                                        int id = -1;
-                                                        winrt::check_hresult(spItem->GetId(&id));
-                                                        pwtd->spsrm->UpdateChildrenPath(id, oldPathSize);
-                                                    }
-
-                                                    int id = -1;
-                                                    winrt::check_hresult(spItem->GetId(&id));
-                                                    PostMessage(pwtd->hwndManager, SRM_REGEX_ITEM_RENAMED_KEEP_UI, GetCurrentThreadId(), id);
-                                                }
-                                            }
-                                            CoTaskMemFree(newName);
-                                        }
-                                    }
+                                    entry.item->PutOriginalName(entry.newName.c_str());
+                                    entry.item->PutNewName(nullptr);
+
+                                    int id = -1;
+                                    winrt::check_hresult(entry.item->GetId(&id));
+                                    PostMessage(pwtd->hwndManager, SRM_REGEX_ITEM_RENAMED_KEEP_UI, GetCurrentThreadId(), id);
                                 }
                             }
                         }
@@ -893,6 +908,7 @@ HRESULT CPowerRenameManager::_CreateRegExWorkerThread()
         pwtd->startEvent = m_startRegExWorkerEvent;
         pwtd->cancelEvent = m_cancelRegExWorkerEvent;
         pwtd->hwndParent = m_hwndParent;
+        pwtd->manager = this;
         pwtd->spsrm = this;
         m_regExWorkerThreadHandle = CreateThread(nullptr, 0, s_regexWorkerThread, pwtd, 0, nullptr);
         hr = E_FAIL;
@@ -929,9 +945,11 @@ DWORD WINAPI CPowerRenameManager::s_regexWorkerThread(_In_ void* pv)
                 DWORD flags = 0;
                 winrt::check_hresult(spRenameRegEx->GetFlags(&flags));
 
+                PWSTR searchTerm = nullptr;
                 PWSTR replaceTerm = nullptr;
                 bool useFileTime = false;
 
+                winrt::check_hresult(spRenameRegEx->GetSearchTerm(&searchTerm));
                 winrt::check_hresult(spRenameRegEx->GetReplaceTerm(&replaceTerm));
 
                 if (isFileTimeUsed(replaceTerm))
@@ -939,96 +957,192 @@ DWORD WINAPI CPowerRenameManager::s_regexWorkerThread(_In_ void* pv)
                     useFileTime = true;
                 }
 
-                UINT itemCount = 0;
-                unsigned long itemEnumIndex = 1;
-                winrt::check_hresult(pwtd->spsrm->GetItemCount(&itemCount));
-                for (UINT u = 0; u < itemCount; u++)
+                CPowerRenameManager* manager = pwtd->manager;
+                manager->_EnsurePreviewItems();
+
+                // When a literal search term is only extended (the user typed more characters), items the
+                // previous term left unchanged can't match now either, so their preview stays as it is.
+                // Enumeration numbers depend on every preceding item, so they always need a full pass.
+                std::wstring searchTermStr{ searchTerm ? searchTerm : L"" };
+                std::wstring replaceTermStr{ replaceTerm ? replaceTerm : L"" };
+                const bool incremental = !manager->m_previewSearchTerm.empty() &&
+                                         flags == manager->m_previewFlags &&
+                                         !(flags & (UseRegularExpressions | EnumerateItems)) &&
+                                         searchTermStr.starts_with(manager->m_previewSearchTerm);
+                if (!incremental)
                 {
-                    // Check if cancel event is signaled
-                    if (WaitForSingleObject(pwtd->cancelEvent, 0) == WAIT_OBJECT_0)
+                    for (auto& previewItem : manager->m_previewItems)
                     {
-                        // Canceled from manager
-                        // Send the manager thread the canceled message
-                        PostMessage(pwtd->hwndManager, SRM_REGEX_CANCELED, GetCurrentThreadId(), 0);
-                        break;
+                        previewItem.unmatched = false;
                     }
-
-                    CComPtr<IPowerRenameItem> spItem;
-                    winrt::check_hresult(pwtd->spsrm->GetItemByIndex(u, &spItem));
-
-                    int id = -1;
-                    winrt::check_hresult(spItem->GetId(&id));
-
-                    bool isFolder = false;
-                    bool isSubFolderContent = false;
-                    winrt::check_hresult(spItem->GetIsFolder(&isFolder));
-                    winrt::check_hresult(spItem->GetIsSubFolderContent(&isSubFolderContent));
-                    if ((isFolder && (flags & PowerRenameFlags::ExcludeFolders)) ||
-                        (!isFolder && (flags & PowerRenameFlags::ExcludeFiles)) ||
-                        (isSubFolderContent && (flags & PowerRenameFlags::ExcludeSubfolders)) ||
-                        (isFolder && (flags & PowerRenameFlags::ExtensionOnly)))
+                }
+                manager->m_previewSearchTerm = searchTermStr;
+                manager->m_previewFlags = flags;
+
+                // An unchanged name only proves there was no match if the replacement can't reproduce the
+                // matched text, which it can when it equals the search term or contains format escapes.
+                const bool trackUnmatched = !(flags & UseRegularExpressions) && !useFileTime && !searchTermStr.empty() &&
+                                            replaceTermStr.find(L'$') == std::wstring::npos &&
+                                            !std::equal(searchTermStr.begin(), searchTermStr.end(), replaceTermStr.begin(), replaceTermStr.end(), [](wchar_t a, wchar_t b) {
+                                                return towlower(a) == towlower(b);
+                                            });
+
+                std::unique_ptr<std::vector<int>> updatedIds = std::make_unique<std::vector<int>>();
+                ULONGLONG lastUpdateTick = GetTickCount64();
+                auto postUpdatedItems = [&]() {
+                    if (!updatedIds->empty())
                     {
-                        // Exclude this item from renaming.  Ensure new name is cleared.
-                        winrt::check_hresult(spItem->PutNewName(nullptr));
-
-                        // Send the manager thread the item processed message
-                        PostMessage(pwtd->hwndManager, SRM_REGEX_ITEM_UPDATED, GetCurrentThreadId(), id);
-
-                        continue;
+                        // Owned by the message handler once posted
+                        std::vector<int>* ids = updatedIds.release();
+                        if (!PostMessage(pwtd->hwndManager, SRM_REGEX_ITEMS_UPDATED, GetCurrentThreadId(), reinterpret_cast<LPARAM>(ids)))
+                        {
+                            delete ids;
+                        }
+                        updatedIds = std::make_unique<std::vector<int>>();
                     }
-
-                    PWSTR originalName = nullptr;
-                    winrt::check_hresult(spItem->GetOriginalName(&originalName));
-
-
-                    PWSTR currentNewName = nullptr;
-                    winrt::check_hresult(spItem->GetNewName(&currentNewName));
-
-                    wchar_t sourceName[MAX_PATH] = { 0 };
-
-                    if (isFolder)
+                    lastUpdateTick = GetTickCount64();
+                };
+
+                // Built once for the whole pass: the transform doesn't depend on the item, and the allocator
+                // remembers the enumerated names it handed out
+                const CCaseTransform caseTransform(flags);
+                std::wstring transformedNameBuffer;
+                CUniqueNameAllocator uniqueNames;
+                std::wstring uniqueNameBuffer;
+
+                auto isExcluded = [flags](const PreviewItem& previewItem) {
+                    return (previewItem.isFolder && (flags & PowerRenameFlags::ExcludeFolders)) ||
+                           (!previewItem.isFolder && (flags & PowerRenameFlags::ExcludeFiles)) ||
+                           (previewItem.isSubFolderContent && (flags & PowerRenameFlags::ExcludeSubfolders)) ||
+                           (previewItem.isFolder && (flags & PowerRenameFlags::ExtensionOnly));
+                };
+
+                auto copySourceName = [flags](const PreviewItem& previewItem, wchar_t (&sourceName)[MAX_PATH]) {
+                    if (previewItem.isFolder)
                     {
-                        StringCchCopy(sourceName, ARRAYSIZE(sourceName), originalName);
-                    
+                        StringCchCopy(sourceName, ARRAYSIZE(sourceName), previewItem.originalName.c_str());
                     }
                     else
                     {
                         if (flags & NameOnly)
                         {
-                            StringCchCopy(sourceName, ARRAYSIZE(sourceName), fs::path(originalName).stem().c_str());
+                            StringCchCopy(sourceName, ARRAYSIZE(sourceName), previewItem.stem.c_str());
                         }
                         else if (flags & ExtensionOnly)
                         {
-                            std::wstring extension = fs::path(originalName).extension().wstring();
-                            if (!extension.empty() && extension.front() == '.')
+                            PCWSTR extension = previewItem.extension.c_str();
+                            if (*extension == L'.')
                             {
-                                extension = extension.erase(0, 1);
+                                extension++;
                             }
-                            StringCchCopy(sourceName, ARRAYSIZE(sourceName), extension.c_str());
+                            StringCchCopy(sourceName, ARRAYSIZE(sourceName), extension);
                         }
                         else
                         {
-                            StringCchCopy(sourceName, ARRAYSIZE(sourceName), originalName);
+                            StringCchCopy(sourceName, ARRAYSIZE(sourceName), previewItem.originalName.c_str());
                         }
                     }
+                };
+
+                // The names of a block of items are replaced ahead of the loop in one batch, which spreads the
+                // regex work over several threads. Items which are skipped get an empty source and no new name.
+                std::vector<std::wstring> batchSources;
+                std::vector<PCWSTR> batchSourcePointers;
+                std::vector<SYSTEMTIME> batchFileTimes;
+                std::vector<PWSTR> batchNewNames;
+                UINT batchStart = 0;
+                UINT batchEnd = 0;
+                auto freeBatchNewNames = [&]() {
+                    for (PWSTR& newName : batchNewNames)
+                    {
+                        CoTaskMemFree(newName);
+                        newName = nullptr;
+                    }
+                };
+
+                unsigned long itemEnumIndex = 1;
+                const UINT itemCount = static_cast<UINT>(manager->m_previewItems.size());
+                for (UINT u = 0; u < itemCount; u++)
+                {
+                    // Check if cancel event is signaled
+                    if (u % c_cancelCheckInterval == 0 && WaitForSingleObject(pwtd->cancelEvent, 0) == WAIT_OBJECT_0)
+                    {
+                        // Canceled from manager
+                        // Let the manager know about the items we did update, then send the canceled message
+                        postUpdatedItems();
+                        PostMessage(pwtd->hwndManager, SRM_REGEX_CANCELED, GetCurrentThreadId(), 0);
+                        break;
+                    }
 
-                    SYSTEMTIME fileTime = { 0 };
+                    if (updatedIds->size() >= c_maxItemsPerUpdate || GetTickCount64() - lastUpdateTick >= c_updateIntervalMs)
+                    {
+                        postUpdatedItems();
+                    }
 
-                    if (useFileTime)
+                    if (u == batchEnd)
                     {
-                        winrt::check_hresult(spItem->GetTime(&fileTime));
-                        winrt::check_hresult(spRenameRegEx->PutFileTime(fileTime));
+                        freeBatchNewNames();
+                        batchStart = u;
+                        batchEnd = std::min<UINT>(itemCount, u + c_replaceBatchSize);
+                        const UINT batchCount = batchEnd - batchStart;
+                        batchSources.resize(batchCount);
+                        batchSourcePointers.resize(batchCount);
+                        batchFileTimes.assign(useFileTime ? batchCount : 0, SYSTEMTIME{});
+                        batchNewNames.assign(batchCount, nullptr);
+                        for (UINT b = 0; b < batchCount; b++)
+                        {
+                            const PreviewItem& batchItem = manager->m_previewItems[batchStart + b];
+                            wchar_t sourceName[MAX_PATH] = { 0 };
+                            if (!(incremental && batchItem.unmatched) && !isExcluded(batchItem))
+                            {
+                                copySourceName(batchItem, sourceName);
+                                if (useFileTime)
+                                {
+                                    winrt::check_hresult(batchItem.item->GetTime(&batchFileTimes[b]));
+                                }
+                            }
+                            batchSources[b] = sourceName;
+                            batchSourcePointers[b] = batchSources[b].c_str();
+                        }
+
+                        // Failure here means the search term isn't a valid regex
+                        winrt::check_hresult(spRenameRegEx->ReplaceBatch(batchCount, batchSourcePointers.data(), useFileTime ? batchFileTimes.data() : nullptr, batchNewNames.data()));
                     }
 
-                    PWSTR newName = nullptr;
+                    PreviewItem& previewItem = manager->m_previewItems[u];
+                    if (incremental && previewItem.unmatched)
+                    {
+                        continue;
+                    }
 
-                    // Failure here means we didn't match anything or had nothing to match
+                    IPowerRenameItem* spItem = previewItem.item;
+                    const int id = previewItem.id;
+                    const bool isFolder = previewItem.isFolder;
+                    PCWSTR originalName = previewItem.originalName.c_str();
+
+                    if (isExcluded(previewItem))
+                    {
+                        // Exclude this item from renaming.  Ensure new name is cleared.
+                        winrt::check_hresult(spItem->PutNewName(nullptr));
+
+                        // Let the manager thread know the item was processed
+                        updatedIds->push_back(id);
+
+                        continue;
+                    }
+
+                    PWSTR currentNewName = nullptr;
+                    winrt::check_hresult(spItem->GetNewName(&currentNewName));
+
+                    PCWSTR sourceName = batchSources[u - batchStart].c_str();
+
+                    // nullptr means we didn't match anything or had nothing to match
                     // Call put_newName with null in that case to reset it
-                    winrt::check_hresult(spRenameRegEx->Replace(sourceName, &newName));
+                    PWSTR newName = std::exchange(batchNewNames[u - batchStart], nullptr);
 
-                    if (useFileTime)
+                    if (trackUnmatched)
                     {
-                        winrt::check_hresult(spRenameRegEx->ResetFileTime());
+                        previewItem.unmatched = newName != nullptr && lstrcmp(newName, sourceName) == 0;
                     }
 
                     wchar_t resultName[MAX_PATH] = { 0 };
@@ -1056,14 +1170,13 @@ DWORD WINAPI CPowerRenameManager::s_regexWorkerThread(_In_ void* pv)
                         {
                             if (flags & NameOnly)
                             {
-                                StringCchPrintf(resultName, ARRAYSIZE(resultName), L"%s%s", newName, fs::path(originalName).extension().c_str());
+                                StringCchPrintf(resultName, ARRAYSIZE(resultName), L"%s%s", newName, previewItem.extension.c_str());
                             }
                             else if (flags & ExtensionOnly)
                             {
-                                std::wstring extension = fs::path(originalName).extension().wstring();
-                                if (!extension.empty())
+                                if (!previewItem.extension.empty())
                                 {
-                                    StringCchPrintf(resultName, ARRAYSIZE(resultName), L"%s.%s", fs::path(originalName).stem().c_str(), newName);
+                                    StringCchPrintf(resultName, ARRAYSIZE(resultName), L"%s.%s", previewItem.stem.c_str(), newName);
                                 }
                                 else
                                 {
@@ -1085,15 +1198,10 @@ DWORD WINAPI CPowerRenameManager::s_regexWorkerThread(_In_ void* pv)
                     }
 
                     wchar_t transformedName[MAX_PATH] = { 0 };
-                    if (newNameToUse != nullptr && (flags & Uppercase || flags & Lowercase || flags & Titlecase || flags & Capitalized))
+                    if (newNameToUse != nullptr && caseTransform.Enabled())
                     {
-                        try
-                        {
-                            winrt::check_hresult(GetTransformedFileName(transformedName, ARRAYSIZE(transformedName), newNameToUse, flags, isFolder));
-                        }
-                        catch (...)
-                        {
-                        }
+                        caseTransform.Transform(newNameToUse, isFolder, transformedNameBuffer);
+                        StringCchCopy(transformedName, ARRAYSIZE(transformedName), transformedNameBuffer.c_str());
                         newNameToUse = transformedName;
                     }
 
@@ -1108,8 +1216,9 @@ DWORD WINAPI CPowerRenameManager::s_regexWorkerThread(_In_ void* pv)
                     if (newNameToUse != nullptr && (flags & EnumerateItems))
                     {
                         unsigned long countUsed = 0;
-                        if (GetEnumeratedFileName(uniqueName, ARRAYSIZE(uniqueName), newNameToUse, nullptr, itemEnumIndex, &countUsed))
+                        if (uniqueNames.Allocate(newNameToUse, previewItem.parentPath, itemEnumIndex, ARRAYSIZE(uniqueName), uniqueNameBuffer, countUsed, previewItem.originalName))
                         {
+                            StringCchCopy(uniqueName, ARRAYSIZE(uniqueName), uniqueNameBuffer.c_str());
                             newNameToUse = uniqueName;
                         }
                         itemEnumIndex++;
@@ -1120,13 +1229,16 @@ DWORD WINAPI CPowerRenameManager::s_regexWorkerThread(_In_ void* pv)
                     // Was there a change?
                     if (lstrcmp(currentNewName, newNameToUse) != 0)
                     {
-                        // Send the manager thread the item processed message
-                        PostMessage(pwtd->hwndManager, SRM_REGEX_ITEM_UPDATED, GetCurrentThreadId(), id);
+                        // Let the manager thread know the item was processed
+                        updatedIds->push_back(id);
                     }
                     CoTaskMemFree(newName);
                     CoTaskMemFree(currentNewName);
-                    CoTaskMemFree(originalName);
                 }
+
+                freeBatchNewNames();
+                postUpdatedItems();
+                CoTaskMemFree(searchTerm);
                 CoTaskMemFree(replaceTerm);
             }
 
@@ -1179,6 +1291,55 @@ void CPowerRenameManager::_Cancel()
     _CancelRegExWorkerThread();
 }
 
+void CPowerRenameManager::_EnsurePreviewItems()
+{
+    CSRWExclusiveAutoLock lock(&m_lockItems);
+    if (!m_previewItemsStale)
+    {
+        return;
+    }
+
+    m_previewItems.clear();
+    m_previewItems.reserve(m_renameItems.size());
+    for (auto& [id, item] : m_renameItems)
+    {
+        PreviewItem previewItem;
+        previewItem.item = item;
+        previewItem.id = id;
+
+        PWSTR originalName = nullptr;
+        winrt::check_hresult(item->GetOriginalName(&originalName));
+        previewItem.originalName = originalName;
+        CoTaskMemFree(originalName);
+
+        fs::path originalPath{ previewItem.originalName };
+        previewItem.stem = originalPath.stem().wstring();
+        previewItem.extension = originalPath.extension().wstring();
+
+        PWSTR path = nullptr;
+        if (SUCCEEDED(item->GetPath(&path)) && path)
+        {
+            previewItem.parentPath = fs::path(path).parent_path().wstring();
+        }
+        CoTaskMemFree(path);
+
+        winrt::check_hresult(item->GetIsFolder(&previewItem.isFolder));
+        winrt::check_hresult(item->GetIsSubFolderContent(&previewItem.isSubFolderContent));
+        winrt::check_hresult(item->GetDepth(&previewItem.depth));
+
+        m_previewItems.push_back(std::move(previewItem));
+    }
+
+    m_previewItemsStale = false;
+    m_previewSearchTerm.clear();
+}
+
+void CPowerRenameManager::_InvalidatePreviewItems()
+{
+    CSRWExclusiveAutoLock lock(&m_lockItems);
+    m_previewItemsStale = true;
+}
+
 HRESULT CPowerRenameManager::_EnsureRegEx()
 {
     HRESULT hr = S_OK;
@@ -1370,6 +1531,7 @@ void CPowerRenameManager::_ClearPowerRenameItems()
     }
 
     m_renameItems.clear();
+    m_previewItemsStale = true;
 }
 
 void CPowerRenameManager::_Cleanup()
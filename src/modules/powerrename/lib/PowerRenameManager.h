@@ -1,9 +1,11 @@
 #pragma once
 #include <vector>
 #include <map>
+#include <string>
 #include "srwlock.h"
 
 #include <PowerRenameInterfaces.h>
+#include "RenameExecutor.h"
 
 class CPowerRenameManager :
     public IPowerRenameManager,
@@ -23,7 +25,6 @@ public:
     IFACEMETHODIMP Reset();
     IFACEMETHODIMP Shutdown();
     IFACEMETHODIMP Rename(_In_ HWND hwndParent, bool closeWindow);
-    IFACEMETHODIMP UpdateChildrenPath(_In_ int parentId, _In_ size_t oldParentPathSize);
     IFACEMETHODIMP GetCloseUIWindowAfterRenaming(_Out_ bool* closeUIWindowAfterRenaming);
     IFACEMETHODIMP AddItem(_In_ IPowerRenameItem* pItem);
     IFACEMETHODIMP GetItemByIndex(_In_ UINT index, _COM_Outptr_ IPowerRenameItem** ppItem);
@@ -80,6 +81,10 @@ protected:
     void _CancelRegExWorkerThread();
     void _WaitForRegExWorkerThread();
     HRESULT _CreateFileOpWorkerThread();
+    std::vector<RenameEntry> _GetRenameEntries(DWORD flags);
+
+    void _EnsurePreviewItems();
+    void _InvalidatePreviewItems();
 
     HRESULT _EnsureRegEx();
     HRESULT _InitRegEx();
@@ -125,6 +130,32 @@ protected:
     _Guarded_by_(m_lockItems) std::map<int, IPowerRenameItem*> m_renameItems;
     _Guarded_by_(m_lockItems) std::vector<bool> m_isVisible;
 
+    // Flat copy of the per-item data the regex worker needs, so a preview pass doesn't walk
+    // the item map and call the item getters for every item on every keystroke.
+    struct PreviewItem
+    {
+        CComPtr<IPowerRenameItem> item;
+        int id = -1;
+        std::wstring originalName;
+        std::wstring stem;
+        std::wstring extension;
+        // Directory the item is in, where its new name must be free
+        std::wstring parentPath;
+        bool isFolder = false;
+        bool isSubFolderContent = false;
+        UINT depth = 0;
+        // The last literal search left this item's name unchanged, so a search term that
+        // extends that one can't match it either.
+        bool unmatched = false;
+    };
+
+    // Only touched by the regex worker thread, and only one runs at a time.
+    std::vector<PreviewItem> m_previewItems;
+    _Guarded_by_(m_lockItems) bool m_previewItemsStale = true;
+    // Search term and flags the unmatched states in m_previewItems were computed with.
+    std::wstring m_previewSearchTerm;
+    DWORD m_previewFlags = 0;
+
     // Parent HWND used by IFileOperation
     HWND m_hwndParent = nullptr;
     bool m_closeUIWindowAfterRenaming = true;
@@ -1,15 +1,38 @@
 #include "pch.h"
 #include "PowerRenameRegEx.h"
+#include "LiteralMatcher.h"
 #include "Settings.h"
 #include <regex>
 #include <string>
 #include <algorithm>
+#include <atomic>
 #include <boost/regex.hpp>
 #include <helpers.h>
 
 using namespace std;
 using std::regex_error;
 
+namespace
+{
+    // Below this many items per worker, spinning up threads costs more than it saves.
+    const size_t c_minBatchChunkSize = 256;
+}
+
+struct CPowerRenameRegEx::CompiledPattern
+{
+    DWORD flags = 0;
+    bool useBoostLib = false;
+    std::wstring searchTerm;
+    std::wstring replaceTerm;
+
+    // Shared so a file time change can reuse the regex built for the same search term.
+    std::shared_ptr<const std::wregex> stdPattern;
+    std::shared_ptr<const boost::wregex> boostPattern;
+    bool invalidPattern = false;
+
+    CLiteralMatcher literalMatcher;
+};
+
 IFACEMETHODIMP_(ULONG) CPowerRenameRegEx::AddRef()
 {
     return InterlockedIncrement(&m_refCount);
@@ -95,6 +118,7 @@ IFACEMETHODIMP CPowerRenameRegEx::PutSearchTerm(_In_ PCWSTR searchTerm, bool for
         if (m_searchTerm == nullptr || lstrcmp(searchTerm, m_searchTerm) != 0)
         {
             changed = true;
+            m_compiledPatternStale = true;
             CoTaskMemFree(m_searchTerm);
             if (lstrcmp(searchTerm, L"") == 0)
             {
@@ -137,6 +161,8 @@ IFACEMETHODIMP CPowerRenameRegEx::PutReplaceTerm(_In_ PCWSTR replaceTerm, bool f
         if (m_replaceTerm == nullptr || lstrcmp(replaceTerm, m_replaceTerm) != 0)
         {
             changed = true;
+            m_compiledPatternStale = true;
+            m_fileTimeTemplate.reset();
             CoTaskMemFree(m_replaceTerm);
             hr = SHStrDup(replaceTerm, &m_replaceTerm);
         }
@@ -161,6 +187,7 @@ IFACEMETHODIMP CPowerRenameRegEx::PutFlags(_In_ DWORD flags)
     if (m_flags != flags)
     {
         m_flags = flags;
+        _InvalidateCompiledPattern();
         _OnFlagsChanged();
     }
     return S_OK;
@@ -184,6 +211,7 @@ IFACEMETHODIMP CPowerRenameRegEx::PutFileTime(_In_ SYSTEMTIME fileTime)
     {
         m_fileTime = fileTime;
         m_useFileTime = true;
+        _InvalidateCompiledPattern();
         _OnFileTimeChanged();
     }
     return S_OK;
@@ -194,6 +222,7 @@ IFACEMETHODIMP CPowerRenameRegEx::ResetFileTime()
     SYSTEMTIME ZERO = { 0 };
     m_fileTime = ZERO;
     m_useFileTime = false;
+    _InvalidateCompiledPattern();
     _OnFileTimeChanged();
     return S_OK;
 }
@@ -232,87 +261,245 @@ HRESULT CPowerRenameRegEx::Replace(_In_ PCWSTR source, _Outptr_ PWSTR* result)
 {
     *result = nullptr;
 
-    CSRWSharedAutoLock lock(&m_lock);
+    std::shared_ptr<const CompiledPattern> pattern = _GetCompiledPattern();
     HRESULT hr = S_OK;
-    if (!(m_searchTerm && wcslen(m_searchTerm) > 0 && source && wcslen(source) > 0))
+    if (!(!pattern->searchTerm.empty() && source && wcslen(source) > 0))
     {
         return hr;
     }
-    wstring res = source;
-    try
+
+    wstring res;
+    hr = _Replace(*pattern, pattern->replaceTerm, source, res);
+    if (SUCCEEDED(hr))
     {
-        // TODO: creating the regex could be costly.  May want to cache this.
-        wchar_t newReplaceTerm[MAX_PATH] = { 0 };
-        bool fileTimeErrorOccurred = false;
-        if (m_useFileTime)
+        hr = SHStrDup(res.c_str(), result);
+    }
+    return hr;
+}
+
+HRESULT CPowerRenameRegEx::ReplaceBatch(_In_ UINT count, _In_reads_(count) const PCWSTR* sources, _In_reads_opt_(count) const SYSTEMTIME* fileTimes, _Out_writes_(count) PWSTR* results)
+{
+    std::fill(results, results + count, nullptr);
+
+    std::shared_ptr<const CompiledPattern> pattern = _GetCompiledPattern();
+    if (pattern->searchTerm.empty() || count == 0)
+    {
+        return S_OK;
+    }
+
+    if (pattern->invalidPattern)
+    {
+        return E_FAIL;
+    }
+
+    // The regex is shared by all the items, only the replace term is expanded for the file time of each one
+    std::optional<CFileTimeTemplate> fileTimeTemplate;
+    std::wstring replaceTerm;
+    if (fileTimes)
+    {
+        CSRWExclusiveAutoLock lock(&m_lock);
+        if (m_replaceTerm && *m_replaceTerm)
+        {
+            if (!m_fileTimeTemplate)
+            {
+                m_fileTimeTemplate.emplace(m_replaceTerm);
+            }
+            if (m_fileTimeTemplate->UsesFileTime())
+            {
+                fileTimeTemplate = m_fileTimeTemplate;
+                replaceTerm = m_replaceTerm;
+            }
+        }
+    }
+
+    std::atomic<HRESULT> batchResult = S_OK;
+    ParallelForChunks(count, c_minBatchChunkSize, [&](size_t begin, size_t end) {
+        std::wstring itemReplaceTerm;
+        std::wstring result;
+        for (size_t i = begin; i < end && SUCCEEDED(batchResult.load()); i++)
         {
-            if (FAILED(GetDatedFileName(newReplaceTerm, ARRAYSIZE(newReplaceTerm), m_replaceTerm, m_fileTime)))
-                fileTimeErrorOccurred = true;
+            if (!sources[i] || !*sources[i])
+            {
+                continue;
+            }
+
+            if (fileTimeTemplate)
+            {
+                _FormatReplaceTerm(replaceTerm.c_str(), &*fileTimeTemplate, fileTimes[i], itemReplaceTerm);
+            }
+
+            HRESULT hr = _Replace(*pattern, fileTimeTemplate ? itemReplaceTerm : pattern->replaceTerm, sources[i], result);
+            if (SUCCEEDED(hr))
+            {
+                hr = SHStrDup(result.c_str(), &results[i]);
+            }
+            if (FAILED(hr))
+            {
+                batchResult = hr;
+            }
         }
+    });
 
-        std::wstring sourceToUse(source);
-        std::wstring searchTerm(m_searchTerm);
-        std::wstring replaceTerm(L"");
-        if (m_useFileTime && !fileTimeErrorOccurred)
+    if (FAILED(batchResult.load()))
+    {
+        for (UINT i = 0; i < count; i++)
         {
-            replaceTerm = wstring(newReplaceTerm);
+            CoTaskMemFree(results[i]);
+            results[i] = nullptr;
         }
-        else if (m_replaceTerm)
+    }
+    return batchResult;
+}
+
+std::shared_ptr<const CPowerRenameRegEx::CompiledPattern> CPowerRenameRegEx::_GetCompiledPattern()
+{
+    {
+        CSRWSharedAutoLock lock(&m_lock);
+        if (!m_compiledPatternStale)
         {
-            replaceTerm = wstring(m_replaceTerm);
+            return m_compiledPattern;
         }
+    }
+
+    CSRWExclusiveAutoLock lock(&m_lock);
+    if (m_compiledPatternStale)
+    {
+        m_compiledPattern = _CompilePattern();
+        m_compiledPatternStale = false;
+    }
+    return m_compiledPattern;
+}
 
-        replaceTerm = regex_replace(replaceTerm, std::wregex(L"(([^\\$]|^)(\\$\\$)*)\\$[0]"), L"$1$$$0");
-        replaceTerm = regex_replace(replaceTerm, std::wregex(L"(([^\\$]|^)(\\$\\$)*)\\$([1-9])"), L"$1$0$4");
+// Must be called with m_lock held exclusively.
+std::shared_ptr<const CPowerRenameRegEx::CompiledPattern> CPowerRenameRegEx::_CompilePattern()
+{
+    auto pattern = std::make_shared<CompiledPattern>();
+    pattern->flags = m_flags;
+    pattern->useBoostLib = _useBoostLib;
+    if (m_searchTerm)
+    {
+        pattern->searchTerm = m_searchTerm;
+    }
 
-        if (m_flags & UseRegularExpressions)
+    // The file time tokens of the replace term are parsed once, the file time changes for every item
+    const bool useFileTime = m_useFileTime && m_replaceTerm && *m_replaceTerm;
+    if (useFileTime && !m_fileTimeTemplate)
+    {
+        m_fileTimeTemplate.emplace(m_replaceTerm);
+    }
+    _FormatReplaceTerm(m_replaceTerm, useFileTime ? &*m_fileTimeTemplate : nullptr, m_fileTime, pattern->replaceTerm);
+
+    if (!(pattern->flags & UseRegularExpressions))
+    {
+        pattern->literalMatcher = CLiteralMatcher(pattern->searchTerm, (pattern->flags & CaseSensitive) != 0);
+    }
+    else if (!pattern->searchTerm.empty())
+    {
+        // Only the replace term depends on the file time, so keep the regex from the last compile
+        // when the search term and flags are unchanged.
+        const CompiledPattern* previous = m_compiledPattern.get();
+        if (previous && previous->searchTerm == pattern->searchTerm && previous->flags == pattern->flags && previous->useBoostLib == pattern->useBoostLib)
         {
-            if (_useBoostLib)
+            pattern->stdPattern = previous->stdPattern;
+            pattern->boostPattern = previous->boostPattern;
+            pattern->invalidPattern = previous->invalidPattern;
+        }
+        else
+        {
+            try
             {
-                boost::wregex pattern(m_searchTerm, (!(m_flags & CaseSensitive)) ? boost::regex::icase | boost::regex::ECMAScript : boost::regex::ECMAScript);
-                if (m_flags & MatchAllOccurences)
+                if (pattern->useBoostLib)
                 {
-                    res = boost::regex_replace(wstring(source), pattern, replaceTerm);
+                    pattern->boostPattern = std::make_shared<const boost::wregex>(pattern->searchTerm, (!(pattern->flags & CaseSensitive)) ? boost::regex::icase | boost::regex::ECMAScript : boost::regex::ECMAScript);
                 }
                 else
                 {
-                    res = boost::regex_replace(wstring(source), pattern, replaceTerm, boost::regex_constants::format_first_only);
+                    pattern->stdPattern = std::make_shared<const std::wregex>(pattern->searchTerm, (!(pattern->flags & CaseSensitive)) ? regex_constants::icase | regex_constants::ECMAScript : regex_constants::ECMAScript);
                 }
             }
-            else
+            catch (const regex_error&)
+            {
+                pattern->invalidPattern = true;
+            }
+            catch (const boost::regex_error&)
             {
-                std::wregex pattern(m_searchTerm, (!(m_flags & CaseSensitive)) ? regex_constants::icase | regex_constants::ECMAScript : regex_constants::ECMAScript);
-                if (m_flags & MatchAllOccurences)
+                pattern->invalidPattern = true;
+            }
+        }
+    }
+
+    return pattern;
+}
+
+void CPowerRenameRegEx::_InvalidateCompiledPattern()
+{
+    CSRWExclusiveAutoLock lock(&m_lock);
+    m_compiledPatternStale = true;
+}
+
+void CPowerRenameRegEx::_FormatReplaceTerm(PCWSTR replaceTerm, const CFileTimeTemplate* fileTimeTemplate, const SYSTEMTIME& fileTime, std::wstring& result)
+{
+    bool replaceTermDated = false;
+    if (fileTimeTemplate && replaceTerm && *replaceTerm)
+    {
+        fileTimeTemplate->Format(fileTime, result);
+        // Dated replace terms are limited to MAX_PATH like GetDatedFileName does
+        replaceTermDated = result.size() < MAX_PATH;
+    }
+
+    if (!replaceTermDated)
+    {
+        result = replaceTerm ? replaceTerm : L"";
+    }
+
+    static const std::wregex zeroGroupReference(L"(([^\\$]|^)(\\$\\$)*)\\$[0]");
+    static const std::wregex groupReference(L"(([^\\$]|^)(\\$\\$)*)\\$([1-9])");
+    result = regex_replace(result, zeroGroupReference, L"$1$$$0");
+    result = regex_replace(result, groupReference, L"$1$0$4");
+}
+
+HRESULT CPowerRenameRegEx::_Replace(const CompiledPattern& pattern, const std::wstring& replaceTerm, std::wstring_view source, std::wstring& result)
+{
+    if (pattern.invalidPattern)
+    {
+        return E_FAIL;
+    }
+
+    HRESULT hr = S_OK;
+    try
+    {
+        if (pattern.flags & UseRegularExpressions)
+        {
+            wstring res{ source };
+            if (pattern.useBoostLib)
+            {
+                if (pattern.flags & MatchAllOccurences)
                 {
-                    res = regex_replace(wstring(source), pattern, replaceTerm);
+                    res = boost::regex_replace(res, *pattern.boostPattern, replaceTerm);
                 }
                 else
                 {
-                    res = regex_replace(wstring(source), pattern, replaceTerm, regex_constants::format_first_only);
+                    res = boost::regex_replace(res, *pattern.boostPattern, replaceTerm, boost::regex_constants::format_first_only);
                 }
             }
-        }
-        else
-        {
-            // Simple search and replace
-            size_t pos = 0;
-            do
+            else
             {
-                pos = _Find(sourceToUse, searchTerm, (!(m_flags & CaseSensitive)), pos);
-                if (pos != std::string::npos)
+                if (pattern.flags & MatchAllOccurences)
                 {
-                    res = sourceToUse.replace(pos, searchTerm.length(), replaceTerm);
-                    pos += replaceTerm.length();
+                    res = regex_replace(res, *pattern.stdPattern, replaceTerm);
                 }
-
-                if (!(m_flags & MatchAllOccurences))
+                else
                 {
-                    break;
+                    res = regex_replace(res, *pattern.stdPattern, replaceTerm, regex_constants::format_first_only);
                 }
-            } while (pos != std::string::npos);
+            }
+            result = std::move(res);
+        }
+        else
+        {
+            // Simple search and replace, written straight into the caller's buffer
+            pattern.literalMatcher.Replace(source, replaceTerm, (pattern.flags & MatchAllOccurences) != 0, result);
         }
-
-        hr = SHStrDup(res.c_str(), result);
     }
     catch (regex_error e)
     {
@@ -321,19 +508,6 @@ HRESULT CPowerRenameRegEx::Replace(_In_ PCWSTR source, _Outptr_ PWSTR* result)
     return hr;
 }
 
-size_t CPowerRenameRegEx::_Find(std::wstring data, std::wstring toSearch, bool caseInsensitive, size_t pos)
-{
-    if (caseInsensitive)
-    {
-        // Convert to lower
-        std::transform(data.begin(), data.end(), data.begin(), ::towlower);
-        std::transform(toSearch.begin(), toSearch.end(), toSearch.begin(), ::towlower);
-    }
-
-    // Find sub string position in given string starting at position pos
-    return data.find(toSearch, pos);
-}
-
 void CPowerRenameRegEx::_OnSearchTermChanged()
 {
     CSRWSharedAutoLock lock(&m_lockEvents);
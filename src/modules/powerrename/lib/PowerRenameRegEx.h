@@ -1,8 +1,11 @@
 #pragma once
 #include "pch.h"
+#include <memory>
+#include <optional>
 #include <vector>
 #include <string>
 #include "srwlock.h"
+#include "FileTimeTemplate.h"
 
 #include "PowerRenameInterfaces.h"
 
@@ -28,6 +31,7 @@ public:
     IFACEMETHODIMP PutFileTime(_In_ SYSTEMTIME fileTime);
     IFACEMETHODIMP ResetFileTime();
     IFACEMETHODIMP Replace(_In_ PCWSTR source, _Outptr_ PWSTR* result);
+    IFACEMETHODIMP ReplaceBatch(_In_ UINT count, _In_reads_(count) const PCWSTR* sources, _In_reads_opt_(count) const SYSTEMTIME* fileTimes, _Out_writes_(count) PWSTR* results);
 
     static HRESULT s_CreateInstance(_Outptr_ IPowerRenameRegEx **renameRegEx);
 
@@ -40,7 +44,17 @@ protected:
     void _OnFlagsChanged();
     void _OnFileTimeChanged();
 
-    size_t _Find(std::wstring data, std::wstring toSearch, bool caseInsensitive, size_t pos);
+    // Regex objects and the escaped replace term, built once per search term, replace term,
+    // flags and file time instead of once per item.
+    struct CompiledPattern;
+
+    std::shared_ptr<const CompiledPattern> _GetCompiledPattern();
+    std::shared_ptr<const CompiledPattern> _CompilePattern();
+    void _InvalidateCompiledPattern();
+
+    // Expands the file time tokens of replaceTerm if fileTimeTemplate is given, and escapes its group references
+    static void _FormatReplaceTerm(PCWSTR replaceTerm, const CFileTimeTemplate* fileTimeTemplate, const SYSTEMTIME& fileTime, std::wstring& result);
+    static HRESULT _Replace(const CompiledPattern& pattern, const std::wstring& replaceTerm, std::wstring_view source, std::wstring& result);
 
     bool _useBoostLib = false;
     DWORD m_flags = DEFAULT_FLAGS;
@@ -53,6 +67,11 @@ protected:
     CSRWLock m_lock;
     CSRWLock m_lockEvents;
 
+    _Guarded_by_(m_lock) std::shared_ptr<const CompiledPattern> m_compiledPattern;
+    _Guarded_by_(m_lock) bool m_compiledPatternStale = true;
+    // Parsed on the first compile using a file time after the replace term changes
+    _Guarded_by_(m_lock) std::optional<CFileTimeTemplate> m_fileTimeTemplate;
+
     DWORD m_cookie = 0;
 
     struct RENAME_REGEX_EVENT
@@ -0,0 +1,130 @@
+#include "pch.h"
+#include "RenameExecutor.h"
+#include "Helpers.h"
+
+#include <algorithm>
+#include <atomic>
+#include <string_view>
+#include <unordered_map>
+
+namespace
+{
+    // Below this many renames at one depth the threads cost more than they save.
+    const size_t c_minConcurrentRenames = 16;
+}
+
+CRenameExecutor::CRenameExecutor(std::vector<RenameEntry> entries) :
+    m_entries(std::move(entries))
+{
+    const size_t count = m_entries.size();
+    m_parents.assign(count, npos);
+    m_nameOffsets.resize(count);
+
+    std::unordered_map<std::wstring_view, size_t> indexByPath;
+    indexByPath.reserve(count);
+    UINT maxDepth = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        const std::wstring& path = m_entries[i].path;
+        const size_t separator = path.find_last_of(L'\\');
+        m_nameOffsets[i] = separator == std::wstring::npos ? 0 : separator + 1;
+        indexByPath.emplace(path, i);
+        maxDepth = std::max<UINT>(maxDepth, m_entries[i].depth);
+    }
+
+    m_levels.resize(static_cast<size_t>(maxDepth) + 1);
+    for (size_t i = 0; i < count; i++)
+    {
+        if (m_nameOffsets[i] > 0)
+        {
+            const std::wstring_view parentPath(m_entries[i].path.data(), m_nameOffsets[i] - 1);
+            const auto parent = indexByPath.find(parentPath);
+            if (parent != indexByPath.end() && m_entries[parent->second].depth < m_entries[i].depth)
+            {
+                m_parents[i] = parent->second;
+            }
+        }
+
+        if (!m_entries[i].newName.empty())
+        {
+            m_levels[m_entries[i].depth].push_back(i);
+        }
+    }
+}
+
+HRESULT CRenameExecutor::Execute(IRenameBackend& backend) const
+{
+    std::atomic<HRESULT> result = S_OK;
+    auto rename = [&](size_t index) {
+        HRESULT hr = backend.Rename(m_entries[index]);
+        if (FAILED(hr))
+        {
+            HRESULT expected = S_OK;
+            result.compare_exchange_strong(expected, hr);
+        }
+    };
+
+    // Items at the same depth never contain each other, so each level only has to wait for the
+    // level below it.
+    for (auto level = m_levels.rbegin(); level != m_levels.rend(); ++level)
+    {
+        if (backend.CanRenameConcurrently() && level->size() >= c_minConcurrentRenames)
+        {
+            ParallelForChunks(level->size(), c_minConcurrentRenames / 4, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; i++)
+                {
+                    rename((*level)[i]);
+                }
+            });
+        }
+        else
+        {
+            for (size_t index : *level)
+            {
+                rename(index);
+            }
+        }
+    }
+
+    return result;
+}
+
+std::vector<std::wstring> CRenameExecutor::GetRenamedPaths() const
+{
+    const size_t count = m_entries.size();
+    std::vector<std::wstring> paths(count);
+
+    // Parents are always shallower than their children, so walking by depth finalizes every
+    // parent path before it is used.
+    std::vector<std::vector<size_t>> byDepth(m_levels.size());
+    for (size_t i = 0; i < count; i++)
+    {
+        byDepth[m_entries[i].depth].push_back(i);
+    }
+
+    for (const auto& level : byDepth)
+    {
+        for (size_t i : level)
+        {
+            const RenameEntry& entry = m_entries[i];
+            const std::wstring_view name = entry.newName.empty() ?
+                                               std::wstring_view(entry.path).substr(m_nameOffsets[i]) :
+                                               std::wstring_view(entry.newName);
+            std::wstring& path = paths[i];
+            if (m_parents[i] != npos)
+            {
+                const std::wstring& parentPath = paths[m_parents[i]];
+                path.reserve(parentPath.size() + 1 + name.size());
+                path.append(parentPath).append(1, L'\\');
+            }
+            else
+            {
+                path.reserve(m_nameOffsets[i] + name.size());
+                path.append(entry.path, 0, m_nameOffsets[i]);
+            }
+            path.append(name);
+        }
+    }
+
+    return paths;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "PowerRenameInterfaces.h"
+
+// Item taking part in a batch rename, in enumeration order (every folder comes before its contents).
+struct RenameEntry
+{
+    CComPtr<IPowerRenameItem> item;
+    UINT depth = 0;
+    std::wstring path;
+    std::wstring originalName;
+    // Empty when the item keeps its name
+    std::wstring newName;
+};
+
+// Filesystem side of a batch rename, so the ordering and path bookkeeping can be tested without the shell.
+class IRenameBackend
+{
+public:
+    virtual ~IRenameBackend() = default;
+
+    virtual HRESULT Rename(const RenameEntry& entry) = 0;
+
+    // True if renames of items at the same depth may be issued from several threads at once.
+    virtual bool CanRenameConcurrently() const = 0;
+};
+
+// Renames a batch of items deepest first, so a folder is only renamed after everything below it.
+// The parent of each item is resolved once, which lets the post-rename paths of all items be
+// computed in a single pass instead of rewriting the children of every renamed folder.
+class CRenameExecutor
+{
+public:
+    explicit CRenameExecutor(std::vector<RenameEntry> entries);
+
+    // Returns the first failure, but keeps renaming the remaining items.
+    HRESULT Execute(IRenameBackend& backend) const;
+
+    // Path of every entry once the batch has been renamed, in entry order.
+    std::vector<std::wstring> GetRenamedPaths() const;
+
+    const std::vector<RenameEntry>& GetEntries() const { return m_entries; }
+
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    // Index of the folder entry containing the given entry, or npos if it isn't part of the batch.
+    size_t GetParentIndex(size_t index) const { return m_parents[index]; }
+
+private:
+    std::vector<RenameEntry> m_entries;
+    std::vector<size_t> m_parents;
+    // Start of each entry's own name within its path
+    std::vector<size_t> m_nameOffsets;
+    // Indices of the entries with a new name, grouped by depth
+    std::vector<std::vector<size_t>> m_levels;
+};
@@ -0,0 +1,181 @@
+#include "pch.h"
+#include "UniqueNameAllocator.h"
+#include "CaseTransform.h"
+
+namespace
+{
+    // Like PathFindExtension: the last dot of the name, unless a space follows it
+    size_t FindExtension(std::wstring_view name)
+    {
+        size_t extension = std::wstring_view::npos;
+        for (size_t i = 0; i < name.size(); i++)
+        {
+            if (name[i] == L'.')
+            {
+                extension = i;
+            }
+            else if (name[i] == L' ' || name[i] == L'\\')
+            {
+                extension = std::wstring_view::npos;
+            }
+        }
+        return extension != std::wstring_view::npos ? extension : name.size();
+    }
+
+    // Largest number (exclusive) GetEnumeratedFileName tried for the room left for the digits
+    unsigned long GetMaxNumber(ptrdiff_t digitsRoom, unsigned long minNumber)
+    {
+        switch (digitsRoom)
+        {
+        case 1:
+            return 10;
+        case 2:
+            return 100;
+        case 3:
+            return 1000;
+        case 4:
+            return 10000;
+        case 5:
+            return 100000;
+        default:
+            return digitsRoom <= 0 ? minNumber : 1000000;
+        }
+    }
+}
+
+CUniqueNameAllocator::CUniqueNameAllocator() :
+    m_lister(ListDirectory)
+{
+}
+
+CUniqueNameAllocator::CUniqueNameAllocator(DirectoryLister lister) :
+    m_lister(std::move(lister))
+{
+}
+
+void CUniqueNameAllocator::ListDirectory(const std::wstring& directory, std::vector<std::wstring>& names)
+{
+    if (directory.empty())
+    {
+        return;
+    }
+
+    std::wstring pattern = directory;
+    if (pattern.back() != L'\\')
+    {
+        pattern += L'\\';
+    }
+    pattern += L'*';
+
+    WIN32_FIND_DATAW findData;
+    HANDLE find = FindFirstFileExW(pattern.c_str(), FindExInfoBasic, &findData, FindExSearchNameMatch, nullptr, FIND_FIRST_EX_LARGE_FETCH);
+    if (find == INVALID_HANDLE_VALUE)
+    {
+        return;
+    }
+
+    do
+    {
+        names.push_back(findData.cFileName);
+    } while (FindNextFileW(find, &findData));
+    FindClose(find);
+}
+
+CUniqueNameAllocator::DirectoryNames& CUniqueNameAllocator::GetDirectoryNames(const std::wstring& directory)
+{
+    std::wstring key;
+    CCaseTransform::AppendUppercase(directory, key);
+
+    auto [it, inserted] = m_directories.try_emplace(std::move(key));
+    if (inserted && !directory.empty())
+    {
+        std::vector<std::wstring> names;
+        m_lister(directory, names);
+
+        it->second.names.reserve(names.size());
+        std::wstring upperName;
+        for (const auto& name : names)
+        {
+            upperName.clear();
+            CCaseTransform::AppendUppercase(name, upperName);
+            it->second.names.emplace(upperName, false);
+        }
+    }
+    return it->second;
+}
+
+bool CUniqueNameAllocator::Allocate(std::wstring_view nameTemplate, const std::wstring& directory, unsigned long minNumber, size_t cchMax, std::wstring& result, unsigned long& numberUsed, std::wstring_view currentName)
+{
+    result.clear();
+
+    // The first "(digits)" of the template is replaced by the number
+    size_t open = nameTemplate.find(L'(');
+    size_t digitsEnd = 0;
+    while (open != std::wstring_view::npos)
+    {
+        digitsEnd = open + 1;
+        while (digitsEnd < nameTemplate.size() && nameTemplate[digitsEnd] >= L'0' && nameTemplate[digitsEnd] <= L'9')
+        {
+            digitsEnd++;
+        }
+
+        if (digitsEnd < nameTemplate.size() && nameTemplate[digitsEnd] == L')')
+        {
+            break;
+        }
+        open = nameTemplate.find(L'(', open + 1);
+    }
+
+    const bool hasNumber = open != std::wstring_view::npos;
+    const std::wstring_view stem = hasNumber ? nameTemplate.substr(0, open + 1) : nameTemplate.substr(0, FindExtension(nameTemplate));
+    const std::wstring_view rest = nameTemplate.substr(hasNumber ? digitsEnd : stem.size());
+
+    // " (" and ")" are added around the number if the template has none
+    const size_t formatLength = hasNumber ? 0 : 3;
+    const ptrdiff_t digitsRoom = static_cast<ptrdiff_t>(cchMax) - static_cast<ptrdiff_t>(directory.size() + stem.size() + formatLength);
+    const unsigned long maxNumber = GetMaxNumber(digitsRoom, minNumber);
+    const size_t directoryLength = directory.empty() ? 0 : directory.size() + (directory.back() == L'\\' ? 0 : 1);
+
+    DirectoryNames& directoryNames = GetDirectoryNames(directory);
+
+    std::wstring templateKey;
+    CCaseTransform::AppendUppercase(stem, templateKey);
+    templateKey += hasNumber ? L'\0' : L'\1';
+    CCaseTransform::AppendUppercase(rest, templateKey);
+    TakenRange& taken = directoryNames.takenRanges[templateKey];
+
+    // The name the item has now is free for it, unless it was handed out to another item
+    std::wstring upperCurrentName;
+    CCaseTransform::AppendUppercase(currentName, upperCurrentName);
+
+    // Numbers already found taken for the template are skipped
+    const bool continuesRange = taken.low < taken.high && minNumber >= taken.low && minNumber <= taken.high;
+    std::wstring upperName;
+    for (unsigned long number = continuesRange ? taken.high : minNumber; number < maxNumber; number++)
+    {
+        result.assign(stem);
+        result += hasNumber ? L"" : L" (";
+        result += std::to_wstring(number);
+        result += hasNumber ? L"" : L")";
+        result += rest;
+        if (directoryLength + result.size() >= cchMax)
+        {
+            // Larger numbers don't fit either
+            break;
+        }
+
+        upperName.clear();
+        CCaseTransform::AppendUppercase(result, upperName);
+        auto [entry, inserted] = directoryNames.names.try_emplace(upperName, true);
+        if (inserted || (!entry->second && upperName == upperCurrentName))
+        {
+            entry->second = true;
+            taken = { continuesRange ? taken.low : minNumber, number + 1 };
+            numberUsed = number;
+            return true;
+        }
+    }
+
+    result.clear();
+    return false;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Hands out enumerated names ("foo (1).txt", "foo (2).txt", ...) which are neither taken in their directory nor
+// handed out before by the same allocator.
+// The entries of a directory are listed once on its first use instead of checking every candidate with
+// PathFileExists, and the numbers known to be taken are remembered for each name, so giving many items the
+// same name doesn't probe the same numbers again for each of them.
+class CUniqueNameAllocator
+{
+public:
+    // Adds the names of the entries of directory to names
+    using DirectoryLister = std::function<void(const std::wstring& directory, std::vector<std::wstring>& names)>;
+
+    CUniqueNameAllocator();
+    explicit CUniqueNameAllocator(DirectoryLister lister);
+
+    // Writes nameTemplate enumerated with the first free number at or after minNumber into result. The number
+    // replaces the first "(digits)" of the template, or is appended as " (n)" before the extension if there is
+    // none. Returns false if no number fits in a path of cchMax characters, including the directory.
+    // An empty directory stands for items without a path: only the names handed out before are avoided.
+    // currentName is the name the item has in directory now, which it can keep although it is listed there.
+    bool Allocate(std::wstring_view nameTemplate, const std::wstring& directory, unsigned long minNumber, size_t cchMax, std::wstring& result, unsigned long& numberUsed, std::wstring_view currentName = {});
+
+    static void ListDirectory(const std::wstring& directory, std::vector<std::wstring>& names);
+
+private:
+    // Numbers in [low, high) are known to be taken for a template
+    struct TakenRange
+    {
+        unsigned long low = 0;
+        unsigned long high = 0;
+    };
+
+    struct DirectoryNames
+    {
+        // Uppercased, since names differing only in case collide. True for the names handed out, false for the
+        // names listed in the directory.
+        std::unordered_map<std::wstring, bool> names;
+        std::unordered_map<std::wstring, TakenRange> takenRanges;
+    };
+
+    DirectoryNames& GetDirectoryNames(const std::wstring& directory);
+
+    DirectoryLister m_lister;
+    std::unordered_map<std::wstring, DirectoryNames> m_directories;
+};
@@ -0,0 +1,148 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <CaseTransform.h>
+#include <algorithm>
+#include <filesystem>
+#include <random>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace CaseTransformTests
+{
+    // The per-character transforms GetTransformedFileName made before CCaseTransform.
+    std::wstring ReferenceTransform(const std::wstring& source, DWORD flags, bool isFolder)
+    {
+        auto transform = [&](std::wstring s) {
+            std::transform(s.begin(), s.end(), s.begin(), (flags & Uppercase) ? ::towupper : ::towlower);
+            return s;
+        };
+        const std::wstring stem = isFolder ? source : std::filesystem::path(source).stem().wstring();
+        const std::wstring extension = isFolder ? L"" : std::filesystem::path(source).extension().wstring();
+
+        if (flags & (Uppercase | Lowercase))
+        {
+            if (!isFolder && (flags & NameOnly))
+            {
+                return transform(stem) + extension;
+            }
+            if (!isFolder && (flags & ExtensionOnly) && !extension.empty())
+            {
+                return stem + transform(extension);
+            }
+            return transform(source);
+        }
+
+        if (!(flags & (Titlecase | Capitalized)) || (flags & ExtensionOnly))
+        {
+            return source;
+        }
+
+        const std::vector<std::wstring> exceptions = { L"a", L"an", L"to", L"the", L"at", L"by", L"for", L"in", L"of", L"on", L"up", L"and", L"as", L"but", L"or", L"nor" };
+        std::wstring result = stem;
+        size_t stemLength = result.length();
+        bool isFirstWord = true;
+        while (stemLength > 0 && (iswspace(result[stemLength - 1]) || iswpunct(result[stemLength - 1])))
+        {
+            stemLength--;
+        }
+
+        for (size_t i = 0; i < stemLength; i++)
+        {
+            if (i && !iswspace(result[i - 1]) && !iswpunct(result[i - 1]))
+            {
+                result[i] = towlower(result[i]);
+            }
+            else if (!iswspace(result[i]) && !iswpunct(result[i]))
+            {
+                size_t wordLength = 0;
+                while (i + wordLength < stemLength && !iswspace(result[i + wordLength]) && !iswpunct(result[i + wordLength]))
+                {
+                    wordLength++;
+                }
+                if ((flags & Capitalized) || isFirstWord || i + wordLength == stemLength || std::find(exceptions.begin(), exceptions.end(), result.substr(i, wordLength)) == exceptions.end())
+                {
+                    result[i] = towupper(result[i]);
+                    isFirstWord = false;
+                }
+                else
+                {
+                    result[i] = towlower(result[i]);
+                }
+            }
+        }
+        return result + extension;
+    }
+
+    std::wstring Transform(std::wstring_view name, DWORD flags, bool isFolder = false)
+    {
+        std::wstring result;
+        CCaseTransform(flags).Transform(name, isFolder, result);
+        return result;
+    }
+
+    TEST_CLASS(SimpleTests)
+    {
+    public:
+        TEST_METHOD(UppercaseAndLowercase)
+        {
+            Assert::AreEqual(std::wstring(L"HOLIDAY PHOTOS \u00C9T\u00C9 2020.JPG"), Transform(L"Holiday photos \u00E9t\u00E9 2020.jpg", Uppercase));
+            Assert::AreEqual(std::wstring(L"holiday photos \u00E9t\u00E9 2020.jpg"), Transform(L"Holiday Photos \u00C9T\u00C9 2020.JPG", Lowercase));
+            Assert::AreEqual(std::wstring(L"FOO.txt"), Transform(L"foo.txt", Uppercase | NameOnly));
+            Assert::AreEqual(std::wstring(L"foo.TXT"), Transform(L"foo.txt", Uppercase | ExtensionOnly));
+            // Names without an extension are transformed as a whole
+            Assert::AreEqual(std::wstring(L"FOO"), Transform(L"foo", Uppercase | ExtensionOnly));
+            Assert::AreEqual(std::wstring(L"FOO.TXT"), Transform(L"foo.txt", Uppercase | NameOnly, true));
+        }
+
+        TEST_METHOD(TitlecaseAndCapitalized)
+        {
+            Assert::AreEqual(std::wstring(L"Bar And the To.txt"), Transform(L"bar AND the to.txt", Titlecase));
+            Assert::AreEqual(std::wstring(L"The Lord of the Rings"), Transform(L"the lord of the rings", Titlecase));
+            Assert::AreEqual(std::wstring(L"Bar And The To.txt"), Transform(L"bar AND the to.txt", Capitalized));
+            Assert::AreEqual(std::wstring(L"Foo-Bar_\u00C9t\u00E9 (1)!!"), Transform(L"foo-BAR_\u00E9T\u00C9 (1)!!", Capitalized));
+            Assert::AreEqual(std::wstring(L"foo.bar.txt"), Transform(L"foo.bar.txt", Titlecase | ExtensionOnly));
+            Assert::AreEqual(std::wstring(L"Foo.Bar"), Transform(L"foo.bar", Capitalized, true));
+        }
+
+        TEST_METHOD(SplitFileName)
+        {
+            const wchar_t* names[] = { L"foo.txt", L"foo", L".gitignore", L"foo.", L"foo..txt", L"..", L"a.b.c" };
+            for (auto name : names)
+            {
+                std::wstring_view stem;
+                std::wstring_view extension;
+                CCaseTransform::SplitFileName(name, stem, extension);
+                Assert::AreEqual(std::filesystem::path(name).stem().wstring(), std::wstring(stem));
+                Assert::AreEqual(std::filesystem::path(name).extension().wstring(), std::wstring(extension));
+            }
+        }
+
+        TEST_METHOD(TransformMatchesReferenceImplementation)
+        {
+            // The reference uses towupper and towlower, which depend on the global locale
+            std::locale::global(std::locale(""));
+
+            const wchar_t* words[] = { L"the", L"The", L"a", L"AN", L"nor", L"foo", L"BAR", L"\u00E9t\u00C9", L"x", L"Long words with Mixed CASE" };
+            const wchar_t* separators[] = { L" ", L"-", L".", L"_", L"  ", L"'", L"..", L"(" };
+            const DWORD flagSets[] = { Uppercase, Lowercase, Titlecase, Capitalized, Uppercase | NameOnly, Lowercase | ExtensionOnly, Titlecase | ExtensionOnly, Capitalized | NameOnly, NameOnly };
+            std::mt19937 random(42);
+
+            std::wstring result;
+            for (int i = 0; i < 20000; i++)
+            {
+                std::wstring name;
+                for (size_t count = random() % 6; count > 0; count--)
+                {
+                    name += words[random() % ARRAYSIZE(words)];
+                    name += separators[random() % ARRAYSIZE(separators)];
+                }
+                name += words[random() % ARRAYSIZE(words)];
+
+                const DWORD flags = flagSets[random() % ARRAYSIZE(flagSets)];
+                const bool isFolder = random() % 4 == 0;
+                CCaseTransform(flags).Transform(name, isFolder, result);
+                Assert::AreEqual(ReferenceTransform(name, flags, isFolder), result);
+            }
+        }
+    };
+}
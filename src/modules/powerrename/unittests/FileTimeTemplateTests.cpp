@@ -0,0 +1,156 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <FileTimeTemplate.h>
+#include <random>
+#include <regex>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace FileTimeTemplateTests
+{
+    std::wstring Format(std::wstring_view replaceTerm, const SYSTEMTIME& fileTime)
+    {
+        std::wstring result;
+        CFileTimeTemplate(replaceTerm).Format(fileTime, result);
+        return result;
+    }
+
+    // The regex pass for each token GetDatedFileName made before CFileTimeTemplate, with the names passed in.
+    std::wstring ReferenceFormat(std::wstring source, const SYSTEMTIME& fileTime, const std::wstring (&names)[4])
+    {
+        auto replace = [&](const wchar_t* token, const std::wstring& value) {
+            source = std::regex_replace(source, std::wregex(std::wstring(L"(([^\\$]|^)(\\$\\$)*)\\$") + token), L"$01" + value);
+        };
+        auto number = [](const wchar_t* format, int value) {
+            wchar_t buffer[16];
+            StringCchPrintf(buffer, ARRAYSIZE(buffer), format, value);
+            return std::wstring(buffer);
+        };
+
+        replace(L"YYYY", number(L"%04d", fileTime.wYear));
+        replace(L"YY", number(L"%02d", fileTime.wYear % 100));
+        replace(L"Y", number(L"%d", fileTime.wYear % 10));
+        replace(L"MMMM", names[0]);
+        replace(L"MMM", names[1]);
+        replace(L"MM", number(L"%02d", fileTime.wMonth));
+        replace(L"M", number(L"%d", fileTime.wMonth));
+        replace(L"DDDD", names[2]);
+        replace(L"DDD", names[3]);
+        replace(L"DD", number(L"%02d", fileTime.wDay));
+        replace(L"D", number(L"%d", fileTime.wDay));
+        replace(L"hh", number(L"%02d", fileTime.wHour));
+        replace(L"h", number(L"%d", fileTime.wHour));
+        replace(L"mm", number(L"%02d", fileTime.wMinute));
+        replace(L"m", number(L"%d", fileTime.wMinute));
+        replace(L"ss", number(L"%02d", fileTime.wSecond));
+        replace(L"s", number(L"%d", fileTime.wSecond));
+        replace(L"fff", number(L"%03d", fileTime.wMilliseconds));
+        replace(L"ff", number(L"%02d", fileTime.wMilliseconds / 10));
+        replace(L"f", number(L"%d", fileTime.wMilliseconds / 100));
+        return source;
+    }
+
+    std::wstring FormatDateName(const SYSTEMTIME& fileTime, PCWSTR format)
+    {
+        wchar_t localeName[LOCALE_NAME_MAX_LENGTH];
+        if (GetUserDefaultLocaleName(localeName, LOCALE_NAME_MAX_LENGTH) == 0)
+        {
+            StringCchCopy(localeName, LOCALE_NAME_MAX_LENGTH, L"en_US");
+        }
+
+        wchar_t formattedDate[MAX_PATH] = { 0 };
+        GetDateFormatEx(localeName, NULL, &fileTime, format, formattedDate, MAX_PATH, NULL);
+        LCMapStringEx(localeName, LCMAP_UPPERCASE | LCMAP_LINGUISTIC_CASING, formattedDate, 1, formattedDate, 1, nullptr, nullptr, 0);
+        return formattedDate;
+    }
+
+    TEST_CLASS(SimpleTests)
+    {
+    public:
+        TEST_METHOD(FormatNumbers)
+        {
+            SYSTEMTIME fileTime = { 2020, 7, 3, 22, 15, 6, 42, 453 };
+            Assert::AreEqual(std::wstring(L"bar20-7-22-15-6-42-4"), Format(L"bar$YY-$M-$D-$h-$m-$s-$f", fileTime));
+            Assert::AreEqual(std::wstring(L"bar2020-07-22-15-06-42-453"), Format(L"bar$YYYY-$MM-$DD-$hh-$mm-$ss-$fff", fileTime));
+            Assert::AreEqual(std::wstring(L"0-45"), Format(L"$Y-$ff", fileTime));
+        }
+
+        TEST_METHOD(FormatEscapedDollars)
+        {
+            SYSTEMTIME fileTime = { 2020, 7, 3, 22, 15, 6, 42, 453 };
+            Assert::AreEqual(std::wstring(L"$$YYYY"), Format(L"$$YYYY", fileTime));
+            Assert::AreEqual(std::wstring(L"$$2020"), Format(L"$$$YYYY", fileTime));
+            Assert::AreEqual(std::wstring(L"$$$$M$x$"), Format(L"$$$$M$x$", fileTime));
+        }
+
+        TEST_METHOD(FormatRepeatedTokens)
+        {
+            // A token directly following the same token was left to the shorter tokens
+            SYSTEMTIME fileTime = { 2020, 7, 3, 22, 15, 6, 42, 453 };
+            Assert::AreEqual(std::wstring(L"0$Y"), Format(L"$Y$Y", fileTime));
+            Assert::AreEqual(std::wstring(L"077M"), Format(L"$MM$MM", fileTime));
+            Assert::AreEqual(std::wstring(L"200Y20"), Format(L"$YY$YY$YY", fileTime));
+        }
+
+        TEST_METHOD(FormatNames)
+        {
+            const SYSTEMTIME dates[] = { { 2020, 1, 3, 1 }, { 2021, 2, 0, 28 }, { 1999, 12, 5, 31 }, { 2024, 2, 4, 29 }, { 2023, 6, 6, 17 } };
+            for (const auto& fileTime : dates)
+            {
+                std::wstring expected = FormatDateName(fileTime, L"MMMM") + L"-" + FormatDateName(fileTime, L"MMM") + L"-" + FormatDateName(fileTime, L"dddd") + L"-" + FormatDateName(fileTime, L"ddd");
+                Assert::AreEqual(expected, Format(L"$MMMM-$MMM-$DDDD-$DDD", fileTime));
+            }
+
+            // GetDateFormatEx fails on invalid dates
+            Assert::AreEqual(std::wstring(L"--"), Format(L"$MMMM-$DDDD-$DDD", SYSTEMTIME{ 2020, 13, 0, 1 }));
+        }
+
+        TEST_METHOD(UsesFileTime)
+        {
+            Assert::IsFalse(CFileTimeTemplate().UsesFileTime());
+            Assert::IsFalse(CFileTimeTemplate(L"").UsesFileTime());
+            Assert::IsFalse(CFileTimeTemplate(L"foo").UsesFileTime());
+            Assert::IsFalse(CFileTimeTemplate(L"$$Y$x").UsesFileTime());
+            Assert::IsTrue(CFileTimeTemplate(L"foo$D").UsesFileTime());
+            Assert::IsTrue(CFileTimeTemplate(L"$$$s").UsesFileTime());
+        }
+
+        TEST_METHOD(FormatReusesOutputBuffer)
+        {
+            CFileTimeTemplate fileTimeTemplate(L"$YYYY$$");
+            std::wstring result = L"previous contents";
+            fileTimeTemplate.Format(SYSTEMTIME{ 2020, 7, 3, 22 }, result);
+            Assert::AreEqual(std::wstring(L"2020$$"), result);
+            fileTimeTemplate.Format(SYSTEMTIME{ 1999, 7, 3, 22 }, result);
+            Assert::AreEqual(std::wstring(L"1999$$"), result);
+        }
+
+        TEST_METHOD(FormatMatchesReferenceImplementation)
+        {
+            SYSTEMTIME fileTime = { 2020, 1, 5, 3, 9, 5, 7, 81 };
+            const std::wstring names[4] = { Format(L"$MMMM", fileTime), Format(L"$MMM", fileTime), Format(L"$DDDD", fileTime), Format(L"$DDD", fileTime) };
+            for (const auto& name : names)
+            {
+                // The regex passes also replaced tokens made by a name following a $
+                if (!name.empty() && wcschr(L"YMDhmsf", name[0]) != nullptr)
+                {
+                    Logger::WriteMessage(L"Date names of the user locale start with a token, skipped");
+                    return;
+                }
+            }
+
+            const wchar_t alphabet[] = { L'$', L'$', L'$', L'Y', L'M', L'D', L'h', L'm', L's', L'f', L'x', L'-' };
+            std::mt19937 random(42);
+            for (int i = 0; i < 2000; i++)
+            {
+                std::wstring replaceTerm;
+                for (size_t length = random() % 12; length > 0; length--)
+                {
+                    replaceTerm += alphabet[random() % ARRAYSIZE(alphabet)];
+                }
+
+                Assert::AreEqual(ReferenceFormat(replaceTerm, fileTime, names), Format(replaceTerm, fileTime));
+            }
+        }
+    };
+}
@@ -0,0 +1,104 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <LiteralMatcher.h>
+#include <algorithm>
+#include <random>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace LiteralMatcherTests
+{
+    // The simple search and replace CPowerRenameRegEx used before CLiteralMatcher.
+    std::wstring ReferenceReplace(std::wstring source, std::wstring searchTerm, std::wstring replaceTerm, bool caseInsensitive, bool allOccurrences)
+    {
+        auto find = [](std::wstring data, std::wstring toSearch, bool ignoreCase, size_t pos) {
+            if (ignoreCase)
+            {
+                std::transform(data.begin(), data.end(), data.begin(), ::towlower);
+                std::transform(toSearch.begin(), toSearch.end(), toSearch.begin(), ::towlower);
+            }
+            return data.find(toSearch, pos);
+        };
+
+        std::wstring res = source;
+        size_t pos = 0;
+        do
+        {
+            pos = find(source, searchTerm, caseInsensitive, pos);
+            if (pos != std::string::npos)
+            {
+                res = source.replace(pos, searchTerm.length(), replaceTerm);
+                pos += replaceTerm.length();
+            }
+
+            if (!allOccurrences)
+            {
+                break;
+            }
+        } while (pos != std::string::npos);
+
+        return res;
+    }
+
+    TEST_CLASS(SimpleTests)
+    {
+    public:
+        TEST_METHOD(FindCaseSensitive)
+        {
+            CLiteralMatcher matcher(L"Foo", true);
+            Assert::AreEqual<size_t>(3, matcher.Find(L"fooFoo"));
+            Assert::AreEqual(std::wstring_view::npos, matcher.Find(L"foofoo"));
+            Assert::AreEqual(std::wstring_view::npos, matcher.Find(L"fooFoo", 4));
+        }
+
+        TEST_METHOD(FindCaseInsensitive)
+        {
+            CLiteralMatcher matcher(L"fOO", false);
+            Assert::AreEqual<size_t>(0, matcher.Find(L"FOOfoo"));
+            Assert::AreEqual<size_t>(3, matcher.Find(L"FOOfoo", 1));
+            // Long enough to go through the vectorized scan, with the match in the scalar tail
+            Assert::AreEqual<size_t>(20, matcher.Find(L"aaaaaaaaaaaaaaaaaaaaFoO"));
+            Assert::AreEqual<size_t>(9, matcher.Find(L"\u00C9\u00E9\u00C9\u00E9\u00C9\u00E9\u00C9\u00E9.foo\u00C9\u00E9\u00C9\u00E9\u00C9\u00E9"));
+        }
+
+        TEST_METHOD(ReplaceReusesOutputBuffer)
+        {
+            CLiteralMatcher matcher(L"foo", false);
+            std::wstring result = L"previous contents";
+            Assert::IsTrue(matcher.Replace(L"FooBarFOO", L"x", true, result));
+            Assert::AreEqual(std::wstring(L"xBarx"), result);
+            Assert::IsTrue(matcher.Replace(L"FooBarFOO", L"x", false, result));
+            Assert::AreEqual(std::wstring(L"xBarFOO"), result);
+            Assert::IsFalse(matcher.Replace(L"bar", L"x", true, result));
+            Assert::AreEqual(std::wstring(L"bar"), result);
+        }
+
+        TEST_METHOD(ReplaceMatchesReferenceImplementation)
+        {
+            const wchar_t alphabet[] = { L'a', L'A', L'b', L'B', L'.', L' ', L'\u00C9', L'\u00E9', L'\u0130', L'i', L'I' };
+            std::mt19937 random(42);
+            auto randomString = [&](size_t length) {
+                std::wstring s;
+                for (size_t i = 0; i < length; i++)
+                {
+                    s += alphabet[random() % ARRAYSIZE(alphabet)];
+                }
+                return s;
+            };
+
+            std::wstring result;
+            for (int i = 0; i < 20000; i++)
+            {
+                std::wstring source = randomString(random() % 48);
+                std::wstring searchTerm = randomString(1 + random() % 3);
+                std::wstring replaceTerm = randomString(random() % 4);
+                bool caseInsensitive = random() % 2 == 0;
+                bool allOccurrences = random() % 2 == 0;
+
+                CLiteralMatcher matcher(searchTerm, !caseInsensitive);
+                matcher.Replace(source, replaceTerm, allOccurrences, result);
+                Assert::AreEqual(ReferenceReplace(source, searchTerm, replaceTerm, caseInsensitive, allOccurrences), result);
+            }
+        }
+    };
+}
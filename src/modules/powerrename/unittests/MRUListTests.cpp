@@ -0,0 +1,143 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "TestFileHelper.h"
+#include <MRUJournal.h>
+#include <MRUList.h>
+#include <fstream>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace MRUListTests
+{
+    std::vector<std::wstring> Items(const CMRUList& list)
+    {
+        return { list.Items().begin(), list.Items().end() };
+    }
+
+    std::string Encode(const std::vector<std::wstring>& items)
+    {
+        std::string contents;
+        std::string record;
+        for (const auto& item : items)
+        {
+            CMRUJournal::EncodeRecord(item, record);
+            contents += record;
+        }
+        return contents;
+    }
+
+    std::vector<std::wstring> Replay(std::string_view contents)
+    {
+        std::vector<std::wstring> items;
+        CMRUJournal::Replay(contents, [&](std::wstring_view item) { items.emplace_back(item); });
+        return items;
+    }
+
+    TEST_CLASS(SimpleTests)
+    {
+    public:
+        TEST_METHOD(PushMovesExistingItemsToFront)
+        {
+            CMRUList list(3);
+            list.Push(L"a");
+            list.Push(L"b");
+            list.Push(L"c");
+            Assert::IsTrue(Items(list) == std::vector<std::wstring>{ L"c", L"b", L"a" });
+
+            list.Push(L"a");
+            Assert::IsTrue(Items(list) == std::vector<std::wstring>{ L"a", L"c", L"b" });
+            Assert::IsTrue(list.Contains(L"b"));
+            Assert::IsFalse(list.Contains(L"B"));
+        }
+
+        TEST_METHOD(PushDropsLeastRecentlyUsedItem)
+        {
+            CMRUList list(2);
+            list.Push(L"a");
+            list.Push(L"b");
+            list.Push(L"a");
+            list.Push(L"c");
+            Assert::IsTrue(Items(list) == std::vector<std::wstring>{ L"c", L"a" });
+            Assert::IsFalse(list.Contains(L"b"));
+
+            CMRUList empty(0);
+            empty.Push(L"a");
+            Assert::AreEqual(static_cast<size_t>(0), empty.Size());
+        }
+
+        TEST_METHOD(PushKeepsIndexAcrossReordering)
+        {
+            // Moving the least recently used item to the front must keep it from being the next one dropped
+            CMRUList list(3);
+            list.Push(L"a");
+            list.Push(L"b");
+            list.Push(L"c");
+            list.Push(L"a");
+            list.Push(L"d");
+            Assert::IsTrue(Items(list) == std::vector<std::wstring>{ L"d", L"a", L"c" });
+
+            // An item pushed again after being dropped is added back instead of found in a stale index entry
+            list.Push(L"b");
+            Assert::IsTrue(Items(list) == std::vector<std::wstring>{ L"b", L"d", L"a" });
+            Assert::IsFalse(list.Contains(L"c"));
+
+            list.Clear();
+            Assert::IsFalse(list.Contains(L"a"));
+            list.Push(L"a");
+            Assert::IsTrue(Items(list) == std::vector<std::wstring>{ L"a" });
+        }
+
+        TEST_METHOD(JournalRoundTrip)
+        {
+            const std::vector<std::wstring> items = { L"foo", L"", L"line\nbreak", L"12:34", L"\u00E9t\u00E9 \u65E5\u672C" };
+            Assert::IsTrue(items == Replay(Encode(items)));
+        }
+
+        TEST_METHOD(JournalDropsTornRecords)
+        {
+            const std::vector<std::wstring> items = { L"foo", L"bar", L"\u00E9t\u00E9" };
+            const std::string contents = Encode(items);
+            const std::string lastRecord = Encode({ items.back() });
+
+            // A crash can stop a write anywhere in the last record
+            for (size_t length = contents.size() - lastRecord.size(); length < contents.size(); length++)
+            {
+                Assert::IsTrue(std::vector<std::wstring>{ L"foo", L"bar" } == Replay(std::string_view(contents).substr(0, length)));
+            }
+
+            // Garbage instead of the record, like zeros left by an interrupted extension of the file
+            Assert::IsTrue(std::vector<std::wstring>{ L"foo" } == Replay(Encode({ L"foo" }) + std::string(6, '\0') + Encode({ L"bar" })));
+            Assert::IsTrue(std::vector<std::wstring>{ L"foo" } == Replay(Encode({ L"foo" }) + "9:bar\n"));
+        }
+
+        TEST_METHOD(JournalFileRecovery)
+        {
+            CTestFileHelper testFileHelper;
+            const std::wstring journalPath = testFileHelper.GetFullPath(L"search-mru.json.journal");
+
+            {
+                CMRUJournal journal(journalPath);
+                for (auto item : { L"a", L"b", L"c", L"a" })
+                {
+                    Assert::IsTrue(journal.Append(item));
+                }
+            }
+
+            // Torn record at the end of the file
+            {
+                std::ofstream file(journalPath, std::ios::binary | std::ios::app);
+                file << "5:ab";
+            }
+
+            CMRUList list(2);
+            Assert::AreEqual(static_cast<size_t>(4), CMRUJournal::ReplayFile(journalPath, [&](std::wstring_view item) { list.Push(item); }));
+            Assert::IsTrue(Items(list) == std::vector<std::wstring>{ L"a", L"c" });
+
+            // Replaying a journal again over the state it produced doesn't change it
+            CMRUJournal::ReplayFile(journalPath, [&](std::wstring_view item) { list.Push(item); });
+            Assert::IsTrue(Items(list) == std::vector<std::wstring>{ L"a", L"c" });
+
+            Assert::AreEqual(static_cast<size_t>(0), CMRUJournal::ReplayFile(testFileHelper.GetFullPath(L"missing.journal"), [](std::wstring_view) {}));
+        }
+    };
+}
@@ -33,3 +33,9 @@ void CMockPowerRenameItem::Init(_In_opt_ PCWSTR path, _In_opt_ PCWSTR originalNa
     m_time = time;
     m_isTimeParsed = true;
 }
+
+IFACEMETHODIMP CMockPowerRenameItem::PutNewName(_In_opt_ PCWSTR newName)
+{
+    m_newNameUpdates++;
+    return CPowerRenameItem::PutNewName(newName);
+}
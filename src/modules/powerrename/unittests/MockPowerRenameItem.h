@@ -2,6 +2,7 @@
 #include "pch.h"
 #include <PowerRenameItem.h>
 #include "srwlock.h"
+#include <atomic>
 
 class CMockPowerRenameItem :
     public CPowerRenameItem
@@ -9,4 +10,9 @@ class CMockPowerRenameItem :
 public:
     static HRESULT CreateInstance(_In_opt_ PCWSTR path, _In_opt_ PCWSTR originalName, _In_ UINT depth, _In_ bool isFolder, _In_ SYSTEMTIME time, _Outptr_ IPowerRenameItem** ppItem);
     void Init(_In_opt_ PCWSTR path, _In_opt_ PCWSTR originalName, _In_ UINT depth, _In_ bool isFolder, _In_ SYSTEMTIME time);
+
+    IFACEMETHODIMP PutNewName(_In_opt_ PCWSTR newName);
+
+    // Number of times a preview pass has set the new name of this item
+    std::atomic<int> m_newNameUpdates = 0;
 };
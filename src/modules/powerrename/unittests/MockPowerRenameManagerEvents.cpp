@@ -56,6 +56,7 @@ IFACEMETHODIMP CMockPowerRenameManagerEvents::OnError(_In_ IPowerRenameItem* pIt
 IFACEMETHODIMP CMockPowerRenameManagerEvents::OnRegExStarted(_In_ DWORD threadId)
 {
     m_regExStarted = true;
+    m_regExStartedCount++;
     return S_OK;
 }
 
@@ -68,6 +69,7 @@ IFACEMETHODIMP CMockPowerRenameManagerEvents::OnRegExCanceled(_In_ DWORD threadI
 IFACEMETHODIMP CMockPowerRenameManagerEvents::OnRegExCompleted(_In_ DWORD threadId)
 {
     m_regExCompleted = true;
+    m_regExCompletedCount++;
     return S_OK;
 }
 
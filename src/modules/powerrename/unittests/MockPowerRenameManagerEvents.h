@@ -39,6 +39,8 @@ public:
     bool m_regExStarted = false;
     bool m_regExCanceled = false;
     bool m_regExCompleted = false;
+    int m_regExStartedCount = 0;
+    int m_regExCompletedCount = 0;
     bool m_renameStarted = false;
     bool m_renameCompleted = false;
     bool m_closeUIWindowAfterRenaming = false;
@@ -0,0 +1,123 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <PowerRenameInterfaces.h>
+#include <PowerRenameEnum.h>
+#include <PowerRenameItem.h>
+#include <PowerRenameManager.h>
+#include <ShlGuid.h>
+#include "TestFileHelper.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace PowerRenameEnumTests
+{
+    // Fails to start any thread, like a process out of resources would
+    class CNoThreadsRenameEnum : public CPowerRenameEnum
+    {
+    public:
+        CNoThreadsRenameEnum(IPowerRenameManager* manager, int& threadStarts) :
+            m_threadStarts(threadStarts)
+        {
+            _Init(nullptr, manager);
+        }
+
+    protected:
+        std::thread _StartPrefetchThread(std::function<void()>) override
+        {
+            m_threadStarts++;
+            throw std::system_error(std::make_error_code(std::errc::resource_unavailable_try_again));
+        }
+
+        int& m_threadStarts;
+    };
+
+    TEST_CLASS(SimpleTests)
+    {
+        static CComPtr<IPowerRenameEnum> CreateRenameEnum(IPowerRenameManager* manager)
+        {
+            CComPtr<IPowerRenameEnum> renameEnum;
+            Assert::IsTrue(CPowerRenameEnum::s_CreateInstance(nullptr, manager, IID_PPV_ARGS(&renameEnum)) == S_OK);
+            return renameEnum;
+        }
+
+        static void VerifyEnumeration(const std::function<CComPtr<IPowerRenameEnum>(IPowerRenameManager* manager)>& createRenameEnum)
+        {
+            HRESULT hrCoInit = CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED);
+
+            CTestFileHelper testFileHelper;
+            Assert::IsTrue(testFileHelper.AddFolder(L"b"));
+            Assert::IsTrue(testFileHelper.AddFolder(L"a10"));
+            Assert::IsTrue(testFileHelper.AddFolder(L"a10\\sub"));
+            Assert::IsTrue(testFileHelper.AddFile(L"a10\\sub\\y.txt"));
+            Assert::IsTrue(testFileHelper.AddFolder(L"a2"));
+            Assert::IsTrue(testFileHelper.AddFile(L"a2\\x.txt"));
+            Assert::IsTrue(testFileHelper.AddFile(L"c.txt"));
+            Assert::IsTrue(testFileHelper.AddFile(L"A.txt"));
+
+            CComPtr<IPowerRenameManager> mgr;
+            Assert::IsTrue(CPowerRenameManager::s_CreateInstance(&mgr) == S_OK);
+            CComPtr<IPowerRenameItemFactory> itemFactory;
+            Assert::IsTrue(CPowerRenameItem::s_CreateInstance(nullptr, IID_PPV_ARGS(&itemFactory)) == S_OK);
+            Assert::IsTrue(mgr->PutRenameItemFactory(itemFactory) == S_OK);
+
+            CComPtr<IShellItem> folder;
+            Assert::IsTrue(SHCreateItemFromParsingName(testFileHelper.GetTempDirectory().c_str(), nullptr, IID_PPV_ARGS(&folder)) == S_OK);
+            CComPtr<IEnumShellItems> enumShellItems;
+            Assert::IsTrue(folder->BindToHandler(nullptr, BHID_EnumItems, IID_PPV_ARGS(&enumShellItems)) == S_OK);
+
+            CComPtr<IPowerRenameEnum> renameEnum = createRenameEnum(mgr);
+            Assert::IsTrue(renameEnum->Start(enumShellItems) == S_OK);
+
+            const std::pair<std::wstring, UINT> expected[] = {
+                { L"a2", 0 },
+                { L"x.txt", 1 },
+                { L"a10", 0 },
+                { L"sub", 1 },
+                { L"y.txt", 2 },
+                { L"b", 0 },
+                { L"A.txt", 0 },
+                { L"c.txt", 0 },
+            };
+
+            UINT itemCount = 0;
+            Assert::IsTrue(mgr->GetItemCount(&itemCount) == S_OK);
+            Assert::AreEqual<UINT>(ARRAYSIZE(expected), itemCount);
+            for (UINT i = 0; i < itemCount; i++)
+            {
+                CComPtr<IPowerRenameItem> item;
+                Assert::IsTrue(mgr->GetItemByIndex(i, &item) == S_OK);
+                PWSTR originalName = nullptr;
+                Assert::IsTrue(item->GetOriginalName(&originalName) == S_OK);
+                Assert::AreEqual(expected[i].first, std::wstring(originalName));
+                CoTaskMemFree(originalName);
+                UINT depth = 0;
+                Assert::IsTrue(item->GetDepth(&depth) == S_OK);
+                Assert::AreEqual(expected[i].second, depth);
+            }
+
+            Assert::IsTrue(mgr->Shutdown() == S_OK);
+            if (SUCCEEDED(hrCoInit))
+            {
+                CoUninitialize();
+            }
+        }
+
+    public:
+        TEST_METHOD(EnumeratesFoldersDepthFirstInDisplayOrder)
+        {
+            VerifyEnumeration(CreateRenameEnum);
+        }
+
+        TEST_METHOD(EnumeratesFoldersWithoutPrefetchThreads)
+        {
+            // Every folder is read by the enumerating thread when it gets to it
+            int threadStarts = 0;
+            VerifyEnumeration([&](IPowerRenameManager* manager) {
+                CComPtr<IPowerRenameEnum> renameEnum;
+                renameEnum.Attach(new CNoThreadsRenameEnum(manager, threadStarts));
+                return renameEnum;
+            });
+            Assert::IsTrue(threadStarts > 0);
+        }
+    };
+}
@@ -7,6 +7,7 @@
 #include "MockPowerRenameManagerEvents.h"
 #include "TestFileHelper.h"
 #include "Helpers.h"
+#include <algorithm>
 
 #define DEFAULT_FLAGS MatchAllOccurences
 
@@ -23,6 +24,28 @@ namespace PowerRenameManagerTests
     TEST_CLASS(SimpleTests)
     {
     public:
+        // Pump the messages the regex worker posts until the given number of preview passes are done
+        static void WaitForRegExPasses(CMockPowerRenameManagerEvents* mockMgrEvents, int passes)
+        {
+            for (int step = 0; step < 500 && mockMgrEvents->m_regExCompletedCount < passes; step++)
+            {
+                MSG msg;
+                while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE))
+                {
+                    TranslateMessage(&msg);
+                    DispatchMessage(&msg);
+                }
+
+                if (mockMgrEvents->m_regExCompletedCount < passes)
+                {
+                    Sleep(10);
+                }
+            }
+
+            Assert::AreEqual(passes, mockMgrEvents->m_regExStartedCount);
+            Assert::AreEqual(passes, mockMgrEvents->m_regExCompletedCount);
+        }
+
         struct rename_pairs
         {
             std::wstring originalName;
@@ -32,7 +55,7 @@ namespace PowerRenameManagerTests
             int depth;
         };
 
-        void RenameHelper(_In_ rename_pairs * renamePairs, _In_ int numPairs, _In_ std::wstring searchTerm, _In_ std::wstring replaceTerm, SYSTEMTIME fileTime, _In_ DWORD flags)
+        void RenameHelper(_In_ rename_pairs * renamePairs, _In_ int numPairs, _In_ std::wstring searchTerm, _In_ std::wstring replaceTerm, SYSTEMTIME fileTime, _In_ DWORD flags, _In_ std::vector<std::wstring> typedSearchTerms = {}, _In_ std::vector<std::wstring> skippedNames = {})
         {
             // Create a single item (in a temp directory) and verify rename works as expected
             CTestFileHelper testFileHelper;
@@ -56,6 +79,7 @@ namespace PowerRenameManagerTests
             DWORD cookie = 0;
             Assert::IsTrue(mgr->Advise(mgrEvents, &cookie) == S_OK);
 
+            std::vector<CComPtr<IPowerRenameItem>> items;
             for (int i = 0; i < numPairs; i++)
             {
                 CComPtr<IPowerRenameItem> item;
@@ -69,6 +93,7 @@ namespace PowerRenameManagerTests
                 int itemId = 0;
                 Assert::IsTrue(item->GetId(&itemId) == S_OK);
                 mgr->AddItem(item);
+                items.push_back(item);
 
                 // Verify the item we added is the same from the event
                 Assert::IsTrue(mockMgrEvents->m_itemAdded != nullptr && mockMgrEvents->m_itemAdded == item);
@@ -81,9 +106,47 @@ namespace PowerRenameManagerTests
             wchar_t newReplaceTerm[MAX_PATH] = { 0 };
             CComPtr<IPowerRenameRegEx> renRegEx;
             Assert::IsTrue(mgr->GetRenameRegEx(&renRegEx) == S_OK);
+            DWORD previousFlags = 0;
+            renRegEx->GetFlags(&previousFlags);
             renRegEx->PutFlags(flags);
-            renRegEx->PutSearchTerm(searchTerm.c_str());
-            renRegEx->PutReplaceTerm(replaceTerm.c_str());
+            if (typedSearchTerms.empty())
+            {
+                renRegEx->PutSearchTerm(searchTerm.c_str());
+                renRegEx->PutReplaceTerm(replaceTerm.c_str());
+            }
+            else
+            {
+                // Every change starts one preview pass
+                int passes = previousFlags != flags ? 1 : 0;
+                renRegEx->PutReplaceTerm(replaceTerm.c_str(), true);
+                WaitForRegExPasses(mockMgrEvents, ++passes);
+                mockMgrEvents->m_regExCanceled = false;
+
+                // Simulate the search term being typed one step at a time, letting each preview finish
+                for (const auto& typedSearchTerm : typedSearchTerms)
+                {
+                    renRegEx->PutSearchTerm(typedSearchTerm.c_str());
+                    WaitForRegExPasses(mockMgrEvents, ++passes);
+                }
+
+                std::vector<int> newNameUpdates;
+                for (const auto& item : items)
+                {
+                    newNameUpdates.push_back(static_cast<CMockPowerRenameItem*>(item.p)->m_newNameUpdates);
+                }
+
+                renRegEx->PutSearchTerm(searchTerm.c_str());
+                WaitForRegExPasses(mockMgrEvents, ++passes);
+                Assert::IsFalse(mockMgrEvents->m_regExCanceled);
+
+                // Items the previous term didn't match aren't looked at again, all others are
+                for (int i = 0; i < numPairs; i++)
+                {
+                    const bool skipped = std::find(skippedNames.begin(), skippedNames.end(), renamePairs[i].originalName) != skippedNames.end();
+                    const bool updated = static_cast<CMockPowerRenameItem*>(items[i].p)->m_newNameUpdates > newNameUpdates[i];
+                    Assert::IsTrue(updated == !skipped);
+                }
+            }
 
             // Perform the rename
             bool replaceSuccess = false;
@@ -183,6 +246,20 @@ namespace PowerRenameManagerTests
             RenameHelper(renamePairs, ARRAYSIZE(renamePairs), L"foo", L"bar", SYSTEMTIME{ 2020, 7, 3, 22, 15, 6, 42, 453 }, DEFAULT_FLAGS);
         }
 
+        TEST_METHOD(VerifyExtendedSearchTermRename)
+        {
+            // Verify items that stopped matching while the search term was typed are not renamed,
+            // and that items which didn't match the shorter term are skipped when it's extended
+            rename_pairs renamePairs[] = {
+                { L"foo1.txt", L"bar1.txt", true, true, 0 },
+                { L"FOO2.txt", L"bar2.txt", true, true, 0 },
+                { L"fob.txt", L"fob_norename.txt", true, false, 0 },
+                { L"baa.txt", L"baa_norename.txt", true, false, 0 }
+            };
+
+            RenameHelper(renamePairs, ARRAYSIZE(renamePairs), L"foo", L"bar", SYSTEMTIME{ 2020, 7, 3, 22, 15, 6, 42, 453 }, DEFAULT_FLAGS, { L"f", L"fo" }, { L"baa.txt" });
+        }
+
         TEST_METHOD(VerifyFilesOnlyRename)
         {
             // Verify only files are renamed when folders match too
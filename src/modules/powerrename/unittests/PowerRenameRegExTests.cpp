@@ -490,6 +490,115 @@ TEST_METHOD(VerifyLookbehindFails)
     }
 }
 
+TEST_METHOD(VerifyReplaceBatchMatchesReplace)
+{
+    CComPtr<IPowerRenameRegEx> renameRegEx;
+    Assert::IsTrue(CPowerRenameRegEx::s_CreateInstance(&renameRegEx) == S_OK);
+    Assert::IsTrue(renameRegEx->PutFlags(MatchAllOccurences | UseRegularExpressions) == S_OK);
+    Assert::IsTrue(renameRegEx->PutSearchTerm(L"(\\d+)") == S_OK);
+    Assert::IsTrue(renameRegEx->PutReplaceTerm(L"[$1]_$YYYY-$MM") == S_OK);
+
+    // Enough items to be split across several worker threads, each with its own file time
+    std::vector<std::wstring> names;
+    std::vector<PCWSTR> sources;
+    std::vector<SYSTEMTIME> fileTimes;
+    for (int i = 0; i < 2000; i++)
+    {
+        names.push_back(i % 100 == 0 ? L"" : L"file" + std::to_wstring(i) + L"_copy" + std::to_wstring(i % 7) + L".txt");
+        fileTimes.push_back(SYSTEMTIME{ static_cast<WORD>(2000 + i % 30), static_cast<WORD>(1 + i % 12), 0, 1, 0, 0, 0, 0 });
+    }
+    for (const auto& name : names)
+    {
+        sources.push_back(name.c_str());
+    }
+
+    std::vector<PWSTR> results(names.size());
+    Assert::IsTrue(renameRegEx->ReplaceBatch(static_cast<UINT>(names.size()), sources.data(), fileTimes.data(), results.data()) == S_OK);
+
+    for (size_t i = 0; i < names.size(); i++)
+    {
+        PWSTR result = nullptr;
+        Assert::IsTrue(renameRegEx->PutFileTime(fileTimes[i]) == S_OK);
+        Assert::IsTrue(renameRegEx->Replace(sources[i], &result) == S_OK);
+        Assert::IsTrue(renameRegEx->ResetFileTime() == S_OK);
+        if (names[i].empty())
+        {
+            Assert::IsTrue(result == nullptr && results[i] == nullptr);
+        }
+        else
+        {
+            Assert::IsTrue(wcscmp(result, results[i]) == 0);
+        }
+        CoTaskMemFree(result);
+        CoTaskMemFree(results[i]);
+    }
+
+    // Without file times the replace term is used as it is, like Replace does once the file time is reset
+    PWSTR result = nullptr;
+    PWSTR expected = nullptr;
+    Assert::IsTrue(renameRegEx->ReplaceBatch(1, sources.data() + 1, nullptr, &result) == S_OK);
+    Assert::IsTrue(renameRegEx->Replace(sources[1], &expected) == S_OK);
+    Assert::IsTrue(wcscmp(expected, result) == 0);
+    CoTaskMemFree(expected);
+    CoTaskMemFree(result);
+}
+
+TEST_METHOD(VerifyReplaceBatchInvalidRegexFails)
+{
+    CComPtr<IPowerRenameRegEx> renameRegEx;
+    Assert::IsTrue(CPowerRenameRegEx::s_CreateInstance(&renameRegEx) == S_OK);
+    Assert::IsTrue(renameRegEx->PutFlags(UseRegularExpressions) == S_OK);
+    Assert::IsTrue(renameRegEx->PutSearchTerm(L"[") == S_OK);
+
+    PCWSTR sources[] = { L"foo", L"bar" };
+    PWSTR results[ARRAYSIZE(sources)] = {};
+    Assert::IsTrue(renameRegEx->ReplaceBatch(ARRAYSIZE(sources), sources, nullptr, results) == E_FAIL);
+    Assert::IsTrue(results[0] == nullptr && results[1] == nullptr);
+}
+
+TEST_METHOD(VerifyCompiledPatternInvalidated)
+{
+    CComPtr<IPowerRenameRegEx> renameRegEx;
+    Assert::IsTrue(CPowerRenameRegEx::s_CreateInstance(&renameRegEx) == S_OK);
+
+    auto replace = [&](PCWSTR source) {
+        PWSTR result = nullptr;
+        Assert::IsTrue(renameRegEx->Replace(source, &result) == S_OK);
+        std::wstring replaced{ result ? result : L"" };
+        CoTaskMemFree(result);
+        return replaced;
+    };
+
+    // Each replace uses the pattern compiled for the one before it unless the change invalidates it
+    Assert::IsTrue(renameRegEx->PutFlags(MatchAllOccurences | UseRegularExpressions) == S_OK);
+    Assert::IsTrue(renameRegEx->PutSearchTerm(L"o") == S_OK);
+    Assert::IsTrue(renameRegEx->PutReplaceTerm(L"0") == S_OK);
+    Assert::AreEqual(std::wstring(L"f00"), replace(L"foo"));
+
+    Assert::IsTrue(renameRegEx->PutSearchTerm(L"f") == S_OK);
+    Assert::AreEqual(std::wstring(L"0oo"), replace(L"foo"));
+
+    Assert::IsTrue(renameRegEx->PutReplaceTerm(L"F") == S_OK);
+    Assert::AreEqual(std::wstring(L"Foo"), replace(L"foo"));
+
+    Assert::IsTrue(renameRegEx->PutSearchTerm(L"o") == S_OK);
+    Assert::AreEqual(std::wstring(L"fFF"), replace(L"foo"));
+
+    Assert::IsTrue(renameRegEx->PutFlags(UseRegularExpressions) == S_OK);
+    Assert::AreEqual(std::wstring(L"fFo"), replace(L"foo"));
+
+    Assert::IsTrue(renameRegEx->PutReplaceTerm(L"$YYYY") == S_OK);
+    const std::wstring undated = replace(L"foo");
+    Assert::IsTrue(renameRegEx->PutFileTime(SYSTEMTIME{ 2020, 7, 3, 22, 15, 6, 42, 453 }) == S_OK);
+    Assert::AreEqual(std::wstring(L"f2020o"), replace(L"foo"));
+
+    Assert::IsTrue(renameRegEx->PutFileTime(SYSTEMTIME{ 2021, 7, 3, 22, 15, 6, 42, 453 }) == S_OK);
+    Assert::AreEqual(std::wstring(L"f2021o"), replace(L"foo"));
+
+    Assert::IsTrue(renameRegEx->ResetFileTime() == S_OK);
+    Assert::AreEqual(undated, replace(L"foo"));
+}
+
 TEST_METHOD(VerifyEventsFire)
 {
     CComPtr<IPowerRenameRegEx> renameRegEx;
@@ -0,0 +1,121 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <RenameExecutor.h>
+#include <map>
+#include <mutex>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace RenameExecutorTests
+{
+    // Records renames in memory and fails if an item is renamed after the folder containing it.
+    class FakeRenameBackend : public IRenameBackend
+    {
+    public:
+        explicit FakeRenameBackend(bool concurrent) :
+            m_concurrent(concurrent)
+        {
+        }
+
+        HRESULT Rename(const RenameEntry& entry) override
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (const auto& [path, name] : renamed)
+            {
+                if (entry.path.starts_with(path + L"\\"))
+                {
+                    return E_FAIL;
+                }
+            }
+
+            renamed.emplace(entry.path, entry.newName);
+            return entry.newName == L"fail" ? E_ACCESSDENIED : S_OK;
+        }
+
+        bool CanRenameConcurrently() const override { return m_concurrent; }
+
+        std::map<std::wstring, std::wstring> renamed;
+
+    private:
+        std::mutex m_mutex;
+        bool m_concurrent;
+    };
+
+    RenameEntry Entry(UINT depth, const std::wstring& path, const std::wstring& newName = L"")
+    {
+        RenameEntry entry;
+        entry.depth = depth;
+        entry.path = path;
+        entry.originalName = path.substr(path.find_last_of(L'\\') + 1);
+        entry.newName = newName;
+        return entry;
+    }
+
+    TEST_CLASS(SimpleTests)
+    {
+    public:
+        TEST_METHOD(ChildrenAreRenamedBeforeParents)
+        {
+            CRenameExecutor executor({ Entry(0, L"c:\\a", L"x"),
+                                       Entry(1, L"c:\\a\\b", L"y"),
+                                       Entry(2, L"c:\\a\\b\\c.txt", L"z.txt"),
+                                       Entry(0, L"c:\\d.txt") });
+
+            FakeRenameBackend backend(false);
+            Assert::AreEqual(S_OK, executor.Execute(backend));
+            Assert::AreEqual<size_t>(3, backend.renamed.size());
+        }
+
+        TEST_METHOD(RenamedPathsFollowRenamedParents)
+        {
+            CRenameExecutor executor({ Entry(0, L"c:\\a", L"x"),
+                                       Entry(1, L"c:\\a\\b"),
+                                       Entry(2, L"c:\\a\\b\\c.txt", L"z.txt"),
+                                       Entry(1, L"c:\\a\\e.txt"),
+                                       Entry(0, L"c:\\d.txt", L"f.txt") });
+
+            Assert::AreEqual<size_t>(0, executor.GetParentIndex(1));
+            Assert::AreEqual<size_t>(1, executor.GetParentIndex(2));
+            Assert::AreEqual(CRenameExecutor::npos, executor.GetParentIndex(4));
+
+            std::vector<std::wstring> paths = executor.GetRenamedPaths();
+            Assert::AreEqual(std::wstring(L"c:\\x"), paths[0]);
+            Assert::AreEqual(std::wstring(L"c:\\x\\b"), paths[1]);
+            Assert::AreEqual(std::wstring(L"c:\\x\\b\\z.txt"), paths[2]);
+            Assert::AreEqual(std::wstring(L"c:\\x\\e.txt"), paths[3]);
+            Assert::AreEqual(std::wstring(L"c:\\f.txt"), paths[4]);
+        }
+
+        TEST_METHOD(ConcurrentBackendKeepsDepthOrder)
+        {
+            std::vector<RenameEntry> entries;
+            for (int i = 0; i < 50; i++)
+            {
+                std::wstring folder = L"c:\\folder" + std::to_wstring(i);
+                entries.push_back(Entry(0, folder, L"renamed" + std::to_wstring(i)));
+                for (int j = 0; j < 20; j++)
+                {
+                    entries.push_back(Entry(1, folder + L"\\file" + std::to_wstring(j) + L".txt", L"new" + std::to_wstring(j) + L".txt"));
+                }
+            }
+
+            CRenameExecutor executor(entries);
+            FakeRenameBackend backend(true);
+            Assert::AreEqual(S_OK, executor.Execute(backend));
+            Assert::AreEqual(entries.size(), backend.renamed.size());
+
+            std::vector<std::wstring> paths = executor.GetRenamedPaths();
+            Assert::AreEqual(std::wstring(L"c:\\renamed49\\new19.txt"), paths.back());
+        }
+
+        TEST_METHOD(FailureDoesNotStopBatch)
+        {
+            CRenameExecutor executor({ Entry(0, L"c:\\a.txt", L"fail"),
+                                       Entry(0, L"c:\\b.txt", L"c.txt") });
+
+            FakeRenameBackend backend(false);
+            Assert::AreEqual(E_ACCESSDENIED, executor.Execute(backend));
+            Assert::AreEqual<size_t>(2, backend.renamed.size());
+        }
+    };
+}
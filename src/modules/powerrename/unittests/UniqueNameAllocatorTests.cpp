@@ -0,0 +1,197 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <UniqueNameAllocator.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <set>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UniqueNameAllocatorTests
+{
+    std::wstring ToUpper(std::wstring name)
+    {
+        std::transform(name.begin(), name.end(), name.begin(), ::towupper);
+        return name;
+    }
+
+    // The probing GetEnumeratedFileName made before CUniqueNameAllocator, without a directory and with taken
+    // holding the uppercased names PathFileExists found.
+    bool ReferenceEnumerate(const std::wstring& nameTemplate, unsigned long minNumber, std::set<std::wstring>& taken, std::wstring& result)
+    {
+        wchar_t uniqueName[MAX_PATH] = { 0 };
+        PCWSTR rest = StrChr(nameTemplate.c_str(), L'(');
+        while (rest)
+        {
+            PCWSTR endUniq = rest + 1;
+            while (*endUniq >= L'0' && *endUniq <= L'9')
+            {
+                endUniq++;
+            }
+            if (*endUniq == L')')
+            {
+                break;
+            }
+            rest = StrChr(rest + 1, L'(');
+        }
+
+        const wchar_t* format = L"%lu";
+        size_t stemLength = 0;
+        if (!rest)
+        {
+            rest = PathFindExtension(nameTemplate.c_str());
+            stemLength = rest - nameTemplate.c_str();
+            format = L" (%lu)";
+        }
+        else
+        {
+            rest++;
+            stemLength = rest - nameTemplate.c_str();
+            while (*rest >= L'0' && *rest <= L'9')
+            {
+                rest++;
+            }
+        }
+
+        const int digitsRoom = MAX_PATH - static_cast<int>(stemLength) - (lstrlen(format) - 3);
+        const unsigned long maxNumber = digitsRoom <= 0 ? minNumber : digitsRoom >= 6 ? 1000000 : static_cast<unsigned long>(pow(10, digitsRoom));
+        for (unsigned long number = minNumber; number < maxNumber; number++)
+        {
+            wchar_t digits[MAX_PATH];
+            StringCchPrintf(digits, ARRAYSIZE(digits), format, number);
+            const std::wstring name = nameTemplate.substr(0, stemLength) + digits + rest;
+            if (name.size() < ARRAYSIZE(uniqueName) && taken.insert(ToUpper(name)).second)
+            {
+                result = name;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    TEST_CLASS(SimpleTests)
+    {
+    public:
+        TEST_METHOD(EnumeratesTemplates)
+        {
+            // Items without a directory only avoid the names handed out before, there is nothing to list
+            CUniqueNameAllocator allocator([](const std::wstring&, std::vector<std::wstring>&) { Assert::Fail(); });
+            std::wstring result;
+            unsigned long numberUsed = 0;
+
+            Assert::IsTrue(allocator.Allocate(L"foo.txt", L"", 1, MAX_PATH, result, numberUsed));
+            Assert::AreEqual(std::wstring(L"foo (1).txt"), result);
+            Assert::IsTrue(numberUsed == 1);
+            Assert::IsTrue(allocator.Allocate(L"bar (7).txt", L"", 2, MAX_PATH, result, numberUsed));
+            Assert::AreEqual(std::wstring(L"bar (2).txt"), result);
+            Assert::IsTrue(allocator.Allocate(L"a()", L"", 3, MAX_PATH, result, numberUsed));
+            Assert::AreEqual(std::wstring(L"a(3)"), result);
+            Assert::IsTrue(allocator.Allocate(L"foo.bar baz", L"", 4, MAX_PATH, result, numberUsed));
+            Assert::AreEqual(std::wstring(L"foo.bar baz (4)"), result);
+            Assert::IsTrue(allocator.Allocate(L".gitignore", L"", 5, MAX_PATH, result, numberUsed));
+            Assert::AreEqual(std::wstring(L" (5).gitignore"), result);
+        }
+
+        TEST_METHOD(SkipsTakenNames)
+        {
+            int listed = 0;
+            CUniqueNameAllocator allocator([&](const std::wstring& directory, std::vector<std::wstring>& names) {
+                listed++;
+                Assert::AreEqual(std::wstring(L"C:\\photos"), directory);
+                names = { L"foo (1).txt", L"FOO (2).TXT", L"foo (4).txt" };
+            });
+            std::wstring result;
+            unsigned long numberUsed = 0;
+
+            Assert::IsTrue(allocator.Allocate(L"foo.txt", L"C:\\photos", 1, MAX_PATH, result, numberUsed));
+            Assert::AreEqual(std::wstring(L"foo (3).txt"), result);
+            Assert::IsTrue(allocator.Allocate(L"Foo.txt", L"C:\\photos", 1, MAX_PATH, result, numberUsed));
+            Assert::AreEqual(std::wstring(L"Foo (5).txt"), result);
+            Assert::IsTrue(numberUsed == 5);
+            Assert::IsTrue(allocator.Allocate(L"foo (9).txt", L"c:\\PHOTOS", 1, MAX_PATH, result, numberUsed));
+            Assert::AreEqual(std::wstring(L"foo (6).txt"), result);
+            Assert::AreEqual(1, listed);
+        }
+
+        TEST_METHOD(KeepsCurrentNamesOfItems)
+        {
+            // The directory lists the items being renamed, "photo (1).jpg" and "photo (2).jpg", which keep their
+            // numbers when enumerated as "photo.jpg" again
+            CUniqueNameAllocator allocator([](const std::wstring&, std::vector<std::wstring>& names) {
+                names = { L"photo (1).jpg", L"photo (2).jpg", L"photo (4).jpg" };
+            });
+            std::wstring result;
+            unsigned long numberUsed = 0;
+
+            Assert::IsTrue(allocator.Allocate(L"photo.jpg", L"C:\\photos", 1, MAX_PATH, result, numberUsed, L"PHOTO (1).JPG"));
+            Assert::AreEqual(std::wstring(L"photo (1).jpg"), result);
+            Assert::IsTrue(allocator.Allocate(L"photo.jpg", L"C:\\photos", 2, MAX_PATH, result, numberUsed, L"photo (2).jpg"));
+            Assert::AreEqual(std::wstring(L"photo (2).jpg"), result);
+
+            // Names of other items and names handed out stay taken
+            Assert::IsTrue(allocator.Allocate(L"photo.jpg", L"C:\\photos", 3, MAX_PATH, result, numberUsed, L"other.jpg"));
+            Assert::AreEqual(std::wstring(L"photo (3).jpg"), result);
+            Assert::IsTrue(allocator.Allocate(L"photo.jpg", L"C:\\photos", 1, MAX_PATH, result, numberUsed, L"photo (1).jpg"));
+            Assert::AreEqual(std::wstring(L"photo (5).jpg"), result);
+        }
+
+        TEST_METHOD(FailsIfNoNumberFits)
+        {
+            CUniqueNameAllocator allocator([](const std::wstring&, std::vector<std::wstring>& names) {
+                for (int i = 1; i < 10; i++)
+                {
+                    names.push_back(L"foo (" + std::to_wstring(i) + L")");
+                }
+            });
+            std::wstring result;
+            unsigned long numberUsed = 0;
+
+            // Room for a single digit in "C:\\a\\foo (n)"
+            Assert::IsFalse(allocator.Allocate(L"foo", L"C:\\a", 1, 13, result, numberUsed));
+            Assert::IsTrue(result.empty());
+            Assert::IsTrue(allocator.Allocate(L"foo", L"C:\\a", 1, 14, result, numberUsed));
+            Assert::AreEqual(std::wstring(L"foo (10)"), result);
+            Assert::IsFalse(allocator.Allocate(L"foo", L"C:\\a", 1, 10, result, numberUsed));
+        }
+
+        TEST_METHOD(AllocateMatchesReferenceImplementation)
+        {
+            const wchar_t* pieces[] = { L"foo", L"Foo", L" ", L"(", L")", L"(1)", L"(12)", L".", L".txt", L"x" };
+            std::mt19937 random(42);
+
+            for (int i = 0; i < 200; i++)
+            {
+                std::vector<std::wstring> existing;
+                std::set<std::wstring> taken;
+                for (int j = random() % 30; j > 0; j--)
+                {
+                    std::wstring name = (random() % 2 ? L"foo (" : L"Foo (") + std::to_wstring(random() % 40) + (random() % 2 ? L").txt" : L")");
+                    existing.push_back(name);
+                    taken.insert(ToUpper(name));
+                }
+
+                CUniqueNameAllocator allocator([&](const std::wstring&, std::vector<std::wstring>& names) { names = existing; });
+                std::wstring result;
+                std::wstring expected;
+                unsigned long numberUsed = 0;
+                for (unsigned long item = 1; item < 60; item++)
+                {
+                    std::wstring nameTemplate;
+                    for (int k = 1 + random() % 4; k > 0; k--)
+                    {
+                        nameTemplate += pieces[random() % ARRAYSIZE(pieces)];
+                    }
+                    const unsigned long minNumber = random() % 3 == 0 ? 1 : item;
+
+                    const bool expectedAllocated = ReferenceEnumerate(nameTemplate, minNumber, taken, expected);
+                    Assert::AreEqual(expectedAllocated, allocator.Allocate(nameTemplate, L"C:\\a", minNumber, MAX_PATH, result, numberUsed));
+                    if (expectedAllocated)
+                    {
+                        Assert::AreEqual(expected, result);
+                    }
+                }
+            }
+        }
+    };
+}
@@ -1,5 +1,8 @@
 #include "pch.h"
 #include "centralized_kb_hook.h"
+#include <array>
+#include <atomic>
+#include <memory>
 #include <common/debug_control.h>
 #include <common/utils/winapi_error.h>
 #include <common/logger/logger.h>
@@ -7,11 +10,13 @@
 
 namespace CentralizedKeyboardHook
 {
+    using Action = std::shared_ptr<const std::function<bool()>>;
+
     struct HotkeyDescriptor
     {
         Hotkey hotkey;
         std::wstring moduleName;
-        std::function<bool()> action;
+        Action action;
 
         bool operator<(const HotkeyDescriptor& other) const
         {
@@ -19,8 +24,34 @@ namespace CentralizedKeyboardHook
         };
     };
 
+    // Immutable snapshot of the registered hotkeys, indexed by modifiers and key code.
+    // A new table is published whenever the hotkeys change, so the hook can look up an action without locking or copying it.
+    struct HotkeyTable
+    {
+        static constexpr size_t ModifierCombinations = 16;
+        static constexpr size_t KeyCount = 256;
+
+        // Position in actions plus one for every modifiers and key pair, 0 if no hotkey is registered for it
+        std::array<uint16_t, ModifierCombinations * KeyCount> slots{};
+        // Bit set of the modifier combinations registered for each key, to skip reading the modifier state for any other key
+        std::array<uint16_t, KeyCount> registeredModifiers{};
+        std::vector<Action> actions;
+
+        static size_t GetModifiers(const Hotkey& hotkey)
+        {
+            return (hotkey.win ? 1 : 0) | (hotkey.ctrl ? 2 : 0) | (hotkey.shift ? 4 : 0) | (hotkey.alt ? 8 : 0);
+        }
+
+        const Action* Find(const Hotkey& hotkey) const
+        {
+            const auto slot = slots[GetModifiers(hotkey) * KeyCount + hotkey.key];
+            return slot != 0 ? &actions[slot - 1] : nullptr;
+        }
+    };
+
     std::multiset<HotkeyDescriptor> hotkeyDescriptors;
     std::mutex mutex;
+    std::atomic<std::shared_ptr<const HotkeyTable>> hotkeyTable{ std::make_shared<const HotkeyTable>() };
     HHOOK hHook{};
 
     // To store information about handling pressed keys.
@@ -28,7 +59,7 @@ namespace CentralizedKeyboardHook
     {
         DWORD virtualKey; // Virtual Key code of the key we're keeping track of.
         std::wstring moduleName;
-        std::function<bool()> action;
+        Action action;
         UINT_PTR idTimer; // Timer ID for calling SET_TIMER with.
         UINT millisecondsToPress; // How much time the key must be pressed.
         bool operator<(const PressedKeyDescriptor& other) const
@@ -62,19 +93,22 @@ namespace CentralizedKeyboardHook
         UINT_PTR idTimer,
         DWORD dwTime)
     {
-        std::multiset<PressedKeyDescriptor> copy;
+        std::vector<Action> actions;
         {
-            // Make a copy, to look for the action to call.
+            // Only take the actions to call, which are invoked without holding the lock.
             std::unique_lock lock{ pressedKeyMutex };
-            copy = pressedKeyDescriptors;
-        }
-        for (const auto& it : copy)
-        {
-            if (it.idTimer == idTimer)
+            for (const auto& it : pressedKeyDescriptors)
             {
-                it.action();
+                if (it.idTimer == idTimer)
+                {
+                    actions.push_back(it.action);
+                }
             }
         }
+        for (const auto& action : actions)
+        {
+            (*action)();
+        }
 
         KillTimer(hwnd, idTimer);
     }
@@ -137,29 +171,25 @@ namespace CentralizedKeyboardHook
             return CallNextHookEx(hHook, nCode, wParam, lParam);
         }
 
+        // The snapshot keeps the action alive while it runs, even if the module hotkeys are cleared meanwhile
+        const auto table = hotkeyTable.load(std::memory_order_acquire);
+        const auto key = static_cast<unsigned char>(keyPressInfo.vkCode);
+        if (table->registeredModifiers[key] == 0)
+        {
+            return CallNextHookEx(hHook, nCode, wParam, lParam);
+        }
+
         Hotkey hotkey{
             .win = (GetAsyncKeyState(VK_LWIN) & 0x8000) || (GetAsyncKeyState(VK_RWIN) & 0x8000),
             .ctrl = static_cast<bool>(GetAsyncKeyState(VK_CONTROL) & 0x8000),
             .shift = static_cast<bool>(GetAsyncKeyState(VK_SHIFT) & 0x8000),
             .alt = static_cast<bool>(GetAsyncKeyState(VK_MENU) & 0x8000),
-            .key = static_cast<unsigned char>(keyPressInfo.vkCode)
+            .key = key
         };
 
-        std::function<bool()> action;
-        {
-            // Hold the lock for the shortest possible duration
-            std::unique_lock lock{ mutex };
-            HotkeyDescriptor dummy{ .hotkey = hotkey };
-            auto it = hotkeyDescriptors.find(dummy);
-            if (it != hotkeyDescriptors.end())
-            {
-                action = it->action;
-            }
-        }
-
-        if (action)
+        if (const auto action = table->Find(hotkey))
         {
-            if (action())
+            if ((**action)())
             {
                 // After invoking the hotkey send a dummy key to prevent Start Menu from activating
                 INPUT dummyEvent[1] = {};
@@ -176,11 +206,31 @@ namespace CentralizedKeyboardHook
         return CallNextHookEx(hHook, nCode, wParam, lParam);
     }
 
+    // Build the lookup table from the registered hotkeys and publish it to the hook. Must be called with the mutex held.
+    void PublishHotkeyTable()
+    {
+        auto table = std::make_shared<HotkeyTable>();
+        for (const auto& it : hotkeyDescriptors)
+        {
+            // Keep the first registered action if several modules use the same hotkey
+            auto& slot = table->slots[HotkeyTable::GetModifiers(it.hotkey) * HotkeyTable::KeyCount + it.hotkey.key];
+            if (slot == 0)
+            {
+                table->actions.push_back(it.action);
+                slot = static_cast<uint16_t>(table->actions.size());
+                table->registeredModifiers[it.hotkey.key] |= static_cast<uint16_t>(1 << HotkeyTable::GetModifiers(it.hotkey));
+            }
+        }
+
+        hotkeyTable.store(std::move(table), std::memory_order_release);
+    }
+
     void SetHotkeyAction(const std::wstring& moduleName, const Hotkey& hotkey, std::function<bool()>&& action) noexcept
     {
         Logger::trace(L"Register hotkey action for {}", moduleName);
         std::unique_lock lock{ mutex };
-        hotkeyDescriptors.insert({ .hotkey = hotkey, .moduleName = moduleName, .action = std::move(action) });
+        hotkeyDescriptors.insert({ .hotkey = hotkey, .moduleName = moduleName, .action = std::make_shared<const std::function<bool()>>(std::move(action)) });
+        PublishHotkeyTable();
     }
 
     void AddPressedKeyAction(const std::wstring& moduleName, const DWORD vk, const UINT milliseconds, std::function<bool()>&& action) noexcept
@@ -191,7 +241,7 @@ namespace CentralizedKeyboardHook
         const UINT lowerId = vk & 0xFFFF; // The key to press can be the lower ID.
         const UINT timerId = upperId << 16 | lowerId;
         std::unique_lock lock{ pressedKeyMutex };
-        pressedKeyDescriptors.insert({ .virtualKey = vk, .moduleName = moduleName, .action = std::move(action), .idTimer = timerId, .millisecondsToPress = milliseconds });
+        pressedKeyDescriptors.insert({ .virtualKey = vk, .moduleName = moduleName, .action = std::make_shared<const std::function<bool()>>(std::move(action)), .idTimer = timerId, .millisecondsToPress = milliseconds });
     }
 
     void ClearModuleHotkeys(const std::wstring& moduleName) noexcept
@@ -211,6 +261,7 @@ namespace CentralizedKeyboardHook
                     ++it;
                 }
             }
+            PublishHotkeyTable();
         }
         {
             std::unique_lock lock{ pressedKeyMutex };
@@ -31,12 +31,32 @@ PowertoyModule load_powertoy(const std::wstring_view filename)
 
 json::JsonObject PowertoyModule::json_config() const
 {
-    int size = 0;
-    pt_module->get_config(nullptr, &size);
-    std::wstring result;
-    result.resize(size - 1);
-    pt_module->get_config(result.data(), &size);
-    return json::JsonObject::Parse(result);
+    int size = static_cast<int>(config_buffer.size()) + 1;
+    if (config_buffer.empty() || !pt_module->get_config(config_buffer.data(), &size))
+    {
+        config_buffer.resize(size - 1);
+        pt_module->get_config(config_buffer.data(), &size);
+    }
+
+    const std::wstring_view result{ config_buffer.c_str() };
+    if (!config_json || result != config_string)
+    {
+        config_json = json::JsonObject::Parse(result);
+        config_string = result;
+    }
+    return config_json;
+}
+
+bool PowertoyModule::set_config(const std::wstring& settings)
+{
+    if (settings == last_settings)
+    {
+        return false;
+    }
+
+    pt_module->set_config(settings.c_str());
+    last_settings = settings;
+    return true;
 }
 
 PowertoyModule::PowertoyModule(PowertoyModuleIface* pt_module, HMODULE handle) :
@@ -40,6 +40,10 @@ public:
 
     json::JsonObject json_config() const;
 
+    // Passes the settings to the module, unless they are the same as the last ones it was given.
+    // Returns false if the module was skipped.
+    bool set_config(const std::wstring& settings);
+
     void update_hotkeys();
 
     void UpdateHotkeyEx();
@@ -47,6 +51,13 @@ public:
 private:
     std::unique_ptr<HMODULE, PowertoyModuleDLLDeleter> handle;
     std::unique_ptr<PowertoyModuleIface, PowertoyModuleDeleter> pt_module;
+
+    // Buffer for get_config, kept at the size of the last config so it can usually be filled in a single call
+    mutable std::wstring config_buffer;
+    // Last config returned by the module and its parsed form, to skip parsing it again while it doesn't change
+    mutable std::wstring config_string;
+    mutable json::JsonObject config_json{ nullptr };
+    std::wstring last_settings;
 };
 
 PowertoyModule load_powertoy(const std::wstring_view filename);
@@ -118,9 +118,8 @@ std::optional<std::wstring> dispatch_json_action_to_module(const json::JsonObjec
 void send_json_config_to_module(const std::wstring& module_key, const std::wstring& settings)
 {
     auto moduleIt = modules().find(module_key);
-    if (moduleIt != modules().end())
+    if (moduleIt != modules().end() && moduleIt->second.set_config(settings))
     {
-        moduleIt->second->set_config(settings.c_str());
         moduleIt->second.update_hotkeys();
         moduleIt->second.UpdateHotkeyEx();
     }